@@ -0,0 +1,147 @@
+// alarm_flog.c
+#include "alarm_flog.h"
+#include <string.h>
+#include "telemetry_proto.h"    // tp_crc16
+
+#define FLOG_MAGIC 0x31474c41u  // "ALG1"
+#define FLOG_ERASED 0xFFFFFFFFu
+#define FLOG_EVENT_CRC_LEN offsetof(alarm_event_t, crc)
+
+// Cabecera de sector: ocupa el primer hueco de 16 bytes
+typedef struct {
+    uint32_t magic;
+    uint32_t counter;       // Crece en cada sector preparado; el mayor es el más reciente
+    uint32_t reserved;
+    uint32_t crc;           // CRC16 de magic + counter
+} flog_header_t;
+
+_Static_assert(sizeof(alarm_event_t) == 16, "alarm_event_t debe ocupar 16 bytes");
+_Static_assert(sizeof(flog_header_t) == sizeof(alarm_event_t), "la cabecera ocupa un hueco");
+
+static uint32_t slots_per_sector(const alarm_flog_t *log) {
+    return log->io.sector_size / sizeof(alarm_event_t);
+}
+
+static uint32_t slot_offset(const alarm_flog_t *log, uint32_t sector, uint32_t slot) {
+    return sector * log->io.sector_size + slot * (uint32_t)sizeof(alarm_event_t);
+}
+
+static bool read_header(alarm_flog_t *log, uint32_t sector, uint32_t *counter) {
+    flog_header_t hdr;
+    if (!log->io.read(log->io.ctx, slot_offset(log, sector, 0), &hdr, sizeof(hdr))) {
+        log->stats.io_errors++;
+        return false;
+    }
+    if (hdr.magic != FLOG_MAGIC || hdr.crc != tp_crc16((const uint8_t *)&hdr, 8)) {
+        return false;
+    }
+    *counter = hdr.counter;
+    return true;
+}
+
+// Borra el sector y escribe su cabecera: pasa a ser el sector en uso
+static bool prepare_sector(alarm_flog_t *log, uint32_t sector, uint32_t counter) {
+    flog_header_t hdr = { .magic = FLOG_MAGIC, .counter = counter, .reserved = FLOG_ERASED };
+    hdr.crc = tp_crc16((const uint8_t *)&hdr, 8);
+
+    if (!log->io.erase(log->io.ctx, slot_offset(log, sector, 0), log->io.sector_size) ||
+        !log->io.write(log->io.ctx, slot_offset(log, sector, 0), &hdr, sizeof(hdr))) {
+        log->stats.io_errors++;
+        return false;
+    }
+    log->stats.erases++;
+    log->head_sector = sector;
+    log->head_slot = 1;
+    log->head_counter = counter;
+    return true;
+}
+
+bool alarm_flog_mount(alarm_flog_t *log, const flash_io_t *io) {
+    bool found = false;
+
+    memset(log, 0, sizeof(*log));
+    log->io = *io;
+    if (io->sector_count < 2 || io->sector_size < 2 * sizeof(alarm_event_t) ||
+        io->sector_size % sizeof(alarm_event_t) != 0) {
+        return false;
+    }
+
+    for (uint32_t s = 0; s < io->sector_count; s++) {
+        uint32_t counter;
+        // Comparación circular: el contador puede dar la vuelta
+        if (read_header(log, s, &counter) && (!found || (int32_t)(counter - log->head_counter) > 0)) {
+            log->head_sector = s;
+            log->head_counter = counter;
+            found = true;
+        }
+    }
+    if (!found) {
+        return prepare_sector(log, 0, 1);
+    }
+
+    // Primer hueco borrado del sector en uso. Un registro a medias (CRC malo)
+    // ocupa su hueco: no se puede reescribir sin borrar el sector.
+    uint32_t n = slots_per_sector(log);
+    for (log->head_slot = 1; log->head_slot < n; log->head_slot++) {
+        uint32_t first;
+        if (!io->read(io->ctx, slot_offset(log, log->head_sector, log->head_slot), &first, sizeof(first))) {
+            log->stats.io_errors++;
+            return false;
+        }
+        if (first == FLOG_ERASED) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool alarm_flog_append(alarm_flog_t *log, const alarm_event_t *event) {
+    alarm_event_t rec = *event;
+
+    if (log->head_slot >= slots_per_sector(log) &&
+        !prepare_sector(log, (log->head_sector + 1) % log->io.sector_count, log->head_counter + 1)) {
+        return false;
+    }
+    rec.crc = tp_crc16((const uint8_t *)&rec, FLOG_EVENT_CRC_LEN);
+    if (!log->io.write(log->io.ctx, slot_offset(log, log->head_sector, log->head_slot), &rec, sizeof(rec))) {
+        log->stats.io_errors++;
+        // El hueco puede haber quedado a medias: no reutilizarlo
+        log->head_slot++;
+        return false;
+    }
+    log->head_slot++;
+    log->stats.appended++;
+    return true;
+}
+
+uint32_t alarm_flog_for_each(alarm_flog_t *log, alarm_flog_cb_t cb, void *ctx) {
+    uint32_t count = 0;
+    uint32_t n = slots_per_sector(log);
+
+    // Del sector siguiente al actual (el más antiguo) hasta el actual
+    for (uint32_t k = 1; k <= log->io.sector_count; k++) {
+        uint32_t sector = (log->head_sector + k) % log->io.sector_count;
+        uint32_t counter;
+        if (!read_header(log, sector, &counter)) {
+            continue;
+        }
+        uint32_t end = sector == log->head_sector ? log->head_slot : n;
+        for (uint32_t slot = 1; slot < end; slot++) {
+            alarm_event_t rec;
+            if (!log->io.read(log->io.ctx, slot_offset(log, sector, slot), &rec, sizeof(rec))) {
+                log->stats.io_errors++;
+                continue;
+            }
+            if (rec.seq == FLOG_ERASED) {
+                break;
+            }
+            if (rec.crc != tp_crc16((const uint8_t *)&rec, FLOG_EVENT_CRC_LEN)) {
+                log->stats.corrupt++;
+                continue;
+            }
+            cb(&rec, ctx);
+            count++;
+        }
+    }
+    return count;
+}
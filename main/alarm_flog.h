@@ -0,0 +1,50 @@
+// alarm_flog.h
+#ifndef ALARM_FLOG_H
+#define ALARM_FLOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "alarm_history.h"
+#include "flash_io.h"
+
+// Log de eventos de alarma en flash, sólo de añadir. Los sectores se usan en
+// círculo: cada uno empieza con una cabecera con un contador creciente y
+// después registros alarm_event_t de 16 bytes protegidos por CRC. Al llenarse
+// uno se borra el siguiente (el más antiguo), así que todos los sectores se
+// borran por igual. Sin dependencias de ESP-IDF: el acceso a flash va por io
+// (sectores de tamaño múltiplo de 16, al menos 2).
+
+typedef struct {
+    uint32_t appended;      // Registros escritos en este arranque
+    uint32_t erases;        // Sectores borrados en este arranque
+    uint32_t corrupt;       // Registros con CRC incorrecto encontrados al leer
+    uint32_t io_errors;     // Fallos de lectura/escritura/borrado
+} alarm_flog_stats_t;
+
+typedef struct {
+    flash_io_t io;
+    uint32_t head_sector;   // Sector en uso
+    uint32_t head_slot;     // Siguiente hueco libre en head_sector
+    uint32_t head_counter;  // Contador de la cabecera de head_sector
+    alarm_flog_stats_t stats;
+} alarm_flog_t;
+
+typedef void (*alarm_flog_cb_t)(const alarm_event_t *event, void *ctx);
+
+// Busca el sector más reciente y su primer hueco libre; si no hay ninguno
+// válido, prepara el primero. false si falla la flash.
+bool alarm_flog_mount(alarm_flog_t *log, const flash_io_t *io);
+
+// Añade un registro (calcula su CRC); borra el sector más antiguo si hace falta
+bool alarm_flog_append(alarm_flog_t *log, const alarm_event_t *event);
+
+// Recorre los registros válidos del más antiguo al más reciente; devuelve cuántos
+uint32_t alarm_flog_for_each(alarm_flog_t *log, alarm_flog_cb_t cb, void *ctx);
+
+// Registros que caben en total (uno de cada sector es la cabecera)
+static inline uint32_t alarm_flog_capacity(const alarm_flog_t *log) {
+    return (log->io.sector_size / sizeof(alarm_event_t) - 1) * log->io.sector_count;
+}
+
+#endif // ALARM_FLOG_H
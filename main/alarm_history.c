@@ -0,0 +1,55 @@
+// alarm_history.c
+#include "alarm_history.h"
+#include <string.h>
+
+bool alarm_history_init(alarm_history_t *h, alarm_history_slot_t *slots, uint32_t size) {
+    if (slots == NULL || size < 2 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    h->slots = slots;
+    h->mask = size - 1;
+    for (uint32_t i = 0; i < size; i++) {
+        atomic_init(&slots[i].seq, 0);
+    }
+    atomic_init(&h->head, 0);
+    return true;
+}
+
+static void publish(alarm_history_t *h, const alarm_event_t *event) {
+    alarm_history_slot_t *slot = &h->slots[event->seq & h->mask];
+
+    // Igual que el ring de trazas: seq = 0 invalida el hueco mientras se copia
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&slot->event, event, sizeof(*event));
+    atomic_store_explicit(&slot->seq, event->seq, memory_order_release);
+    atomic_store_explicit(&h->head, event->seq, memory_order_release);
+}
+
+uint32_t alarm_history_append(alarm_history_t *h, alarm_event_t *event) {
+    event->seq = atomic_load_explicit(&h->head, memory_order_relaxed) + 1;
+    publish(h, event);
+    return event->seq;
+}
+
+bool alarm_history_restore(alarm_history_t *h, const alarm_event_t *event) {
+    if (event->seq <= atomic_load_explicit(&h->head, memory_order_relaxed)) {
+        return false;
+    }
+    publish(h, event);
+    return true;
+}
+
+bool alarm_history_get(const alarm_history_t *h, uint32_t seq, alarm_event_t *out) {
+    alarm_history_slot_t *slot = &h->slots[seq & h->mask];
+
+    if (seq == 0 || seq > alarm_history_head(h)) {
+        return false;
+    }
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq) {
+        return false;
+    }
+    memcpy(out, &slot->event, sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq;
+}
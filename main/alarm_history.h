@@ -0,0 +1,65 @@
+// alarm_history.h
+#ifndef ALARM_HISTORY_H
+#define ALARM_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Historial de flancos de alarma en un ring de un productor (tarea parser) y
+// lectores sin bloqueo (LVGL, tarea de persistencia). Cada evento lleva un
+// número de secuencia global que también es su posición en el ring; un lector
+// detecta por ella si el hueco se está escribiendo o ya se sobrescribió.
+// Sin dependencias de ESP-IDF: el llamador aporta la memoria (PSRAM en el firmware).
+
+typedef enum {
+    ALARM_EDGE_CLEAR = 0,   // La alarma dejó de estar activa
+    ALARM_EDGE_RAISE = 1,   // La alarma se activó
+    ALARM_EDGE_BOOT = 2,    // Marca de arranque (bit sin significado)
+} alarm_edge_t;
+
+// 16 bytes: mismo formato en RAM y en flash
+typedef struct {
+    uint32_t seq;           // 1, 2, ... continuo entre arranques
+    uint32_t uptime_ms;     // Desde el arranque en que ocurrió
+    uint16_t boot;          // Número de arranque
+    uint16_t bit;           // Alarma 0..ALARM_MAX-1
+    uint8_t edge;           // alarm_edge_t
+    uint8_t reserved;
+    uint16_t crc;           // CRC16 de los 14 bytes anteriores (sólo se usa en flash)
+} alarm_event_t;
+
+typedef struct {
+    atomic_uint seq;        // 0 mientras se escribe; event.seq cuando es legible
+    alarm_event_t event;
+} alarm_history_slot_t;
+
+typedef struct {
+    alarm_history_slot_t *slots;
+    uint32_t mask;          // size - 1
+    atomic_uint head;       // Último seq publicado (0 = vacío)
+} alarm_history_t;
+
+// size debe ser potencia de 2; slots lo aporta el llamador
+bool alarm_history_init(alarm_history_t *h, alarm_history_slot_t *slots, uint32_t size);
+
+// Productor: asigna el siguiente seq, publica el evento y devuelve el seq
+uint32_t alarm_history_append(alarm_history_t *h, alarm_event_t *event);
+
+// Productor, al arrancar: repone un evento ya numerado (seq mayor que el último)
+bool alarm_history_restore(alarm_history_t *h, const alarm_event_t *event);
+
+// Lector: copia el evento seq; false si no existe, se sobrescribió o se está escribiendo
+bool alarm_history_get(const alarm_history_t *h, uint32_t seq, alarm_event_t *out);
+
+static inline uint32_t alarm_history_head(const alarm_history_t *h) {
+    return atomic_load_explicit(&((alarm_history_t *)h)->head, memory_order_acquire);
+}
+
+// seq más antiguo que aún puede estar en el ring (head + 1 si está vacío)
+static inline uint32_t alarm_history_oldest(const alarm_history_t *h) {
+    uint32_t head = alarm_history_head(h);
+    return head > h->mask ? head - h->mask : 1;
+}
+
+#endif // ALARM_HISTORY_H
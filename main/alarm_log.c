@@ -0,0 +1,166 @@
+#include "alarm_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "uart_config.h"
+#include "trace.h"
+
+static alarm_history_t history;
+static bool history_ready = false;
+
+static const esp_partition_t *partition = NULL;
+static alarm_flog_t flog;
+static bool flog_ready = false;
+
+static TaskHandle_t log_task_handle = NULL;
+static uint32_t persisted_seq;      // Último seq guardado en flash (sólo la tarea de log)
+static alarm_log_stats_t stats;
+
+static bool part_read(void *ctx, uint32_t offset, void *buf, size_t len) {
+    return esp_partition_read(ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool part_write(void *ctx, uint32_t offset, const void *buf, size_t len) {
+    return esp_partition_write(ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool part_erase(void *ctx, uint32_t offset, size_t len) {
+    return esp_partition_erase_range(ctx, offset, len) == ESP_OK;
+}
+
+static void restore_cb(const alarm_event_t *event, void *ctx) {
+    if (alarm_history_restore(&history, event)) {
+        stats.restored++;
+    }
+    if (event->boot >= stats.boot) {
+        stats.boot = event->boot;
+    }
+}
+
+static void mount_partition(void) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ALARM_LOG_PARTITION_SUBTYPE,
+                                         ALARM_LOG_PARTITION);
+    if (partition == NULL) {
+        ESP_LOGW("ALARM_LOG", "Sin partición '%s': historial sólo en RAM", ALARM_LOG_PARTITION);
+        return;
+    }
+    flash_io_t io = {
+        .read = part_read,
+        .write = part_write,
+        .erase = part_erase,
+        .ctx = (void *)partition,
+        .sector_size = partition->erase_size,
+        .sector_count = partition->size / partition->erase_size,
+    };
+    flog_ready = alarm_flog_mount(&flog, &io);
+    if (!flog_ready) {
+        ESP_LOGE("ALARM_LOG", "No se pudo montar la partición '%s'", ALARM_LOG_PARTITION);
+    }
+}
+
+void alarm_log_init(void) {
+    alarm_history_slot_t *slots = heap_caps_calloc(ALARM_HISTORY_SIZE, sizeof(alarm_history_slot_t),
+                                                   MALLOC_CAP_SPIRAM);
+    if (!alarm_history_init(&history, slots, ALARM_HISTORY_SIZE)) {
+        ESP_LOGE("ALARM_LOG", "No se pudo reservar el historial de alarmas");
+        heap_caps_free(slots);
+        return;
+    }
+    history_ready = true;
+
+    mount_partition();
+    if (flog_ready) {
+        alarm_flog_for_each(&flog, restore_cb, NULL);
+    }
+    persisted_seq = alarm_history_head(&history);
+    stats.boot++;
+
+    alarm_event_t marker = {
+        .uptime_ms = (uint32_t)(esp_timer_get_time() / 1000),
+        .boot = stats.boot,
+        .edge = ALARM_EDGE_BOOT,
+    };
+    alarm_history_append(&history, &marker);
+    ESP_LOGI("ALARM_LOG", "Arranque %u: %lu eventos recuperados, %lu en flash como máximo",
+             stats.boot, (unsigned long)stats.restored,
+             (unsigned long)(flog_ready ? alarm_flog_capacity(&flog) : 0));
+}
+
+void alarm_log_record_changes(const alarm_set_t *before, const alarm_set_t *after) {
+    if (!history_ready) {
+        return;
+    }
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    bool any = false;
+
+    for (int w = 0; w < ALARM_WORDS; w++) {
+        for (uint32_t diff = before->words[w] ^ after->words[w]; diff != 0; diff &= diff - 1) {
+            unsigned bit = (unsigned)(w * 32 + __builtin_ctz(diff));
+            alarm_event_t event = {
+                .uptime_ms = now_ms,
+                .boot = stats.boot,
+                .bit = (uint16_t)bit,
+                .edge = alarm_is_set(after, bit) ? ALARM_EDGE_RAISE : ALARM_EDGE_CLEAR,
+            };
+            alarm_history_append(&history, &event);
+            TRACE(ALARM_EDGE, bit, event.edge, event.seq);
+            stats.recorded++;
+            any = true;
+        }
+    }
+    // Sin esperas: la escritura en flash la hace alarm_log_task
+    if (any && log_task_handle != NULL) {
+        xTaskNotifyGive(log_task_handle);
+    }
+}
+
+// Guarda en flash todo lo que haya en el ring desde la última vez
+static void persist_pending(void) {
+    uint32_t head = alarm_history_head(&history);
+
+    while (persisted_seq != head) {
+        uint32_t seq = persisted_seq + 1;
+        alarm_event_t event;
+        if (!alarm_history_get(&history, seq, &event)) {
+            // Sobrescrito antes de guardarlo: saltar a lo más antiguo que queda
+            uint32_t oldest = alarm_history_oldest(&history);
+            uint32_t skip = oldest > seq ? oldest - seq : 1;
+            stats.lost += skip;
+            persisted_seq += skip;
+            continue;
+        }
+        if (!alarm_flog_append(&flog, &event)) {
+            TRACE(ALARM_LOG_ERR, seq, flog.stats.io_errors, 0);
+            break; // Reintentar en la siguiente pasada
+        }
+        persisted_seq = seq;
+        stats.persisted++;
+    }
+}
+
+void alarm_log_task(void *arg) {
+    log_task_handle = xTaskGetCurrentTaskHandle();
+
+    while (true) {
+        if (history_ready && flog_ready) {
+            persist_pending();
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Agrupar los flancos de una ráfaga en una sola pasada por la flash
+        vTaskDelay(pdMS_TO_TICKS(ALARM_LOG_FLUSH_MS));
+    }
+}
+
+const alarm_history_t *alarm_log_history(void) {
+    return history_ready ? &history : NULL;
+}
+
+void alarm_log_get_stats(alarm_log_stats_t *out) {
+    if (out != NULL) {
+        *out = stats;
+        out->flash = flog.stats;
+    }
+}
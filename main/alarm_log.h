@@ -0,0 +1,39 @@
+// alarm_log.h
+#ifndef ALARM_LOG_H
+#define ALARM_LOG_H
+
+#include <stdint.h>
+#include "alarms.h"
+#include "alarm_history.h"
+#include "alarm_flog.h"
+
+// Historial persistente de alarmas: los flancos se anotan en un ring en PSRAM
+// sin bloquear (tarea parser) y alarm_log_task los pasa después a la partición
+// ALARM_LOG_PARTITION. Al arrancar se recupera el historial guardado y se anota
+// una marca de arranque.
+
+typedef struct {
+    uint32_t recorded;      // Flancos anotados en este arranque
+    uint32_t restored;      // Eventos recuperados de flash al arrancar
+    uint32_t persisted;     // Eventos escritos en flash en este arranque
+    uint32_t lost;          // Eventos sobrescritos en el ring antes de guardarlos
+    uint16_t boot;          // Número de este arranque
+    alarm_flog_stats_t flash;
+} alarm_log_stats_t;
+
+// Reserva el ring, monta la partición y recupera el historial. Llamar antes
+// de crear las tareas UART (la tarea parser es el único productor).
+void alarm_log_init(void);
+
+// Tarea de baja prioridad que guarda en flash los eventos nuevos
+void alarm_log_task(void *arg);
+
+// Productor (tarea parser): anota un flanco por cada bit distinto entre before y after
+void alarm_log_record_changes(const alarm_set_t *before, const alarm_set_t *after);
+
+// Historial para los lectores; NULL si no se pudo reservar el ring
+const alarm_history_t *alarm_log_history(void);
+
+void alarm_log_get_stats(alarm_log_stats_t *out);
+
+#endif // ALARM_LOG_H
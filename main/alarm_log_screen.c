@@ -0,0 +1,228 @@
+#include "alarm_log_screen.h"
+#include <string.h>
+#include "esp_log.h"
+#include "uart_config.h"
+#include "alarm_log.h"
+#include "alarms.h"
+#include "ui_update.h"
+#include "ui_format.h"
+
+// Lista virtual: sólo existen ALARM_LOG_ROWS etiquetas, que se recolocan y
+// reescriben al desplazarse; un objeto espaciador da al contenedor la altura
+// de todo el historial para que el scroll sea el de una lista completa.
+#define ALARM_LOG_ROWS 14       // Filas visibles + margen para el desplazamiento
+#define ALARM_LOG_ROW_H 34
+
+static lv_obj_t *log_screen;
+static lv_obj_t *log_list;
+static lv_obj_t *log_spacer;
+static lv_obj_t *log_count_label;
+static lv_obj_t *rows[ALARM_LOG_ROWS];
+static int8_t row_kind[ALARM_LOG_ROWS];    // alarm_edge_t mostrado (color), -1 = vacía
+
+static uint32_t shown_head;     // seq más reciente en la lista
+static uint32_t shown_count;    // Entradas de la lista
+
+static const uint32_t edge_colors[] = {
+    [ALARM_EDGE_CLEAR] = 0x2E8B57,  // Verde
+    [ALARM_EDGE_RAISE] = 0xD32F2F,  // Rojo
+    [ALARM_EDGE_BOOT] = 0x606060,   // Gris
+};
+
+static size_t put_text(char *buf, size_t size, size_t len, const char *text) {
+    while (*text != '\0' && len + 1 < size) {
+        buf[len++] = *text++;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+// Cifras fijas con ceros a la izquierda (width <= 3)
+static size_t put_digits(char *buf, size_t size, size_t len, uint32_t value, int width) {
+    char digits[4];
+    digits[width] = '\0';
+    for (int i = width - 1; i >= 0; i--) {
+        digits[i] = (char)('0' + value % 10);
+        value /= 10;
+    }
+    return put_text(buf, size, len, digits);
+}
+
+// "#123  A4 01:02:03.456  ON  Error 0: ..."
+static void format_event(const alarm_event_t *ev, char *buf, size_t size) {
+    uint32_t s = ev->uptime_ms / 1000;
+    char num[12];
+    size_t len = 0;
+
+    ui_fmt_int(num, sizeof(num), (int32_t)ev->seq);
+    len = put_text(buf, size, len, "#");
+    len = put_text(buf, size, len, num);
+    ui_fmt_int(num, sizeof(num), ev->boot);
+    len = put_text(buf, size, len, "  A");
+    len = put_text(buf, size, len, num);
+    len = put_text(buf, size, len, " ");
+    ui_fmt_int(num, sizeof(num), (int32_t)(s / 3600));
+    len = put_text(buf, size, len, s < 36000 ? "0" : "");
+    len = put_text(buf, size, len, num);
+    len = put_text(buf, size, len, ":");
+    len = put_digits(buf, size, len, s / 60 % 60, 2);
+    len = put_text(buf, size, len, ":");
+    len = put_digits(buf, size, len, s % 60, 2);
+    len = put_text(buf, size, len, ".");
+    len = put_digits(buf, size, len, ev->uptime_ms % 1000, 3);
+
+    if (ev->edge == ALARM_EDGE_BOOT) {
+        put_text(buf, size, len, "  --- Arranque ---");
+        return;
+    }
+    len = put_text(buf, size, len, ev->edge == ALARM_EDGE_RAISE ? "  ON   " : "  OFF  ");
+    const char *msg = alarm_message(ev->bit);
+    if (msg != NULL) {
+        put_text(buf, size, len, msg);
+    } else {
+        ui_fmt_label(buf + len, size - len, "Alarma ", ev->bit, 0, NULL);
+    }
+}
+
+// Reescribe las filas recicladas para la posición de scroll actual
+static void bind_rows(void) {
+    const alarm_history_t *history = alarm_log_history();
+    uint32_t first = (uint32_t)(lv_obj_get_scroll_y(log_list) / ALARM_LOG_ROW_H);
+    char text[96];
+
+    for (int i = 0; i < ALARM_LOG_ROWS; i++) {
+        uint32_t index = first + (uint32_t)i;   // 0 = el más reciente
+        alarm_event_t ev;
+        if (history == NULL || index >= shown_count) {
+            if (row_kind[i] != -1) {
+                lv_obj_add_flag(rows[i], LV_OBJ_FLAG_HIDDEN);
+                row_kind[i] = -1;
+            }
+            continue;
+        }
+        if (row_kind[i] == -1) {
+            lv_obj_remove_flag(rows[i], LV_OBJ_FLAG_HIDDEN);
+        }
+        lv_obj_set_y(rows[i], (int32_t)(index * ALARM_LOG_ROW_H));
+        int8_t kind = ALARM_EDGE_BOOT;
+        if (alarm_history_get(history, shown_head - index, &ev)) {
+            format_event(&ev, text, sizeof(text));
+            kind = (int8_t)ev.edge;
+        } else {
+            strcpy(text, "...");    // Sobrescrito mientras se mostraba
+        }
+        if (row_kind[i] != kind) {
+            lv_obj_set_style_text_color(rows[i], lv_color_hex(edge_colors[kind]), 0);
+            row_kind[i] = kind;
+        }
+        ui_label_set_text_if_changed(rows[i], text);
+    }
+}
+
+// Ajusta la lista a lo que hay en el historial, conservando las filas que se estaban viendo
+static bool sync_history(void) {
+    const alarm_history_t *history = alarm_log_history();
+    if (history == NULL) {
+        return false;
+    }
+    uint32_t head = alarm_history_head(history);
+    if (head == shown_head) {
+        return false;
+    }
+    uint32_t added = head - shown_head;
+    int32_t scroll_y = lv_obj_get_scroll_y(log_list);
+
+    shown_head = head;
+    shown_count = head - alarm_history_oldest(history) + 1;
+    lv_obj_set_height(log_spacer, (int32_t)(shown_count * ALARM_LOG_ROW_H));
+    // Arriba del todo se siguen viendo los más recientes; si no, no mover la vista
+    if (scroll_y > 0) {
+        lv_obj_scroll_to_y(log_list, scroll_y + (int32_t)(added * ALARM_LOG_ROW_H), LV_ANIM_OFF);
+    }
+
+    char text[32];
+    ui_fmt_label(text, sizeof(text), "Eventos: ", (int32_t)shown_count, 0, NULL);
+    ui_label_set_text_if_changed(log_count_label, text);
+    return true;
+}
+
+// Hook de ui_update: sólo trabaja con la pantalla visible y eventos nuevos
+static bool alarm_log_refresh_hook(void) {
+    if (lv_screen_active() != log_screen || !sync_history()) {
+        return false;
+    }
+    bind_rows();
+    return true;
+}
+
+static void list_scroll_cb(lv_event_t *e) {
+    bind_rows();
+}
+
+static void screen_loaded_cb(lv_event_t *e) {
+    sync_history();
+    bind_rows();
+}
+
+// Pantalla descartada (screen_manager): al recrearla se rehace la lista entera
+static void screen_delete_cb(lv_event_t *e) {
+    log_screen = NULL;
+    log_list = NULL;
+    log_spacer = NULL;
+    log_count_label = NULL;
+    memset(rows, 0, sizeof(rows));
+    shown_head = 0;
+    shown_count = 0;
+}
+
+void create_alarm_log_screen(lv_obj_t *scr) {
+    ESP_LOGI("ALARM_LOG", "Creando pantalla de historial de alarmas");
+    log_screen = scr;
+
+    // Fondo de la pantalla
+    lv_obj_t *bg = lv_obj_create(scr);
+    lv_obj_set_size(bg, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_style_bg_color(bg, lv_color_hex(0xFFFFFF), LV_PART_MAIN); // Blanco
+    lv_obj_set_style_bg_opa(bg, LV_OPA_COVER, LV_PART_MAIN);
+
+    // Título y número de eventos
+    lv_obj_t *title = lv_label_create(scr);
+    lv_label_set_text(title, "Historial de alarmas");
+    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
+    lv_obj_align(title, LV_ALIGN_TOP_LEFT, 20, 100);
+
+    log_count_label = lv_label_create(scr);
+    lv_label_set_text(log_count_label, "Eventos: 0");
+    lv_obj_set_style_text_font(log_count_label, &lv_font_montserrat_20, 0);
+    lv_obj_align(log_count_label, LV_ALIGN_TOP_RIGHT, -20, 100);
+
+    // Contenedor desplazable con las filas recicladas
+    log_list = lv_obj_create(scr);
+    lv_obj_set_size(log_list, LV_PCT(100), LV_VER_RES - 140);
+    lv_obj_align(log_list, LV_ALIGN_TOP_MID, 0, 135);
+    lv_obj_set_scroll_dir(log_list, LV_DIR_VER);
+    lv_obj_set_style_pad_all(log_list, 0, LV_PART_MAIN);
+
+    log_spacer = lv_obj_create(log_list);
+    lv_obj_remove_style_all(log_spacer);
+    lv_obj_set_size(log_spacer, 1, 0);
+    lv_obj_remove_flag(log_spacer, LV_OBJ_FLAG_CLICKABLE);
+
+    for (int i = 0; i < ALARM_LOG_ROWS; i++) {
+        rows[i] = lv_label_create(log_list);
+        lv_label_set_text(rows[i], "");
+        lv_obj_set_style_text_font(rows[i], &lv_font_montserrat_20, 0);
+        lv_obj_set_pos(rows[i], 10, 0);
+        lv_obj_add_flag(rows[i], LV_OBJ_FLAG_HIDDEN);
+        row_kind[i] = -1;
+    }
+
+    lv_obj_add_event_cb(log_list, list_scroll_cb, LV_EVENT_SCROLL, NULL);
+    lv_obj_add_event_cb(scr, screen_loaded_cb, LV_EVENT_SCREEN_LOADED, NULL);
+    lv_obj_add_event_cb(scr, screen_delete_cb, LV_EVENT_DELETE, NULL);
+
+    static bool hook_registered = false;
+    if (!hook_registered) {
+        hook_registered = ui_update_register(alarm_log_refresh_hook);
+    }
+}
@@ -0,0 +1,9 @@
+#ifndef ALARM_LOG_SCREEN_H
+#define ALARM_LOG_SCREEN_H
+
+#include "lvgl.h"
+
+// Historial de alarmas: lista con filas recicladas, la más reciente arriba
+void create_alarm_log_screen(lv_obj_t *scr);
+
+#endif // ALARM_LOG_SCREEN_H
@@ -0,0 +1,12 @@
+// Tabla de mensajes de alarma: ALARM(bit, mensaje)
+// Una alarma nueva es una línea más; el bit es el del mapa (ERR / ALM), 0..ALARM_MAX-1.
+// Los bits sin entrada se muestran como "Alarma <n>".
+
+ALARM(0, "Error 0: Sobrecalentamiento T1")
+ALARM(1, "Error 1: Sobrecalentamiento T2")
+ALARM(2, "Error 2: Volumen fuera de rango")
+ALARM(3, "Error 3: Comunicacion UART fallida")
+ALARM(4, "Error 4: Sensor de temperatura desconectado")
+ALARM(5, "Error 5: Bateria baja")
+ALARM(6, "Error 6: Memoria insuficiente")
+ALARM(7, "Error 7: Otro error desconocido")
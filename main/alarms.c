@@ -0,0 +1,89 @@
+#include "alarms.h"
+#include <string.h>
+#include "ui_format.h"
+
+// Tabla indexada por bit, resuelta en compilación: un bit fuera de rango no compila
+#define ALARM(bit, text) [bit] = text,
+static const char *const alarm_messages[ALARM_MAX] = {
+#include "alarm_messages.h"
+};
+#undef ALARM
+
+// Sitio reservado para la línea "+<n> más"
+#define ALARM_MORE_RESERVE 16
+
+bool alarm_set_equal(const alarm_set_t *a, const alarm_set_t *b) {
+    return memcmp(a->words, b->words, sizeof(a->words)) == 0;
+}
+
+unsigned alarm_count(const alarm_set_t *set) {
+    unsigned n = 0;
+    for (int i = 0; i < ALARM_WORDS; i++) {
+        n += (unsigned)__builtin_popcount(set->words[i]);
+    }
+    return n;
+}
+
+unsigned alarm_next(const alarm_set_t *set, unsigned from) {
+    for (unsigned w = from / 32; w < ALARM_WORDS; w++) {
+        uint32_t word = set->words[w];
+        if (w == from / 32) {
+            word &= ~0u << (from % 32);
+        }
+        if (word != 0) {
+            return w * 32 + (unsigned)__builtin_ctz(word);
+        }
+    }
+    return ALARM_MAX;
+}
+
+const char *alarm_message(unsigned bit) {
+    return bit < ALARM_MAX ? alarm_messages[bit] : NULL;
+}
+
+static size_t append(char *buf, size_t size, size_t len, const char *text) {
+    size_t n = strlen(text);
+    if (len + n >= size) {
+        n = size - 1 - len;
+    }
+    memcpy(buf + len, text, n);
+    buf[len + n] = '\0';
+    return len + n;
+}
+
+size_t alarm_render(const alarm_set_t *set, char *buf, size_t size) {
+    size_t len = 0;
+    unsigned remaining = alarm_count(set);
+
+    if (size == 0) {
+        return 0;
+    }
+    buf[0] = '\0';
+    if (remaining == 0) {
+        return append(buf, size, 0, "Ninguna");
+    }
+
+    for (int w = 0; w < ALARM_WORDS; w++) {
+        // Recorre sólo los bits activos: ctz da el siguiente, w & (w - 1) lo borra
+        for (uint32_t word = set->words[w]; word != 0; word &= word - 1) {
+            unsigned bit = (unsigned)(w * 32 + __builtin_ctz(word));
+            const char *text = alarm_messages[bit];
+            char fallback[16];
+            if (text == NULL) {
+                ui_fmt_label(fallback, sizeof(fallback), "Alarma ", (int32_t)bit, 0, NULL);
+                text = fallback;
+            }
+            // La última alarma no necesita reservar sitio para "+<n> más"
+            size_t reserve = remaining > 1 ? ALARM_MORE_RESERVE : 0;
+            if (len + strlen(text) + 1 + reserve >= size) {
+                char more[ALARM_MORE_RESERVE];
+                ui_fmt_label(more, sizeof(more), "+", (int32_t)remaining, 0, " más");
+                return append(buf, size, len, more);
+            }
+            len = append(buf, size, len, text);
+            len = append(buf, size, len, "\n");
+            remaining--;
+        }
+    }
+    return len;
+}
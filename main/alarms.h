@@ -0,0 +1,45 @@
+// alarms.h
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Mapa de hasta ALARM_MAX alarmas en palabras de 32 bits y su texto para la UI.
+// Los mensajes salen de la tabla constante de alarm_messages.h; el texto se
+// genera en un buffer del llamador, sin malloc. Sin dependencias de ESP-IDF.
+
+#define ALARM_MAX 256
+#define ALARM_WORDS (ALARM_MAX / 32)
+
+typedef struct {
+    uint32_t words[ALARM_WORDS];
+} alarm_set_t;
+
+static inline void alarm_set_clear(alarm_set_t *set) {
+    for (int i = 0; i < ALARM_WORDS; i++) {
+        set->words[i] = 0;
+    }
+}
+
+static inline bool alarm_is_set(const alarm_set_t *set, unsigned bit) {
+    return bit < ALARM_MAX && ((set->words[bit / 32] >> (bit % 32)) & 1u);
+}
+
+bool alarm_set_equal(const alarm_set_t *a, const alarm_set_t *b);
+
+// Alarmas activas
+unsigned alarm_count(const alarm_set_t *set);
+
+// Primera alarma activa >= from, o ALARM_MAX si no hay más
+unsigned alarm_next(const alarm_set_t *set, unsigned from);
+
+// Mensaje de la tabla; NULL si el bit no tiene entrada
+const char *alarm_message(unsigned bit);
+
+// Una línea por alarma activa, o "Ninguna". Si no caben todas, la última línea
+// es "+<n> más". Devuelve la longitud escrita.
+size_t alarm_render(const alarm_set_t *set, char *buf, size_t size);
+
+#endif // ALARMS_H
@@ -0,0 +1,79 @@
+#include "boot_profile.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "uart_config.h"
+
+typedef struct {
+    const char *phase;
+    uint32_t us;
+} boot_mark_t;
+
+static portMUX_TYPE marks_lock = portMUX_INITIALIZER_UNLOCKED;
+static boot_mark_t marks[BOOT_PROFILE_MAX_MARKS];
+static int mark_count = 0;
+static int pending_parts = 2;       // app_main + primer frame
+static uint32_t first_frame_us;
+static void (*first_frame_cb)(void) = NULL;
+
+static void report(void) {
+    ESP_LOGI("BOOT", "Fases del arranque (ms desde el inicio de la aplicación):");
+    for (int i = 0; i < mark_count; i++) {
+        uint32_t prev = i > 0 ? marks[i - 1].us : 0;
+        ESP_LOGI("BOOT", "  %-14s %5lu ms  (+%lu)", marks[i].phase, (unsigned long)(marks[i].us / 1000),
+                 (unsigned long)((marks[i].us - prev) / 1000));
+    }
+    if (first_frame_us / 1000 > BOOT_FIRST_FRAME_TARGET_MS) {
+        ESP_LOGW("BOOT", "Primer frame a %lu ms (objetivo %d ms)", (unsigned long)(first_frame_us / 1000),
+                 BOOT_FIRST_FRAME_TARGET_MS);
+    }
+}
+
+// El resumen sale cuando se completan las dos partes
+static void part_done(void) {
+    portENTER_CRITICAL(&marks_lock);
+    bool last = --pending_parts == 0;
+    portEXIT_CRITICAL(&marks_lock);
+    if (last) {
+        report();
+    }
+}
+
+void boot_profile_mark(const char *phase) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    portENTER_CRITICAL(&marks_lock);
+    if (mark_count < BOOT_PROFILE_MAX_MARKS) {
+        // Orden por tiempo: las tareas de init en paralelo pueden marcar tarde
+        int i = mark_count++;
+        while (i > 0 && marks[i - 1].us > now) {
+            marks[i] = marks[i - 1];
+            i--;
+        }
+        marks[i] = (boot_mark_t){ phase, now };
+    }
+    portEXIT_CRITICAL(&marks_lock);
+}
+
+static void refr_ready_cb(lv_event_t *e) {
+    if (first_frame_us != 0) {
+        return;
+    }
+    boot_profile_mark("first_frame");
+    first_frame_us = (uint32_t)esp_timer_get_time();
+    if (first_frame_cb != NULL) {
+        first_frame_cb();
+    }
+    part_done();
+}
+
+void boot_profile_watch_first_frame(lv_display_t *disp, void (*cb)(void)) {
+    first_frame_cb = cb;
+    lv_display_add_event_cb(disp, refr_ready_cb, LV_EVENT_REFR_READY, NULL);
+}
+
+void boot_profile_done(void) {
+    boot_profile_mark("app_main_end");
+    part_done();
+}
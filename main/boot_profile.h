@@ -0,0 +1,24 @@
+// boot_profile.h
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#include "lvgl.h"
+
+// Marcas de tiempo de las fases del arranque (esp_timer: desde que arranca la
+// aplicación, sin contar ROM ni bootloader). El resumen sale por el log una
+// vez terminado app_main y pintado el primer frame, lo que ocurra después.
+
+#define BOOT_PROFILE_MAX_MARKS 16
+
+// Anota el final de una fase; se puede llamar desde cualquier tarea
+void boot_profile_mark(const char *phase);
+
+// Marca "first_frame" al terminar el primer refresco tras cargar la pantalla
+// inicial y llama a cb (en el contexto de LVGL). Llamar con el lock de LVGL,
+// justo después de lv_scr_load.
+void boot_profile_watch_first_frame(lv_display_t *disp, void (*cb)(void));
+
+// Fin de app_main
+void boot_profile_done(void);
+
+#endif // BOOT_PROFILE_H
@@ -0,0 +1,293 @@
+// data_parser.c
+#include "data_parser.h"
+#include <string.h>
+
+// Compara la etiqueta literal y avanza; false si no coincide.
+// Se detiene en el primer byte distinto: nunca lee más allá del '\0' de la trama.
+static bool expect(const char **p, const char *tag) {
+    const char *s = *p;
+    while (*tag != '\0') {
+        if (*s++ != *tag++) {
+            return false;
+        }
+    }
+    *p = s;
+    return true;
+}
+
+// Decimal con signo -> centésimas, redondeando la tercera cifra decimal (mitad hacia fuera)
+static bool parse_centi(const char **p, int16_t *out) {
+    const char *s = *p;
+    bool negative = false;
+    if (*s == '-' || *s == '+') {
+        negative = (*s == '-');
+        s++;
+    }
+
+    int32_t value = 0;
+    const char *digits = s;
+    while (*s >= '0' && *s <= '9') {
+        value = value * 10 + (*s++ - '0');
+        if (value > INT16_MAX) {
+            return false;
+        }
+    }
+    bool has_int = s != digits;
+
+    int frac = 0;
+    int frac_digits = 0;
+    bool round_up = false;
+    if (*s == '.') {
+        s++;
+        while (*s >= '0' && *s <= '9') {
+            if (frac_digits < 2) {
+                frac = frac * 10 + (*s - '0');
+            } else if (frac_digits == 2) {
+                round_up = *s >= '5';
+            }
+            frac_digits++;
+            s++;
+        }
+    }
+    if (!has_int && frac_digits == 0) {
+        return false;
+    }
+    if (frac_digits == 1) {
+        frac *= 10;
+    }
+
+    int32_t centi = value * 100 + frac + (round_up ? 1 : 0);
+    if (centi > INT16_MAX) {
+        return false;
+    }
+    *out = (int16_t)(negative ? -centi : centi);
+    *p = s;
+    return true;
+}
+
+static bool parse_int32(const char **p, int32_t *out) {
+    const char *s = *p;
+    bool negative = false;
+    if (*s == '-' || *s == '+') {
+        negative = (*s == '-');
+        s++;
+    }
+    const char *digits = s;
+    uint32_t value = 0;
+    while (*s >= '0' && *s <= '9') {
+        uint32_t digit = (uint32_t)(*s++ - '0');
+        if (value > ((uint32_t)INT32_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    if (s == digits) {
+        return false;
+    }
+    *out = negative ? -(int32_t)value : (int32_t)value;
+    *p = s;
+    return true;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// 0x seguido de una o dos cifras hexadecimales
+static bool parse_hex8(const char **p, uint8_t *out) {
+    const char *s = *p;
+    if (s[0] != '0' || (s[1] | 0x20) != 'x') {
+        return false;
+    }
+    s += 2;
+    int hi = hex_digit(*s);
+    if (hi < 0) {
+        return false;
+    }
+    s++;
+    int lo = hex_digit(*s);
+    if (lo >= 0) {
+        hi = (hi << 4) | lo;
+        s++;
+    }
+    *out = (uint8_t)hi;
+    *p = s;
+    return true;
+}
+
+// Separador entre campos: ';' obligatorio salvo al final de la trama
+static bool field_end(const char **p) {
+    if (**p == ';') {
+        (*p)++;
+        return true;
+    }
+    return **p == '\0';
+}
+
+static bool parse_uint32(const char **p, uint32_t *out) {
+    const char *s = *p;
+    uint32_t value = 0;
+    while (*s >= '0' && *s <= '9') {
+        uint32_t digit = (uint32_t)(*s++ - '0');
+        if (value > (UINT32_MAX - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    if (s == *p) {
+        return false;
+    }
+    *out = value;
+    *p = s;
+    return true;
+}
+
+static data_parse_result_t finish(data_parse_result_t res, const char *frame, const char *p, size_t *error_offset) {
+    if (res != DATA_PARSE_OK && error_offset != NULL) {
+        *error_offset = (size_t)(p - frame);
+    }
+    return res;
+}
+
+data_parse_result_t data_parse_keyframe(const char *frame, tp_delta_t *out, size_t *error_offset) {
+    const char *p = frame;
+    data_parse_result_t res = DATA_PARSE_OK;
+    tp_data_t *data = &out->data;
+
+    data->errors = 0;
+    out->seq = 0;
+    out->mask = TP_FIELD_ALL;
+    out->flags = TP_DELTA_KEYFRAME | TP_DELTA_NO_SEQ;
+    if (!expect(&p, "DATA:")) {
+        res = DATA_PARSE_PREFIX;
+    } else if (!expect(&p, "T1=") || !parse_centi(&p, &data->t1_centi) || !field_end(&p)) {
+        res = DATA_PARSE_T1;
+    } else if (!expect(&p, "T2=") || !parse_centi(&p, &data->t2_centi) || !field_end(&p)) {
+        res = DATA_PARSE_T2;
+    } else if (!expect(&p, "VOL=") || !parse_int32(&p, &data->vol_ml) || !field_end(&p)) {
+        res = DATA_PARSE_VOL;
+    } else if (strncmp(p, "ERR", 3) == 0 && (!expect(&p, "ERR=") || !parse_hex8(&p, &data->errors) || !field_end(&p))) {
+        res = DATA_PARSE_ERR;
+    } else if (strncmp(p, "SEQ", 3) == 0) {
+        // SEQ sólo lo envían los controladores con tramas delta
+        if (!expect(&p, "SEQ=") || !parse_uint32(&p, &out->seq) || !field_end(&p)) {
+            res = DATA_PARSE_SEQ;
+        } else {
+            out->flags &= ~TP_DELTA_NO_SEQ;
+        }
+    }
+    if (res == DATA_PARSE_OK && *p != '\0') {
+        res = DATA_PARSE_TRAILING;
+    }
+    return finish(res, frame, p, error_offset);
+}
+
+data_parse_result_t data_parse(const char *frame, tp_data_t *out, size_t *error_offset) {
+    tp_delta_t key;
+    data_parse_result_t res = data_parse_keyframe(frame, &key, error_offset);
+    *out = key.data;
+    return res;
+}
+
+data_parse_result_t data_parse_delta(const char *frame, tp_delta_t *out, size_t *error_offset) {
+    const char *p = frame;
+    tp_data_t *data = &out->data;
+
+    out->mask = 0;
+    out->flags = 0;
+    if (!expect(&p, "DLT:")) {
+        return finish(DATA_PARSE_PREFIX, frame, p, error_offset);
+    }
+    if (!parse_uint32(&p, &out->seq) || !field_end(&p)) {
+        return finish(DATA_PARSE_SEQ, frame, p, error_offset);
+    }
+
+    while (*p != '\0') {
+        const char *field = p;
+        uint8_t id = (uint8_t)(*p - '0');
+        uint8_t bit = (id >= 1 && id <= TP_FIELD_COUNT) ? (uint8_t)(1u << (id - 1)) : 0;
+        if (bit == 0 || p[1] != '=' || (out->mask & bit)) {
+            return finish(DATA_PARSE_FIELD, frame, field, error_offset);
+        }
+        p += 2;
+
+        bool ok;
+        data_parse_result_t res;
+        switch (bit) {
+        case TP_FIELD_T1:
+            ok = parse_centi(&p, &data->t1_centi);
+            res = DATA_PARSE_T1;
+            break;
+        case TP_FIELD_T2:
+            ok = parse_centi(&p, &data->t2_centi);
+            res = DATA_PARSE_T2;
+            break;
+        case TP_FIELD_VOL:
+            ok = parse_int32(&p, &data->vol_ml);
+            res = DATA_PARSE_VOL;
+            break;
+        default:
+            ok = parse_hex8(&p, &data->errors);
+            res = DATA_PARSE_ERR;
+            break;
+        }
+        if (!ok || !field_end(&p)) {
+            return finish(res, frame, field, error_offset);
+        }
+        out->mask |= bit;
+    }
+    return DATA_PARSE_OK;
+}
+
+data_parse_result_t data_parse_alarms(const char *frame, tp_alarms_t *out, size_t *error_offset) {
+    const char *p = frame;
+
+    if (!expect(&p, "ALM:")) {
+        return finish(DATA_PARSE_PREFIX, frame, p, error_offset);
+    }
+    const char *field = p;
+    if (!expect(&p, "0x") && !expect(&p, "0X")) {
+        return finish(DATA_PARSE_ERR, frame, field, error_offset);
+    }
+    const char *digits = p;
+    while (hex_digit(*p) >= 0) {
+        p++;
+    }
+    size_t n = (size_t)(p - digits);
+    if (n == 0 || n > TP_ALARM_WORDS * 8 || !field_end(&p)) {
+        return finish(DATA_PARSE_ERR, frame, field, error_offset);
+    }
+    if (*p != '\0') {
+        return finish(DATA_PARSE_TRAILING, frame, p, error_offset);
+    }
+
+    // Cifras de la menos significativa a la más: la cifra k va a la palabra k / 8
+    memset(out->words, 0, sizeof(out->words));
+    for (size_t k = 0; k < n; k++) {
+        out->words[k / 8] |= (uint32_t)hex_digit(digits[n - 1 - k]) << ((k % 8) * 4);
+    }
+    out->count = (uint8_t)((n + 7) / 8);
+    return DATA_PARSE_OK;
+}
+
+const char *data_parse_result_str(data_parse_result_t res) {
+    switch (res) {
+    case DATA_PARSE_OK: return "ok";
+    case DATA_PARSE_PREFIX: return "prefix";
+    case DATA_PARSE_T1: return "T1";
+    case DATA_PARSE_T2: return "T2";
+    case DATA_PARSE_VOL: return "VOL";
+    case DATA_PARSE_ERR: return "ERR";
+    case DATA_PARSE_SEQ: return "SEQ";
+    case DATA_PARSE_FIELD: return "field id";
+    case DATA_PARSE_TRAILING: return "trailing";
+    default: return "?";
+    }
+}
@@ -0,0 +1,43 @@
+// data_parser.h
+#ifndef DATA_PARSER_H
+#define DATA_PARSER_H
+
+#include <stddef.h>
+#include "telemetry_proto.h"
+
+// Parser de una pasada para las tramas de telemetría en ASCII:
+//   DATA:T1=<dec>;T2=<dec>;VOL=<int>;ERR=0x<hex>;SEQ=<n>;   keyframe (estado completo)
+//   DLT:<seq>;<id>=<valor>;...                             delta: sólo campos cambiados
+//   ALM:0x<hex>;                                           mapa de alarmas (hasta 64 cifras)
+// Los ids de campo son los de TP_FIELD_*: 1=T1, 2=T2, 3=VOL, 4=ERR.
+// Sin malloc ni coma flotante: rellena los mismos tipos que el protocolo binario
+// (temperaturas en centésimas, redondeadas). ERR y SEQ son opcionales en DATA y el
+// ';' final también. Sin dependencias de ESP-IDF.
+
+typedef enum {
+    DATA_PARSE_OK = 0,
+    DATA_PARSE_PREFIX,      // No empieza por "DATA:"
+    DATA_PARSE_T1,
+    DATA_PARSE_T2,
+    DATA_PARSE_VOL,
+    DATA_PARSE_ERR,
+    DATA_PARSE_SEQ,         // Número de secuencia ausente o inválido
+    DATA_PARSE_FIELD,       // Id de campo desconocido o repetido en un delta
+    DATA_PARSE_TRAILING,    // Sobra texto tras el último campo
+} data_parse_result_t;
+
+// Si falla, *error_offset (si no es NULL) indica el byte de la trama donde se detuvo
+data_parse_result_t data_parse(const char *frame, tp_data_t *out, size_t *error_offset);
+
+// DATA como keyframe: flags = TP_DELTA_KEYFRAME, más TP_DELTA_NO_SEQ si no trae SEQ
+data_parse_result_t data_parse_keyframe(const char *frame, tp_delta_t *out, size_t *error_offset);
+
+// Trama DLT: seq, mask con los campos presentes y sus valores en out->data
+data_parse_result_t data_parse_delta(const char *frame, tp_delta_t *out, size_t *error_offset);
+
+// Trama ALM: la última cifra hexadecimal son las alarmas 0..3 (como ERR, ampliado)
+data_parse_result_t data_parse_alarms(const char *frame, tp_alarms_t *out, size_t *error_offset);
+
+const char *data_parse_result_str(data_parse_result_t res);
+
+#endif // DATA_PARSER_H
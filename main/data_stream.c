@@ -0,0 +1,90 @@
+// data_stream.c
+#include "data_stream.h"
+#include <string.h>
+
+void data_stream_init(data_stream_t *s, uint32_t retry_ms) {
+    memset(s, 0, sizeof(*s));
+    s->retry_ms = retry_ms;
+}
+
+// Copia los campos de mask y devuelve los que cambiaron de valor
+static uint8_t merge_fields(tp_data_t *dst, const tp_data_t *src, uint8_t mask) {
+    uint8_t changed = 0;
+    if ((mask & TP_FIELD_T1) && dst->t1_centi != src->t1_centi) {
+        dst->t1_centi = src->t1_centi;
+        changed |= TP_FIELD_T1;
+    }
+    if ((mask & TP_FIELD_T2) && dst->t2_centi != src->t2_centi) {
+        dst->t2_centi = src->t2_centi;
+        changed |= TP_FIELD_T2;
+    }
+    if ((mask & TP_FIELD_VOL) && dst->vol_ml != src->vol_ml) {
+        dst->vol_ml = src->vol_ml;
+        changed |= TP_FIELD_VOL;
+    }
+    if ((mask & TP_FIELD_ERR) && dst->errors != src->errors) {
+        dst->errors = src->errors;
+        changed |= TP_FIELD_ERR;
+    }
+    return changed;
+}
+
+data_stream_result_t data_stream_apply(data_stream_t *s, const tp_delta_t *frame, size_t wire_len,
+                                       uint8_t *changed) {
+    *changed = 0;
+    s->stats.bytes_received += (uint32_t)wire_len;
+
+    if (frame->flags & TP_DELTA_KEYFRAME) {
+        bool was_synced = s->synced;
+        *changed = merge_fields(&s->data, &frame->data, TP_FIELD_ALL);
+        // Tras un hueco, todos: lo mostrado puede venir de antes. Sin SEQ el flujo
+        // nunca queda sincronizado, así que sólo la primera keyframe lo es
+        bool resync = (frame->flags & TP_DELTA_NO_SEQ) ? s->stats.keyframes == 0 : !was_synced;
+        if (resync) {
+            *changed = TP_FIELD_ALL;
+        }
+        // Sin SEQ el controlador no envía deltas: no hay secuencia que vigilar
+        s->synced = (frame->flags & TP_DELTA_NO_SEQ) == 0;
+        s->next_seq = frame->seq + 1;
+        s->keyframe_len = (uint16_t)wire_len;
+        s->request_pending = false;
+        s->stats.keyframes++;
+        return DATA_STREAM_APPLIED;
+    }
+
+    if (!s->synced) {
+        s->stats.stale++;
+        return DATA_STREAM_NEED_KEYFRAME;
+    }
+    int32_t distance = (int32_t)(frame->seq - s->next_seq);
+    if (distance < 0) {
+        s->stats.stale++;
+        return DATA_STREAM_IGNORED;
+    }
+    if (distance > 0) {
+        s->stats.gaps++;
+        s->synced = false;
+        return DATA_STREAM_NEED_KEYFRAME;
+    }
+
+    *changed = merge_fields(&s->data, &frame->data, frame->mask);
+    s->next_seq++;
+    s->stats.deltas++;
+    if (s->keyframe_len > wire_len) {
+        s->stats.bytes_saved += s->keyframe_len - (uint32_t)wire_len;
+    }
+    return DATA_STREAM_APPLIED;
+}
+
+bool data_stream_request_due(data_stream_t *s, uint32_t now_ms) {
+    if (s->synced) {
+        return false;
+    }
+    if (s->request_pending && (uint32_t)(now_ms - s->last_request_ms) < s->retry_ms) {
+        return false;
+    }
+    s->request_pending = true;
+    s->last_request_ms = now_ms;
+    s->stats.keyframe_requests++;
+    return true;
+}
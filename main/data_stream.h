@@ -0,0 +1,52 @@
+// data_stream.h
+#ifndef DATA_STREAM_H
+#define DATA_STREAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "telemetry_proto.h"
+
+// Reconstruye el estado de la telemetría a partir de keyframes y tramas delta.
+// Un hueco en la secuencia deja el estado desincronizado: los deltas se ignoran
+// hasta la siguiente keyframe, que el llamador pide al controlador (GET_KEY*).
+// Sin dependencias de ESP-IDF.
+
+typedef struct {
+    uint32_t keyframes;         // Keyframes aplicadas
+    uint32_t deltas;            // Deltas aplicados
+    uint32_t gaps;              // Huecos de secuencia detectados
+    uint32_t stale;             // Deltas ignorados (desincronizado o repetidos)
+    uint32_t keyframe_requests; // Peticiones de keyframe emitidas
+    uint32_t bytes_received;    // Bytes de telemetría recibidos (sin delimitador)
+    uint32_t bytes_saved;       // Bytes ahorrados por los deltas frente a keyframes
+} data_stream_stats_t;
+
+typedef struct {
+    tp_data_t data;             // Último estado completo conocido
+    uint32_t next_seq;          // Secuencia esperada del siguiente delta
+    bool synced;                // Hay keyframe válida y no se ha perdido ningún delta
+    uint16_t keyframe_len;      // Tamaño de la última keyframe: referencia del ahorro
+    uint32_t retry_ms;          // Intervalo mínimo entre peticiones de keyframe
+    uint32_t last_request_ms;
+    bool request_pending;
+    data_stream_stats_t stats;
+} data_stream_t;
+
+typedef enum {
+    DATA_STREAM_APPLIED,        // Estado actualizado (puede que sin cambios)
+    DATA_STREAM_IGNORED,        // Delta repetido o antiguo: sin efecto
+    DATA_STREAM_NEED_KEYFRAME,  // Desincronizado: pedir keyframe (ver data_stream_request_due)
+} data_stream_result_t;
+
+void data_stream_init(data_stream_t *s, uint32_t retry_ms);
+
+// Aplica una keyframe o un delta de `wire_len` bytes. *changed recibe los
+// TP_FIELD_* cuyo valor cambió (todos en la primera keyframe y tras un hueco).
+data_stream_result_t data_stream_apply(data_stream_t *s, const tp_delta_t *frame, size_t wire_len,
+                                       uint8_t *changed);
+
+// true si hay que (re)enviar la petición de keyframe en este instante
+bool data_stream_request_due(data_stream_t *s, uint32_t now_ms);
+
+#endif // DATA_STREAM_H
@@ -0,0 +1,443 @@
+// datalog.c
+#include "datalog.h"
+#include <string.h>
+
+#define DLOG_MAGIC 0x31474c44u  // "DLG1"
+#define DLOG_DT_EXT 14          // Código de dt: el dt sigue como varint
+#define DLOG_CODE_END 15        // Código reservado: 0xFF es flash borrada
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t first_ts;
+    int32_t vol_ml;         // Primera muestra completa
+    int16_t t1_centi;
+    int16_t t2_centi;
+    uint8_t errors;
+    uint8_t reserved;
+    uint16_t crc;           // CRC16 de todo lo anterior
+} dlog_header_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t last_ts;
+    uint32_t data_len;      // Bytes de muestras tras DATALOG_DATA_OFFSET
+    uint16_t data_crc;
+    uint16_t crc;           // CRC16 de todo lo anterior
+} dlog_seal_t;
+
+_Static_assert(sizeof(dlog_header_t) == DATALOG_HEADER_SIZE, "cabecera de 24 bytes");
+_Static_assert(DATALOG_HEADER_SIZE + sizeof(dlog_seal_t) == DATALOG_DATA_OFFSET, "cierre de 16 bytes");
+
+typedef struct {
+    datalog_sample_t last;
+} last_ctx_t;
+
+static uint32_t put_varint(uint8_t *out, uint32_t value) {
+    uint32_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static bool get_varint(const uint8_t *data, uint32_t len, uint32_t *pos, uint32_t *value) {
+    uint32_t result = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7) {
+        if (*pos >= len) {
+            return false;
+        }
+        uint8_t byte = data[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static uint32_t encode_sample(const datalog_sample_t *prev, const datalog_sample_t *s, uint8_t *out) {
+    uint32_t dt = s->ts - prev->ts;
+    uint8_t mask = 0;
+    if (s->data.t1_centi != prev->data.t1_centi) mask |= TP_FIELD_T1;
+    if (s->data.t2_centi != prev->data.t2_centi) mask |= TP_FIELD_T2;
+    if (s->data.vol_ml != prev->data.vol_ml) mask |= TP_FIELD_VOL;
+    if (s->data.errors != prev->data.errors) mask |= TP_FIELD_ERR;
+
+    uint32_t n = 1;
+    if (dt >= 1 && dt <= DLOG_DT_EXT) {
+        out[0] = (uint8_t)((dt - 1) << 4 | mask);
+    } else {
+        out[0] = (uint8_t)(DLOG_DT_EXT << 4 | mask);
+        n += put_varint(out + n, dt);
+    }
+    if (mask & TP_FIELD_T1) n += put_varint(out + n, zigzag((int32_t)s->data.t1_centi - prev->data.t1_centi));
+    if (mask & TP_FIELD_T2) n += put_varint(out + n, zigzag((int32_t)s->data.t2_centi - prev->data.t2_centi));
+    if (mask & TP_FIELD_VOL) n += put_varint(out + n, zigzag((int32_t)((uint32_t)s->data.vol_ml - (uint32_t)prev->data.vol_ml)));
+    if (mask & TP_FIELD_ERR) out[n++] = s->data.errors;
+    return n;
+}
+
+// Sólo avanza *pos si la muestra está completa
+static bool decode_sample(const uint8_t *data, uint32_t len, uint32_t *pos, datalog_sample_t *s) {
+    uint32_t p = *pos;
+    if (p >= len || data[p] >> 4 == DLOG_CODE_END) {
+        return false;
+    }
+    uint8_t ctrl = data[p++];
+    uint32_t dt = (ctrl >> 4) + 1u;
+    uint32_t v;
+    datalog_sample_t next = *s;
+
+    if (ctrl >> 4 == DLOG_DT_EXT && !get_varint(data, len, &p, &dt)) {
+        return false;
+    }
+    next.ts += dt;
+    if (ctrl & TP_FIELD_T1) {
+        if (!get_varint(data, len, &p, &v)) return false;
+        next.data.t1_centi = (int16_t)(next.data.t1_centi + unzigzag(v));
+    }
+    if (ctrl & TP_FIELD_T2) {
+        if (!get_varint(data, len, &p, &v)) return false;
+        next.data.t2_centi = (int16_t)(next.data.t2_centi + unzigzag(v));
+    }
+    if (ctrl & TP_FIELD_VOL) {
+        if (!get_varint(data, len, &p, &v)) return false;
+        next.data.vol_ml = (int32_t)((uint32_t)next.data.vol_ml + (uint32_t)unzigzag(v));
+    }
+    if (ctrl & TP_FIELD_ERR) {
+        if (p >= len) return false;
+        next.data.errors = data[p++];
+    }
+    *s = next;
+    *pos = p;
+    return true;
+}
+
+static bool header_valid(const dlog_header_t *hdr) {
+    return hdr->magic == DLOG_MAGIC && hdr->seq != 0 &&
+           hdr->crc == tp_crc16((const uint8_t *)hdr, offsetof(dlog_header_t, crc));
+}
+
+static bool seal_valid(const dlog_seal_t *seal) {
+    return seal->crc == tp_crc16((const uint8_t *)seal, offsetof(dlog_seal_t, crc));
+}
+
+uint32_t datalog_decode(const uint8_t *block, uint32_t len, datalog_sample_cb_t cb, void *ctx,
+                        uint32_t *end) {
+    dlog_header_t hdr;
+    *end = 0;
+    if (len < DATALOG_DATA_OFFSET) {
+        return 0;
+    }
+    memcpy(&hdr, block, sizeof(hdr));
+    if (!header_valid(&hdr)) {
+        return 0;
+    }
+    datalog_sample_t s = {
+        .ts = hdr.first_ts,
+        .data = { .t1_centi = hdr.t1_centi, .t2_centi = hdr.t2_centi,
+                  .vol_ml = hdr.vol_ml, .errors = hdr.errors },
+    };
+    uint32_t pos = DATALOG_DATA_OFFSET;
+    uint32_t count = 1;
+    bool more = cb == NULL || cb(&s, ctx);
+
+    while (more && decode_sample(block, len, &pos, &s)) {
+        count++;
+        more = cb == NULL || cb(&s, ctx);
+    }
+    *end = pos;
+    return count;
+}
+
+static bool keep_last(const datalog_sample_t *sample, void *ctx) {
+    ((last_ctx_t *)ctx)->last = *sample;
+    return true;
+}
+
+static uint32_t block_offset(const datalog_t *log, uint32_t phys) {
+    return phys * log->io.sector_size;
+}
+
+// Carga el bloque en log->block y completa su entrada del índice decodificándolo
+static bool load_block(datalog_t *log, uint32_t phys, datalog_sample_t *last) {
+    datalog_block_info_t *info = &log->index[phys];
+    last_ctx_t ctx;
+    uint32_t end;
+
+    if (!log->io.read(log->io.ctx, block_offset(log, phys), log->block, log->io.sector_size)) {
+        log->stats.io_errors++;
+        return false;
+    }
+    // Un bloque cerrado sólo tiene datos hasta data_len; uno abierto, hasta el primer 0xFF
+    uint32_t limit = info->len != 0 ? info->len : log->io.sector_size;
+    info->count = datalog_decode(log->block, limit, keep_last, &ctx, &end);
+    if (info->count == 0) {
+        log->stats.corrupt++;
+        return false;
+    }
+    info->last_ts = ctx.last.ts;
+    info->len = end;
+    if (last != NULL) {
+        *last = ctx.last;
+    }
+    return true;
+}
+
+static bool write_seal(datalog_t *log) {
+    const datalog_block_info_t *info = &log->index[log->head];
+    dlog_seal_t seal = {
+        .count = info->count,
+        .last_ts = info->last_ts,
+        .data_len = info->len - DATALOG_DATA_OFFSET,
+        .data_crc = tp_crc16(log->block + DATALOG_DATA_OFFSET, info->len - DATALOG_DATA_OFFSET),
+    };
+    seal.crc = tp_crc16((const uint8_t *)&seal, offsetof(dlog_seal_t, crc));
+    log->open = false;
+    if (!log->io.write(log->io.ctx, block_offset(log, log->head) + DATALOG_HEADER_SIZE, &seal, sizeof(seal))) {
+        log->stats.io_errors++;
+        return false; // Se recupera decodificando al montar
+    }
+    return true;
+}
+
+bool datalog_mount(datalog_t *log, const flash_io_t *io, datalog_block_info_t *index, uint8_t *block) {
+    memset(log, 0, sizeof(*log));
+    if (io->sector_count < 2 || io->sector_size < DATALOG_DATA_OFFSET + DATALOG_MAX_SAMPLE) {
+        return false;
+    }
+    log->io = *io;
+    log->index = index;
+    log->block = block;
+
+    bool found = false;
+    for (uint32_t b = 0; b < io->sector_count; b++) {
+        uint8_t raw[DATALOG_DATA_OFFSET];
+        dlog_header_t hdr;
+        dlog_seal_t seal;
+
+        memset(&index[b], 0, sizeof(index[b]));
+        if (!io->read(io->ctx, block_offset(log, b), raw, sizeof(raw))) {
+            log->stats.io_errors++;
+            continue;
+        }
+        memcpy(&hdr, raw, sizeof(hdr));
+        memcpy(&seal, raw + DATALOG_HEADER_SIZE, sizeof(seal));
+        if (!header_valid(&hdr)) {
+            continue;
+        }
+        index[b].seq = hdr.seq;
+        index[b].first_ts = hdr.first_ts;
+        if (seal_valid(&seal) && DATALOG_DATA_OFFSET + seal.data_len <= io->sector_size) {
+            index[b].last_ts = seal.last_ts;
+            index[b].count = seal.count;
+            index[b].len = DATALOG_DATA_OFFSET + seal.data_len;
+        }
+        if (!found || (int32_t)(hdr.seq - index[log->head].seq) > 0) {
+            log->head = b;
+            found = true;
+        }
+    }
+    if (!found) {
+        return true; // Log vacío: el primer append abre el bloque 0
+    }
+
+    // Tramo de bloques consecutivos que termina en head; lo anterior a un hueco se ignora
+    log->blocks = 1;
+    for (uint32_t p = log->head; log->blocks < io->sector_count; log->blocks++) {
+        uint32_t prev = (p + io->sector_count - 1) % io->sector_count;
+        if (index[prev].seq == 0 || index[prev].seq != index[p].seq - 1) {
+            break;
+        }
+        p = prev;
+    }
+    // Bloques sin cierre que no son head (corte entre datos y cierre): decodificarlos
+    for (uint32_t k = 0; k + 1 < log->blocks; k++) {
+        uint32_t phys = (log->head + io->sector_count - log->blocks + 1 + k) % io->sector_count;
+        if (index[phys].len == 0) {
+            load_block(log, phys, NULL);
+        }
+    }
+
+    bool sealed = index[log->head].len != 0;
+    if (!load_block(log, log->head, &log->last)) {
+        log->blocks = 0;
+        return true;
+    }
+    log->flushed = index[log->head].len;
+    if (sealed) {
+        return true;
+    }
+    log->stats.recovered = index[log->head].count;
+
+    // Seguir añadiendo sólo si tras lo decodificado la flash está borrada;
+    // si no (escritura a medias), cerrar aquí y empezar un bloque nuevo
+    for (uint32_t i = log->flushed; i < io->sector_size; i++) {
+        if (block[i] != 0xFF) {
+            log->stats.corrupt++;
+            memset(block + log->flushed, 0xFF, io->sector_size - log->flushed);
+            log->open = true;
+            write_seal(log);
+            return true;
+        }
+    }
+    log->open = true;
+    return true;
+}
+
+static bool open_block(datalog_t *log, const datalog_sample_t *sample) {
+    uint32_t next = log->blocks == 0 ? 0 : (log->head + 1) % log->io.sector_count;
+    uint32_t seq = log->blocks == 0 ? 1 : log->index[log->head].seq + 1;
+    dlog_header_t hdr = {
+        .magic = DLOG_MAGIC,
+        .seq = seq != 0 ? seq : 1,
+        .first_ts = sample->ts,
+        .vol_ml = sample->data.vol_ml,
+        .t1_centi = sample->data.t1_centi,
+        .t2_centi = sample->data.t2_centi,
+        .errors = sample->data.errors,
+        .reserved = 0xFF,
+    };
+    hdr.crc = tp_crc16((const uint8_t *)&hdr, offsetof(dlog_header_t, crc));
+
+    // Ring lleno: el bloque siguiente es el más antiguo y se pierde
+    if (log->blocks == log->io.sector_count) {
+        log->blocks--;
+    }
+    memset(&log->index[next], 0, sizeof(log->index[next]));
+    log->open = false;
+    if (!log->io.erase(log->io.ctx, block_offset(log, next), log->io.sector_size)) {
+        log->stats.io_errors++;
+        return false;
+    }
+    log->stats.erases++;
+    memset(log->block, 0xFF, log->io.sector_size);
+    memcpy(log->block, &hdr, sizeof(hdr));
+    if (!log->io.write(log->io.ctx, block_offset(log, next), &hdr, sizeof(hdr))) {
+        log->stats.io_errors++;
+        return false;
+    }
+
+    log->head = next;
+    log->blocks++;
+    log->open = true;
+    log->flushed = DATALOG_DATA_OFFSET;   // El cierre queda borrado hasta llenar el bloque
+    log->index[next] = (datalog_block_info_t){
+        .seq = hdr.seq,
+        .first_ts = sample->ts,
+        .last_ts = sample->ts,
+        .count = 1,
+        .len = DATALOG_DATA_OFFSET,
+    };
+    log->last = *sample;
+    log->stats.samples++;
+    return true;
+}
+
+bool datalog_append(datalog_t *log, const datalog_sample_t *sample) {
+    datalog_sample_t s = *sample;
+    if (log->blocks > 0 && (int32_t)(s.ts - log->last.ts) < 0) {
+        s.ts = log->last.ts;
+    }
+    if (!log->open) {
+        return open_block(log, &s);
+    }
+
+    uint8_t encoded[DATALOG_MAX_SAMPLE];
+    uint32_t n = encode_sample(&log->last, &s, encoded);
+    datalog_block_info_t *info = &log->index[log->head];
+
+    if (info->len + n > log->io.sector_size) {
+        // Un cierre fallido no impide seguir: el bloque se recupera al montar
+        datalog_flush(log);
+        write_seal(log);
+        return open_block(log, &s);
+    }
+    memcpy(log->block + info->len, encoded, n);
+    info->len += n;
+    info->count++;
+    info->last_ts = s.ts;
+    log->last = s;
+    log->stats.samples++;
+    return true;
+}
+
+bool datalog_flush(datalog_t *log) {
+    uint32_t pending = datalog_pending(log);
+    if (pending == 0) {
+        return true;
+    }
+    if (!log->io.write(log->io.ctx, block_offset(log, log->head) + log->flushed,
+                       log->block + log->flushed, pending)) {
+        log->stats.io_errors++;
+        return false;
+    }
+    log->flushed += pending;
+    return true;
+}
+
+bool datalog_last(const datalog_t *log, datalog_sample_t *out) {
+    if (log->blocks == 0) {
+        return false;
+    }
+    *out = log->last;
+    return true;
+}
+
+bool datalog_block(const datalog_t *log, uint32_t ordinal, uint32_t *phys, datalog_block_info_t *info) {
+    if (ordinal >= log->blocks) {
+        return false;
+    }
+    uint32_t count = log->io.sector_count;
+    uint32_t p = (log->head + count - log->blocks + 1 + ordinal) % count;
+    if (phys != NULL) {
+        *phys = p;
+    }
+    if (info != NULL) {
+        *info = log->index[p];
+    }
+    return true;
+}
+
+uint32_t datalog_find(const datalog_t *log, uint32_t from_ts) {
+    uint32_t lo = 0;
+    uint32_t hi = log->blocks;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        datalog_block_info_t info = {0};
+        datalog_block(log, mid, NULL, &info);
+        if (info.last_ts < from_ts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool datalog_read(datalog_t *log, uint32_t phys, uint32_t offset, void *buf, size_t len) {
+    if (offset + len > log->io.sector_size) {
+        return false;
+    }
+    if (log->open && phys == log->head) {
+        memcpy(buf, log->block + offset, len);
+        return true;
+    }
+    if (!log->io.read(log->io.ctx, block_offset(log, phys) + offset, buf, len)) {
+        log->stats.io_errors++;
+        return false;
+    }
+    return true;
+}
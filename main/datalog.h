@@ -0,0 +1,100 @@
+// datalog.h
+#ifndef DATALOG_H
+#define DATALOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "telemetry_proto.h"
+#include "flash_io.h"
+
+// Registro comprimido de telemetría en flash, sólo de añadir. Cada sector es
+// un bloque autónomo:
+//
+//   cabecera (24 B) | cierre (16 B) | muestras
+//
+// La cabecera se escribe al abrir el bloque y lleva la primera muestra
+// completa; el cierre (nº de muestras, último ts, longitud y CRC de los datos)
+// se escribe al llenarlo. Cada muestra siguiente ocupa 1 byte de control
+// (bits 0..3: campos TP_FIELD_* que cambian, bits 4..7: dt - 1, o 14 si el dt
+// sigue como varint) más el delta zigzag-varint de cada campo que cambia
+// (ERR, byte tal cual). Un byte de control 0xFF marca el final de los datos.
+// Los bloques se reciclan en círculo: abrir uno borra el más antiguo.
+//
+// Sin dependencias de ESP-IDF; la memoria la pone el llamador.
+
+#define DATALOG_HEADER_SIZE 24
+#define DATALOG_DATA_OFFSET 40      // Cabecera + cierre
+#define DATALOG_MAX_SAMPLE 18       // Peor caso de una muestra codificada
+
+typedef struct {
+    uint32_t ts;            // Segundos de tiempo de log, no decreciente
+    tp_data_t data;
+} datalog_sample_t;
+
+// Índice en RAM: una entrada por bloque físico
+typedef struct {
+    uint32_t seq;           // Crece con cada bloque abierto; 0 = vacío o inválido
+    uint32_t first_ts;
+    uint32_t last_ts;
+    uint32_t count;         // Muestras
+    uint32_t len;           // Bytes ocupados, cabecera incluida
+} datalog_block_info_t;
+
+typedef struct {
+    uint32_t samples;       // Muestras añadidas en este arranque
+    uint32_t erases;        // Bloques borrados en este arranque
+    uint32_t recovered;     // Muestras recuperadas del bloque abierto al montar
+    uint32_t corrupt;       // Bloques descartados por cabecera o datos inválidos
+    uint32_t io_errors;     // Fallos de lectura/escritura/borrado
+} datalog_stats_t;
+
+typedef struct {
+    flash_io_t io;
+    datalog_block_info_t *index;    // io.sector_count entradas
+    uint8_t *block;         // Copia en RAM del bloque abierto (io.sector_size)
+    uint32_t head;          // Bloque físico más reciente
+    uint32_t blocks;        // Bloques válidos consecutivos que terminan en head
+    uint32_t flushed;       // Bytes de head ya escritos en flash
+    bool open;              // head admite más muestras
+    datalog_sample_t last;  // Referencia de los deltas
+    datalog_stats_t stats;
+} datalog_t;
+
+// Se llama para cada muestra decodificada; false detiene el recorrido
+typedef bool (*datalog_sample_cb_t)(const datalog_sample_t *sample, void *ctx);
+
+// Lee el índice de todos los bloques y recupera el bloque abierto (las
+// muestras ya escritas siguen ahí). index y block los pone el llamador.
+bool datalog_mount(datalog_t *log, const flash_io_t *io, datalog_block_info_t *index, uint8_t *block);
+
+// Codifica la muestra en RAM; sólo toca la flash al cambiar de bloque (cierre,
+// borrado del siguiente y su cabecera). Coste constante.
+bool datalog_append(datalog_t *log, const datalog_sample_t *sample);
+
+// Escribe en flash lo codificado desde el último flush
+bool datalog_flush(datalog_t *log);
+
+static inline uint32_t datalog_pending(const datalog_t *log) {
+    return log->blocks > 0 ? log->index[log->head].len - log->flushed : 0;
+}
+
+// Última muestra registrada (también tras montar); false si el log está vacío
+bool datalog_last(const datalog_t *log, datalog_sample_t *out);
+
+// Bloque por orden cronológico (0 = el más antiguo); false si no existe
+bool datalog_block(const datalog_t *log, uint32_t ordinal, uint32_t *phys, datalog_block_info_t *info);
+
+// Primer bloque (ordinal) que contiene muestras con ts >= from_ts; búsqueda
+// binaria en el índice. Devuelve log->blocks si no hay ninguno.
+uint32_t datalog_find(const datalog_t *log, uint32_t from_ts);
+
+// Bytes en crudo de un bloque; el abierto se lee de RAM, con lo aún no escrito
+bool datalog_read(datalog_t *log, uint32_t phys, uint32_t offset, void *buf, size_t len);
+
+// Decodifica un bloque en crudo de len bytes. Devuelve las muestras leídas
+// (0 si la cabecera no es válida); *end = bytes válidos al terminar.
+uint32_t datalog_decode(const uint8_t *block, uint32_t len, datalog_sample_cb_t cb, void *ctx,
+                        uint32_t *end);
+
+#endif // DATALOG_H
@@ -0,0 +1,267 @@
+#include "datalog_service.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "uart_config.h"
+#include "uart_utils.h"
+#include "telemetry_store.h"
+#include "sched_profile.h"
+#include "trace.h"
+
+#define NOTIFY_EXPORT 0x01
+#define NOTIFY_INFO 0x02
+
+static const esp_partition_t *partition = NULL;
+static datalog_t dlog;
+static bool dlog_ready = false;
+
+static TaskHandle_t task_handle = NULL;
+static uint32_t time_base;          // ts = time_base + segundos desde el arranque
+static uint32_t last_publishes;     // Publicaciones del store en la última muestra
+static uint32_t last_flush_ts;
+static TickType_t next_sample;
+
+// Rango del último DLOG:EXPORT; lo escribe la tarea parser
+static portMUX_TYPE request_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t export_from;
+static uint32_t export_to;
+
+static bool part_read(void *ctx, uint32_t offset, void *buf, size_t len) {
+    return esp_partition_read(ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool part_write(void *ctx, uint32_t offset, const void *buf, size_t len) {
+    return esp_partition_write(ctx, offset, buf, len) == ESP_OK;
+}
+
+static bool part_erase(void *ctx, uint32_t offset, size_t len) {
+    return esp_partition_erase_range(ctx, offset, len) == ESP_OK;
+}
+
+static uint32_t log_now(void) {
+    return time_base + (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// Tarea parser: sólo apunta la petición, el volcado lo hace datalog_task
+static void dlog_command_handler(const char *data) {
+    const char *arg = strchr(data, ':');
+    if (arg == NULL || task_handle == NULL) {
+        return;
+    }
+    arg++;
+    if (strncmp(arg, "EXPORT", 6) == 0) {
+        uint32_t from = 0;
+        uint32_t to = UINT32_MAX;
+        if (arg[6] == '=') {
+            char *end;
+            from = strtoul(arg + 7, &end, 10);
+            if (*end == ',') {
+                to = strtoul(end + 1, NULL, 10);
+            }
+        }
+        portENTER_CRITICAL(&request_mux);
+        export_from = from;
+        export_to = to;
+        portEXIT_CRITICAL(&request_mux);
+        xTaskNotify(task_handle, NOTIFY_EXPORT, eSetBits);
+    } else if (strncmp(arg, "INFO", 4) == 0) {
+        xTaskNotify(task_handle, NOTIFY_INFO, eSetBits);
+    }
+}
+
+void datalog_service_init(void) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, DATALOG_PARTITION_SUBTYPE,
+                                         DATALOG_PARTITION);
+    if (partition == NULL) {
+        ESP_LOGW("DATALOG", "Sin partición '%s': registro desactivado", DATALOG_PARTITION);
+        return;
+    }
+    flash_io_t io = {
+        .read = part_read,
+        .write = part_write,
+        .erase = part_erase,
+        .ctx = (void *)partition,
+        .sector_size = partition->erase_size,
+        .sector_count = partition->size / partition->erase_size,
+    };
+    datalog_block_info_t *index = heap_caps_calloc(io.sector_count, sizeof(datalog_block_info_t),
+                                                   MALLOC_CAP_SPIRAM);
+    uint8_t *block = heap_caps_malloc(io.sector_size, MALLOC_CAP_SPIRAM);
+    if (index == NULL || block == NULL || !datalog_mount(&dlog, &io, index, block)) {
+        ESP_LOGE("DATALOG", "No se pudo montar la partición '%s'", DATALOG_PARTITION);
+        heap_caps_free(index);
+        heap_caps_free(block);
+        return;
+    }
+    dlog_ready = true;
+
+    datalog_sample_t last;
+    if (datalog_last(&dlog, &last)) {
+        time_base = last.ts + 1;
+    }
+    last_flush_ts = log_now();
+    uart_register_handler("DLOG", dlog_command_handler);
+    ESP_LOGI("DATALOG", "%lu bloques en uso de %lu, %lu muestras recuperadas, ts=%lu",
+             (unsigned long)dlog.blocks, (unsigned long)io.sector_count,
+             (unsigned long)dlog.stats.recovered, (unsigned long)time_base);
+}
+
+bool datalog_service_last(tp_data_t *out) {
+    datalog_sample_t last;
+    if (!dlog_ready || !datalog_last(&dlog, &last)) {
+        return false;
+    }
+    *out = last.data;
+    return true;
+}
+
+static void take_sample(void) {
+    telemetry_store_stats_t store_stats;
+    telemetry_store_get_stats(&store_stats);
+    // Sin tramas nuevas no se repite el último valor: queda un hueco en el log
+    if (store_stats.publishes == last_publishes) {
+        return;
+    }
+    datalog_sample_t sample = { .ts = log_now() };
+    if (!telemetry_store_read(&sample.data)) {
+        return;
+    }
+    last_publishes = store_stats.publishes;
+
+    if (!datalog_append(&dlog, &sample)) {
+        TRACE(DATALOG_ERR, dlog.stats.io_errors, dlog.blocks, 0);
+    }
+    // Escrituras de DATALOG_WRITE_CHUNK bytes; como mucho DATALOG_FLUSH_S sin escribir
+    if (datalog_pending(&dlog) >= DATALOG_WRITE_CHUNK ||
+        (datalog_pending(&dlog) > 0 && sample.ts - last_flush_ts >= DATALOG_FLUSH_S)) {
+        if (!datalog_flush(&dlog)) {
+            TRACE(DATALOG_ERR, dlog.stats.io_errors, dlog.blocks, 0);
+        }
+        last_flush_ts = sample.ts;
+    }
+}
+
+// Muestra si toca; también se llama entre líneas de un volcado largo
+static void poll_sample(void) {
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(now - next_sample) < 0) {
+        return;
+    }
+    next_sample += pdMS_TO_TICKS(DATALOG_PERIOD_S * 1000);
+    if ((int32_t)(now - next_sample) >= 0) {
+        next_sample = now + pdMS_TO_TICKS(DATALOG_PERIOD_S * 1000); // Muy atrasado: no recuperar
+    }
+    sched_periodic_mark(SCHED_PERIODIC_DATALOG);
+    take_sample();
+}
+
+static void export_block(uint32_t phys, const datalog_block_info_t *info) {
+    static const char hex[] = "0123456789abcdef";
+    uint8_t buf[DATALOG_EXPORT_LINE];
+    char line[DATALOG_EXPORT_LINE * 2 + 1];
+
+    printf("DL B %08lx %08lx %08lx %08lx %04lx\n", (unsigned long)info->seq,
+           (unsigned long)info->first_ts, (unsigned long)info->last_ts,
+           (unsigned long)info->count, (unsigned long)info->len);
+    for (uint32_t offset = 0; offset < info->len; offset += DATALOG_EXPORT_LINE) {
+        uint32_t n = info->len - offset < DATALOG_EXPORT_LINE ? info->len - offset : DATALOG_EXPORT_LINE;
+        // El muestreo sigue durante el volcado y puede reciclar este bloque
+        if (dlog.index[phys].seq != info->seq || !datalog_read(&dlog, phys, offset, buf, n)) {
+            printf("DL X %08lx\n", (unsigned long)info->seq);
+            return;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            line[2 * i] = hex[buf[i] >> 4];
+            line[2 * i + 1] = hex[buf[i] & 0x0F];
+        }
+        line[2 * n] = '\0';
+        printf("DL D %04lx %s\n", (unsigned long)offset, line);
+        poll_sample();
+    }
+}
+
+// Recorre por seq: los ordinales se desplazan si durante el volcado se recicla un bloque
+static void export_range(uint32_t from, uint32_t to) {
+    uint32_t sent = 0;
+    uint32_t ordinal = datalog_find(&dlog, from);
+    datalog_block_info_t info;
+    uint32_t phys;
+
+    printf("DL BEGIN %08lx %08lx %08lx\n", (unsigned long)from, (unsigned long)to, (unsigned long)log_now());
+    if (datalog_block(&dlog, ordinal, &phys, &info)) {
+        uint32_t seq = info.seq;
+        while (true) {
+            datalog_block_info_t oldest;
+            if (!datalog_block(&dlog, 0, NULL, &oldest)) {
+                break;
+            }
+            if ((int32_t)(seq - oldest.seq) < 0) {
+                seq = oldest.seq;
+            }
+            if (!datalog_block(&dlog, seq - oldest.seq, &phys, &info) || info.first_ts > to) {
+                break;
+            }
+            export_block(phys, &info);
+            sent++;
+            seq++;
+        }
+    }
+    printf("DL END %08lx\n", (unsigned long)sent);
+}
+
+static void print_info(void) {
+    datalog_block_info_t first;
+    datalog_block_info_t last;
+    uint32_t samples = 0;
+    uint32_t bytes = 0;
+
+    for (uint32_t k = 0; datalog_block(&dlog, k, NULL, &last); k++) {
+        samples += last.count;
+        bytes += last.len;
+    }
+    if (!datalog_block(&dlog, 0, NULL, &first)) {
+        ESP_LOGI("DATALOG", "Vacío, ts=%lu", (unsigned long)log_now());
+        return;
+    }
+    ESP_LOGI("DATALOG", "%lu bloques, %lu muestras en %lu bytes, ts %lu..%lu (ahora %lu)",
+             (unsigned long)dlog.blocks, (unsigned long)samples, (unsigned long)bytes,
+             (unsigned long)first.first_ts, (unsigned long)last.last_ts, (unsigned long)log_now());
+    ESP_LOGI("DATALOG", "Arranque: %lu muestras, %lu borrados, %lu recuperadas, %lu corruptos, %lu errores de flash",
+             (unsigned long)dlog.stats.samples, (unsigned long)dlog.stats.erases,
+             (unsigned long)dlog.stats.recovered, (unsigned long)dlog.stats.corrupt,
+             (unsigned long)dlog.stats.io_errors);
+}
+
+void datalog_task(void *arg) {
+    task_handle = xTaskGetCurrentTaskHandle();
+    next_sample = xTaskGetTickCount();
+
+    while (true) {
+        uint32_t bits = 0;
+        TickType_t now = xTaskGetTickCount();
+        TickType_t wait = (int32_t)(next_sample - now) > 0 ? next_sample - now : 0;
+
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+        if (!dlog_ready) {
+            next_sample = xTaskGetTickCount() + pdMS_TO_TICKS(DATALOG_PERIOD_S * 1000);
+            continue;
+        }
+        if (bits & NOTIFY_EXPORT) {
+            portENTER_CRITICAL(&request_mux);
+            uint32_t from = export_from;
+            uint32_t to = export_to;
+            portEXIT_CRITICAL(&request_mux);
+            export_range(from, to);
+        }
+        if (bits & NOTIFY_INFO) {
+            print_info();
+        }
+        poll_sample();
+    }
+}
@@ -0,0 +1,31 @@
+// datalog_service.h
+#ifndef DATALOG_SERVICE_H
+#define DATALOG_SERVICE_H
+
+#include <stdint.h>
+#include "datalog.h"
+
+// Registro de telemetría en la partición DATALOG_PARTITION. datalog_task toma
+// una muestra del estado publicado cada DATALOG_PERIOD_S (sólo si han llegado
+// tramas desde la anterior) y la añade al log comprimido (datalog.h).
+//
+// El tiempo de log son segundos continuos entre arranques (no hay RTC): al
+// montar se sigue a partir de la última muestra guardada.
+//
+// Comandos (prefijo "DLOG"):
+//   DLOG:EXPORT                  volcado completo por la consola
+//   DLOG:EXPORT=<desde>,<hasta>  sólo los bloques con muestras en ese rango de ts
+//   DLOG:INFO                    resumen en el log
+// El volcado son líneas "DL ..." con los bloques en crudo; las decodifica
+// tools/datalog_export.py.
+
+// Monta la partición y registra el comando. Llamar antes de crear datalog_task.
+void datalog_service_init(void);
+
+// Última muestra guardada en el arranque anterior (antes de crear datalog_task)
+bool datalog_service_last(tp_data_t *out);
+
+// Tarea de baja prioridad: muestreo, escrituras en flash y volcados
+void datalog_task(void *arg);
+
+#endif // DATALOG_SERVICE_H
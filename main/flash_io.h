@@ -0,0 +1,21 @@
+// flash_io.h
+#ifndef FLASH_IO_H
+#define FLASH_IO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Acceso a una región de flash por sectores, para los logs portables
+// (alarm_flog, datalog). En el firmware lo implementan esp_partition_*;
+// en el PC, un fichero o un array en memoria.
+typedef struct {
+    bool (*read)(void *ctx, uint32_t offset, void *buf, size_t len);
+    bool (*write)(void *ctx, uint32_t offset, const void *buf, size_t len);
+    bool (*erase)(void *ctx, uint32_t offset, size_t len);   // Un sector completo
+    void *ctx;
+    uint32_t sector_size;
+    uint32_t sector_count;
+} flash_io_t;
+
+#endif // FLASH_IO_H
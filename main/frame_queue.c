@@ -0,0 +1,80 @@
+// frame_queue.c
+#include "frame_queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool frame_queue_init(frame_queue_t *q, uint32_t depth, frame_queue_policy_t policy) {
+    if (depth < 2 || (depth & (depth - 1)) != 0) {
+        return false;
+    }
+    q->slots = calloc(depth, sizeof(frame_slot_t));
+    if (q->slots == NULL) {
+        return false;
+    }
+    q->mask = depth - 1;
+    q->policy = policy;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->reading, 0);
+    q->enqueued = 0;
+    q->dropped = 0;
+    q->high_water = 0;
+    return true;
+}
+
+frame_slot_t *frame_queue_prepare(frame_queue_t *q) {
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+    while (head - tail > q->mask) {
+        if (q->policy == FRAME_QUEUE_NEVER_DROP) {
+            return NULL;
+        }
+        // Descartar la más antigua compitiendo con el consumidor por tail: si el
+        // CAS falla es que el consumidor la acaba de reclamar y ya hay hueco
+        if (atomic_compare_exchange_strong(&q->tail, &tail, tail + 1)) {
+            q->dropped++;
+            break;
+        }
+    }
+    // El consumidor puede seguir copiando un slot que ya salió de la cola (lo
+    // reclamó y después se descartaron otros): no se reutiliza hasta que acabe
+    if (atomic_load(&q->reading) == (head & q->mask) + 1) {
+        return NULL;
+    }
+    return &q->slots[head & q->mask];
+}
+
+void frame_queue_publish(frame_queue_t *q) {
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed) + 1;
+    atomic_store_explicit(&q->head, head, memory_order_release);
+
+    unsigned used = head - atomic_load_explicit(&q->tail, memory_order_relaxed);
+    q->enqueued++;
+    if (used > q->high_water) {
+        q->high_water = used;
+    }
+}
+
+bool frame_queue_pop(frame_queue_t *q, frame_slot_t *out) {
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+    // Anunciar el slot y reclamarlo (avanzar tail) antes de leerlo: a partir de
+    // ahí el productor no puede descartarlo ni escribir en él
+    do {
+        if (tail == atomic_load_explicit(&q->head, memory_order_acquire)) {
+            atomic_store_explicit(&q->reading, 0, memory_order_release);
+            return false;
+        }
+        atomic_store(&q->reading, (tail & q->mask) + 1);
+    } while (!atomic_compare_exchange_weak(&q->tail, &tail, tail + 1));
+
+    const frame_slot_t *slot = &q->slots[tail & q->mask];
+    out->t_event = slot->t_event;
+    out->binary = slot->binary;
+    out->len = slot->len;
+    memcpy(out->data, slot->data, out->len);
+    out->data[out->len] = '\0';
+    atomic_store_explicit(&q->reading, 0, memory_order_release);
+    return true;
+}
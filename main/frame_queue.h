@@ -0,0 +1,52 @@
+// frame_queue.h
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "line_framer.h"
+
+// Cola lock-free de un productor (tarea RX) y un consumidor (tarea parser).
+// Sin dependencias de ESP-IDF.
+
+typedef enum {
+    FRAME_QUEUE_DROP_OLDEST, // Telemetría: si está llena se descarta la trama más antigua
+    FRAME_QUEUE_NEVER_DROP,  // Respuestas de control: el productor espera a que haya hueco
+} frame_queue_policy_t;
+
+typedef struct {
+    int64_t t_event;                        // Instante del evento del driver (latencia)
+    uint16_t len;
+    bool binary;                            // Trama COBS pendiente de decodificar
+    char data[LINE_FRAMER_MAX_FRAME + 1];   // Terminada en '\0'
+} frame_slot_t;
+
+typedef struct {
+    frame_slot_t *slots;
+    uint32_t mask;                  // depth - 1
+    frame_queue_policy_t policy;
+    atomic_uint head;               // Sólo lo avanza el productor
+    atomic_uint tail;               // Lo avanza el consumidor al reclamar un slot (y el productor al descartar)
+    atomic_uint reading;            // Slot que copia el consumidor + 1 (0 = ninguno)
+    uint32_t enqueued;
+    uint32_t dropped;               // Tramas descartadas por DROP_OLDEST
+    uint32_t high_water;            // Ocupación máxima observada
+} frame_queue_t;
+
+// depth debe ser potencia de 2
+bool frame_queue_init(frame_queue_t *q, uint32_t depth, frame_queue_policy_t policy);
+
+// Productor: slot libre donde escribir, o NULL si la cola NEVER_DROP está llena
+// o si el slot que tocaría reutilizar aún lo está copiando el consumidor
+// (DROP_OLDEST, dura lo que una copia: reintentar)
+frame_slot_t *frame_queue_prepare(frame_queue_t *q);
+
+// Productor: publica el slot devuelto por frame_queue_prepare
+void frame_queue_publish(frame_queue_t *q);
+
+// Consumidor: copia la siguiente trama en out (sólo los len + 1 bytes útiles).
+// Devuelve false si la cola está vacía.
+bool frame_queue_pop(frame_queue_t *q, frame_slot_t *out);
+
+#endif // FRAME_QUEUE_H
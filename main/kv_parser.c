@@ -0,0 +1,187 @@
+// kv_parser.c
+#include "kv_parser.h"
+#include <string.h>
+
+// FNV-1a sobre el nombre de la clave
+static uint32_t key_hash(const char *name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)name[i]) * 16777619u;
+    }
+    return h;
+}
+
+static bool key_equals(const kv_key_t *key, const char *name, size_t len) {
+    return strncmp(key->name, name, len) == 0 && key->name[len] == '\0';
+}
+
+bool kv_registry_init(kv_registry_t *reg, const kv_key_t *keys, uint16_t count,
+                      uint16_t *index, uint16_t index_size) {
+    if (index_size < 2 * count || (index_size & (index_size - 1)) != 0) {
+        return false;
+    }
+    memset(index, 0, index_size * sizeof(index[0]));
+    reg->keys = keys;
+    reg->count = 0;
+    reg->index = index;
+    reg->mask = index_size - 1;
+
+    for (uint16_t i = 0; i < count; i++) {
+        size_t len = strlen(keys[i].name);
+        if (len == 0 || kv_registry_find(reg, keys[i].name, len) != NULL) {
+            return false;
+        }
+        uint32_t pos = key_hash(keys[i].name, len) & reg->mask;
+        while (index[pos] != 0) {
+            pos = (pos + 1) & reg->mask;
+        }
+        index[pos] = i + 1;
+        reg->count++;
+    }
+    return true;
+}
+
+const kv_key_t *kv_registry_find(const kv_registry_t *reg, const char *name, size_t len) {
+    uint32_t pos = key_hash(name, len) & reg->mask;
+    // Sondeo lineal: con el índice al 50 % como máximo las cadenas son cortas
+    while (reg->index[pos] != 0) {
+        const kv_key_t *key = &reg->keys[reg->index[pos] - 1];
+        if (key_equals(key, name, len)) {
+            return key;
+        }
+        pos = (pos + 1) & reg->mask;
+    }
+    return NULL;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// Convierte el valor [s, end) según el tipo de la clave
+static kv_result_t parse_value(const kv_key_t *key, const char *s, const char *end, int32_t *out) {
+    int64_t value = 0;
+
+    if (s == end) {
+        return KV_ERR_VALUE;
+    }
+    if (key->type == KV_TYPE_HEX) {
+        if (end - s < 3 || s[0] != '0' || (s[1] | 0x20) != 'x' || end - s > 10) {
+            return KV_ERR_VALUE;
+        }
+        for (s += 2; s < end; s++) {
+            int d = hex_digit(*s);
+            if (d < 0) {
+                return KV_ERR_VALUE;
+            }
+            value = (value << 4) | d;
+        }
+        value = (int32_t)(uint32_t)value;
+    } else {
+        bool negative = false;
+        if (*s == '-' || *s == '+') {
+            negative = (*s == '-');
+            if (++s == end) {
+                return KV_ERR_VALUE;
+            }
+        }
+        for (; s < end; s++) {
+            if (*s < '0' || *s > '9') {
+                return KV_ERR_VALUE;
+            }
+            value = value * 10 + (*s - '0');
+            if (value > (int64_t)INT32_MAX + 1) {
+                return KV_ERR_RANGE;
+            }
+        }
+        if (negative) {
+            value = -value;
+        }
+    }
+
+    kv_result_t res = kv_check(key, value);
+    if (res == KV_OK) {
+        *out = (int32_t)value;
+    }
+    return res;
+}
+
+kv_result_t kv_check(const kv_key_t *key, int64_t value) {
+    return value < key->min || value > key->max ? KV_ERR_RANGE : KV_OK;
+}
+
+kv_result_t kv_parse(const kv_registry_t *reg, const char *text, size_t len,
+                     int32_t *values, uint32_t *present, kv_error_t *err) {
+    const char *p = text;
+    const char *end = text + len;
+    kv_result_t res = KV_OK;
+    const kv_key_t *key = NULL;
+    const char *field = p;
+
+    while (p < end && *p != '\0') {
+        field = p;
+        key = NULL;
+
+        // Clave hasta '='; el separador ';' antes que '=' es un error de sintaxis
+        const char *eq = p;
+        while (eq < end && *eq != '=' && *eq != ';' && *eq != '\0') {
+            eq++;
+        }
+        if (eq == p || eq == end || *eq != '=') {
+            res = KV_ERR_SYNTAX;
+            break;
+        }
+
+        key = kv_registry_find(reg, p, (size_t)(eq - p));
+        if (key == NULL) {
+            res = KV_ERR_UNKNOWN;
+            break;
+        }
+
+        const char *value = eq + 1;
+        const char *stop = value;
+        while (stop < end && *stop != ';' && *stop != '\0') {
+            stop++;
+        }
+
+        uint32_t bit = 1u << (key->slot & 31);
+        uint32_t *word = &present[key->slot >> 5];
+        if (*word & bit) {
+            res = KV_ERR_DUPLICATE;
+            break;
+        }
+        res = parse_value(key, value, stop, &values[key->slot]);
+        if (res != KV_OK) {
+            break;
+        }
+        *word |= bit;
+
+        p = (stop < end && *stop == ';') ? stop + 1 : stop;
+    }
+
+    if (err != NULL) {
+        err->result = res;
+        err->offset = res == KV_OK ? 0 : (size_t)(field - text);
+        err->key = res == KV_OK ? NULL : key;
+    }
+    return res;
+}
+
+const char *kv_result_str(kv_result_t res) {
+    switch (res) {
+    case KV_OK: return "ok";
+    case KV_ERR_SYNTAX: return "syntax";
+    case KV_ERR_UNKNOWN: return "unknown key";
+    case KV_ERR_VALUE: return "bad value";
+    case KV_ERR_RANGE: return "out of range";
+    case KV_ERR_DUPLICATE: return "duplicate";
+    default: return "?";
+    }
+}
@@ -0,0 +1,75 @@
+// kv_parser.h
+#ifndef KV_PARSER_H
+#define KV_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Tokenizador de una pasada para cuerpos "CLAVE=valor;CLAVE=valor;..." guiado por
+// un registro de claves constante. Reentrante y sin copias: trabaja sobre la trama
+// original sin modificarla y escribe cada valor en su hueco del array de destino.
+// La búsqueda de la clave usa un índice hash, así que el coste por campo no
+// depende del número de claves registradas. Sin dependencias de ESP-IDF.
+
+typedef enum {
+    KV_TYPE_INT,    // Entero decimal con signo
+    KV_TYPE_BOOL,   // 0 ó 1
+    KV_TYPE_HEX,    // 0x seguido de hasta 8 cifras hexadecimales
+} kv_type_t;
+
+typedef struct {
+    const char *name;
+    kv_type_t type;
+    int32_t min;
+    int32_t max;
+    uint16_t slot;      // Índice en el array de valores (y bit en `present`)
+} kv_key_t;
+
+typedef struct {
+    const kv_key_t *keys;
+    uint16_t count;
+    uint16_t *index;    // Tabla hash: posición en `keys` + 1, 0 = libre
+    uint16_t mask;      // Tamaño del índice - 1 (potencia de 2 >= 2 * count)
+} kv_registry_t;
+
+typedef enum {
+    KV_OK = 0,
+    KV_ERR_SYNTAX,      // Campo sin '=' o clave vacía
+    KV_ERR_UNKNOWN,     // Clave no registrada
+    KV_ERR_VALUE,       // Valor vacío o con caracteres no válidos para su tipo
+    KV_ERR_RANGE,       // Valor fuera de [min, max]
+    KV_ERR_DUPLICATE,   // Clave repetida en la misma trama
+} kv_result_t;
+
+typedef struct {
+    kv_result_t result;
+    size_t offset;          // Byte del cuerpo donde empieza el campo erróneo
+    const kv_key_t *key;    // Clave afectada (NULL si no se llegó a identificar)
+} kv_error_t;
+
+// Tamaño del índice para `count` claves (potencia de 2 >= 2 * count)
+#define KV_INDEX_SIZE(count) \
+    ((count) <= 4 ? 8 : (count) <= 8 ? 16 : (count) <= 16 ? 32 : (count) <= 32 ? 64 : \
+     (count) <= 64 ? 128 : (count) <= 128 ? 256 : (count) <= 256 ? 512 : 1024)
+
+// Construye el índice en `index` (KV_INDEX_SIZE(count) entradas, memoria del llamador).
+// Falla si hay claves duplicadas o demasiadas claves.
+bool kv_registry_init(kv_registry_t *reg, const kv_key_t *keys, uint16_t count,
+                      uint16_t *index, uint16_t index_size);
+
+const kv_key_t *kv_registry_find(const kv_registry_t *reg, const char *name, size_t len);
+
+// Recorre los `len` bytes de `text` (o hasta un '\0'). Escribe values[key->slot] y
+// marca el bit key->slot en `present` (palabras de 32 bits, puestas a 0 por el llamador).
+// Se detiene en el primer error: el llamador debe descartar la trama completa.
+kv_result_t kv_parse(const kv_registry_t *reg, const char *text, size_t len,
+                     int32_t *values, uint32_t *present, kv_error_t *err);
+
+// Comprueba un valor que no viene de texto (p. ej. de una trama binaria) con
+// los mismos límites que aplica kv_parse: KV_OK o KV_ERR_RANGE
+kv_result_t kv_check(const kv_key_t *key, int64_t value);
+
+const char *kv_result_str(kv_result_t res);
+
+#endif // KV_PARSER_H
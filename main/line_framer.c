@@ -0,0 +1,114 @@
+// line_framer.c
+#include "line_framer.h"
+#include <string.h>
+
+#define RING_MASK (LINE_FRAMER_RING_SIZE - 1)
+
+_Static_assert((LINE_FRAMER_RING_SIZE & RING_MASK) == 0, "LINE_FRAMER_RING_SIZE debe ser potencia de 2");
+_Static_assert(LINE_FRAMER_RING_SIZE > LINE_FRAMER_MAX_FRAME, "El ring debe poder contener una trama completa");
+
+void line_framer_init(line_framer_t *f, char delimiter) {
+    memset(f, 0, sizeof(*f));
+    f->delimiter = delimiter;
+}
+
+size_t line_framer_write_ptr(line_framer_t *f, char **ptr) {
+    size_t used = f->head - f->tail;
+    size_t free_space = LINE_FRAMER_RING_SIZE - used;
+    size_t offset = f->head & RING_MASK;
+    size_t contiguous = LINE_FRAMER_RING_SIZE - offset;
+
+    *ptr = &f->buf[offset];
+    return free_space < contiguous ? free_space : contiguous;
+}
+
+void line_framer_commit(line_framer_t *f, size_t n) {
+    f->head += n;
+}
+
+size_t line_framer_push(line_framer_t *f, const void *data, size_t len) {
+    const char *src = data;
+    size_t total = 0;
+
+    // Dos vueltas como máximo: hasta el final del ring y desde el principio
+    while (total < len) {
+        char *dst;
+        size_t room = line_framer_write_ptr(f, &dst);
+        if (room == 0) {
+            break;
+        }
+        size_t n = len - total < room ? len - total : room;
+        memcpy(dst, src + total, n);
+        line_framer_commit(f, n);
+        total += n;
+    }
+    return total;
+}
+
+// Busca el terminador entre scan y head, sin volver a examinar bytes ya vistos
+static bool find_delimiter(line_framer_t *f, size_t *pos) {
+    while (f->scan != f->head) {
+        size_t offset = f->scan & RING_MASK;
+        size_t avail = f->head - f->scan;
+        size_t contiguous = LINE_FRAMER_RING_SIZE - offset;
+        size_t n = avail < contiguous ? avail : contiguous;
+
+        const char *hit = memchr(&f->buf[offset], f->delimiter, n);
+        if (hit != NULL) {
+            *pos = f->scan + (size_t)(hit - &f->buf[offset]);
+            f->scan = *pos + 1;
+            return true;
+        }
+        f->scan += n;
+    }
+    return false;
+}
+
+bool line_framer_next(line_framer_t *f, line_frame_t *out) {
+    size_t pos;
+
+    while (find_delimiter(f, &pos)) {
+        size_t start = f->tail;
+        size_t len = pos - start;
+        f->tail = pos + 1;
+
+        if (f->discarding) {
+            // Fin de la trama truncada: a partir de aquí volvemos a estar sincronizados
+            f->discarding = false;
+            f->dropped_bytes += len + 1;
+            continue;
+        }
+        if (len > LINE_FRAMER_MAX_FRAME) {
+            f->overflows++;
+            f->dropped_bytes += len + 1;
+            continue;
+        }
+
+        size_t offset = start & RING_MASK;
+        if (offset + len > LINE_FRAMER_RING_SIZE) {
+            // La trama da la vuelta: copiar sólo el trozo inicial al área extra
+            memcpy(&f->buf[LINE_FRAMER_RING_SIZE], f->buf, offset + len - LINE_FRAMER_RING_SIZE);
+        }
+        char *frame = &f->buf[offset];
+        if (f->delimiter == '\n' && len > 0 && frame[len - 1] == '\r') {
+            len--;
+        }
+        frame[len] = '\0';
+
+        f->frames++;
+        out->data = frame;
+        out->len = len;
+        return true;
+    }
+
+    // Sin terminador: si la trama parcial ya no cabe, descartarla y resincronizar
+    if (f->head - f->tail > LINE_FRAMER_MAX_FRAME) {
+        if (!f->discarding) {
+            f->overflows++;
+            f->discarding = true;
+        }
+        f->dropped_bytes += f->head - f->tail;
+        f->tail = f->head;
+    }
+    return false;
+}
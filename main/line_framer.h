@@ -0,0 +1,49 @@
+// line_framer.h
+#ifndef LINE_FRAMER_H
+#define LINE_FRAMER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Sin dependencias de ESP-IDF: compila también para el target `linux`
+
+#define LINE_FRAMER_RING_SIZE 4096  // Debe ser potencia de 2
+#define LINE_FRAMER_MAX_FRAME 1024  // Longitud máxima de una trama (sin terminador)
+
+// Trama entregada al consumidor: apunta dentro del ring buffer (sin copia).
+// Termina en '\0' y es válida hasta la siguiente llamada a write/commit/push.
+typedef struct {
+    const char *data;
+    size_t len;
+} line_frame_t;
+
+typedef struct {
+    // Espacio extra tras el ring para linealizar las tramas que dan la vuelta
+    char buf[LINE_FRAMER_RING_SIZE + LINE_FRAMER_MAX_FRAME + 1];
+    size_t head;        // Índice de escritura (monótono)
+    size_t tail;        // Inicio de la trama en curso (monótono)
+    size_t scan;        // Siguiente byte por examinar: cada byte se examina una sola vez
+    char delimiter;     // Terminador de trama
+    bool discarding;    // Resincronizando tras un desborde: se descarta hasta el próximo terminador
+    uint32_t frames;          // Tramas entregadas
+    uint32_t overflows;       // Tramas descartadas por exceder LINE_FRAMER_MAX_FRAME
+    uint32_t dropped_bytes;   // Bytes descartados durante la resincronización
+} line_framer_t;
+
+// Inicializa el framer con el terminador indicado
+void line_framer_init(line_framer_t *f, char delimiter);
+
+// Devuelve un puntero al hueco contiguo libre del ring para leer directamente en él
+size_t line_framer_write_ptr(line_framer_t *f, char **ptr);
+
+// Confirma que se escribieron n bytes en el hueco devuelto por line_framer_write_ptr
+void line_framer_commit(line_framer_t *f, size_t n);
+
+// Copia datos al ring; devuelve cuántos bytes se aceptaron
+size_t line_framer_push(line_framer_t *f, const void *data, size_t len);
+
+// Extrae la siguiente trama completa; false si no hay ninguna
+bool line_framer_next(line_framer_t *f, line_frame_t *out);
+
+#endif // LINE_FRAMER_H
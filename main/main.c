@@ -1,3 +1,4 @@
+#include <stdlib.h>
 #include "esp_check.h"
 
 #include "bsp.h"
@@ -9,34 +10,44 @@
 #include "lv_examples.h"
 #include "lv_demos.h"
 
-#include "nav_panel.h"
-#include "screens.h"
+#include "screen_manager.h"
 #include "settings_screen.h"
+#include "alarm_log.h"
+#include "datalog_service.h"
+#include "settings_store.h"
+#include "telemetry_store.h"
+#include "boot_profile.h"
+#include "render_profile.h"
+#include "render_bench.h"
+#include "rgb565_kernels.h"
+#include "sched_profile.h"
+#include "nvs_flash.h"
+#include "esp_system.h"
+#include "freertos/semphr.h"
 #include "driver/uart.h"
 #include "uart_config.h"
 #include "uart_utils.h"
+#include "uart_tx.h"
+#include "trace.h"
+#include "ui_update.h"
 
 #include "lvgl.h" // Asegúrate de incluir el encabezado de LVGL
 LV_FONT_DECLARE(lv_font_montserrat_20); // Declarar la fuente habilitada
 
 
-// codigo de navegación
-lv_obj_t *main_screen;
-lv_obj_t *settings_screen;
+// Pantallas que recorre RENDER:BENCH (se crean si hace falta)
+static lv_obj_t *bench_main_screen(void) { return screen_manager_get(SCREEN_MAIN); }
+static lv_obj_t *bench_settings_screen(void) { return screen_manager_get(SCREEN_SETTINGS); }
+static lv_obj_t *bench_alarm_log_screen(void) { return screen_manager_get(SCREEN_ALARMS); }
+static lv_obj_t *bench_trend_screen(void) { return screen_manager_get(SCREEN_TRENDS); }
 
-/* Callbacks para navegación */
-void go_to_main_screen(void) {
-    lv_scr_load(main_screen);
-}
-
-void go_to_settings_screen(void) {
-    lv_scr_load(settings_screen);
-}
+static const render_bench_screen_t bench_screens[] = {
+    { "main", bench_main_screen },
+    { "settings", bench_settings_screen },
+    { "alarms", bench_alarm_log_screen },
+    { "trends", bench_trend_screen },
+};
 
-void go_back(void) {
-    lv_scr_load(main_screen); // Por simplicidad, siempre volvemos a la principal
-}
-//fin de la sección de código de navegación
 // Tarea para manejar LVGL
 void lvgl_task(void *pvParameter) {
     while (1) {
@@ -45,15 +56,7 @@ void lvgl_task(void *pvParameter) {
     }
 }
 
-/* LCD settings */
-#define APP_LCD_LVGL_FULL_REFRESH           (0)
-#define APP_LCD_LVGL_DIRECT_MODE            (1)
-#define APP_LCD_LVGL_AVOID_TEAR             (1)
-#define APP_LCD_RGB_BOUNCE_BUFFER_MODE      (1)
-#define APP_LCD_DRAW_BUFF_DOUBLE            (0)
-#define APP_LCD_DRAW_BUFF_HEIGHT            (100)
-#define APP_LCD_RGB_BUFFER_NUMS             (2)
-#define APP_LCD_RGB_BOUNCE_BUFFER_HEIGHT    (10)
+/* LCD settings: perfil de render elegido en NVS (render_profiles.h) */
 
 static esp_lcd_panel_handle_t lcd_panel = NULL;
 
@@ -67,7 +70,7 @@ static lv_indev_t *lvgl_touch_indev = NULL;
 
 static const char TAG[] = "rgb_panel_v2";
 
-static esp_err_t app_lcd_init(esp_lcd_panel_handle_t *lp)
+static esp_err_t app_lcd_init(const render_profile_t *rp, esp_lcd_panel_handle_t *lp)
 {
     esp_err_t ret = ESP_OK;
 
@@ -76,10 +79,8 @@ static esp_err_t app_lcd_init(esp_lcd_panel_handle_t *lp)
         .clk_src = LCD_CLK_SRC_DEFAULT,
         .timings = BSP_LCD_PANEL_TIMING(),
         .data_width = 16,
-        .num_fbs = APP_LCD_RGB_BUFFER_NUMS,
-#ifdef APP_LCD_RGB_BOUNCE_BUFFER_MODE
-        .bounce_buffer_size_px = BSP_LCD_H_RES * APP_LCD_RGB_BOUNCE_BUFFER_HEIGHT,
-#endif
+        .num_fbs = rp->num_fbs,
+        .bounce_buffer_size_px = BSP_LCD_H_RES * rp->bounce_lines,
         .hsync_gpio_num = BSP_LCD_GPIO_HSYNC,
         .vsync_gpio_num = BSP_LCD_GPIO_VSYNC,
         .de_gpio_num = BSP_LCD_GPIO_DE,
@@ -141,30 +142,30 @@ static esp_err_t app_touch_init(i2c_master_bus_handle_t *bus,
     return esp_lcd_touch_new_i2c_gt911(*tp_io, &tp_cfg, tp);
 }
 
-static esp_err_t app_lvgl_init(esp_lcd_panel_handle_t lp, esp_lcd_touch_handle_t tp,
-                               lv_display_t **lv_disp, lv_indev_t **lv_touch_indev)
+static esp_err_t app_lvgl_init(const render_profile_t *rp, esp_lcd_panel_handle_t lp, lv_display_t **lv_disp)
 {
     /* Initialize LVGL */
     const lvgl_port_cfg_t lvgl_cfg = {
-        .task_priority = 4,         /* LVGL task priority */
-        .task_stack = 8192,         /* LVGL task stack size */
-        .task_affinity = -1,        /* LVGL task pinned to core (-1 is no affinity) */
+        .task_priority = sched_task_priority(SCHED_TASK_LVGL), /* LVGL task priority */
+        .task_stack = sched_task_stack(SCHED_TASK_LVGL),       /* LVGL task stack size */
+        .task_affinity = sched_task_core(SCHED_TASK_LVGL),     /* LVGL task pinned to core (-1 is no affinity) */
         .task_max_sleep_ms = 500,   /* Maximum sleep in LVGL task */
         .timer_period_ms = 5        /* LVGL timer tick period in ms */
     };
     ESP_RETURN_ON_ERROR(lvgl_port_init(&lvgl_cfg), TAG, "LVGL port initialization failed");
 
-    uint32_t buff_size = BSP_LCD_H_RES * APP_LCD_DRAW_BUFF_HEIGHT;
-#if APP_LCD_LVGL_FULL_REFRESH || APP_LCD_LVGL_DIRECT_MODE
-    buff_size = BSP_LCD_H_RES * BSP_LCD_V_RES;
-#endif
+    // En DIRECT y FULL LVGL dibuja sobre los framebuffers del panel
+    uint32_t buff_size = BSP_LCD_H_RES * rp->draw_lines;
+    if (rp->mode != RENDER_MODE_PARTIAL) {
+        buff_size = BSP_LCD_H_RES * BSP_LCD_V_RES;
+    }
 
     /* Add LCD screen */
     ESP_LOGD(TAG, "Add LCD screen");
     const lvgl_port_display_cfg_t disp_cfg = {
         .panel_handle = lp,
         .buffer_size = buff_size,
-        .double_buffer = APP_LCD_DRAW_BUFF_DOUBLE,
+        .double_buffer = rp->draw_buffers == 2,
         .hres = BSP_LCD_H_RES,
         .vres = BSP_LCD_V_RES,
         .monochrome = false,
@@ -177,13 +178,10 @@ static esp_err_t app_lvgl_init(esp_lcd_panel_handle_t lp, esp_lcd_touch_handle_t
             .mirror_y = false,
         },
         .flags = {
-            .buff_dma = false,
+            .buff_dma = rp->mode == RENDER_MODE_PARTIAL,   /* Búferes parciales en SRAM interna */
             .buff_spiram = false,
-#if APP_LCD_LVGL_FULL_REFRESH
-            .full_refresh = true,
-#elif APP_LCD_LVGL_DIRECT_MODE
-            .direct_mode = true,
-#endif
+            .full_refresh = rp->mode == RENDER_MODE_FULL,
+            .direct_mode = rp->mode == RENDER_MODE_DIRECT,
 #if LVGL_VERSION_MAJOR >= 9
             .swap_bytes = false,
 #endif
@@ -191,32 +189,146 @@ static esp_err_t app_lvgl_init(esp_lcd_panel_handle_t lp, esp_lcd_touch_handle_t
     };
     const lvgl_port_display_rgb_cfg_t rgb_cfg = {
         .flags = {
-#if APP_LCD_RGB_BOUNCE_BUFFER_MODE
-            .bb_mode = true,
-#else
-            .bb_mode = false,
-#endif
-#if APP_LCD_LVGL_AVOID_TEAR
-            .avoid_tearing = true,
-#else
-            .avoid_tearing = false,
-#endif
+            .bb_mode = rp->bounce_lines > 0,
+            .avoid_tearing = rp->avoid_tearing,
         }
     };
     *lv_disp = lvgl_port_add_disp_rgb(&disp_cfg, &rgb_cfg);
 
-    /* Add touch input (for selected screen) */
+    return *lv_disp != NULL ? ESP_OK : ESP_FAIL;
+}
+
+/* El táctil se añade aparte: su inicialización va en paralelo con la del panel */
+static esp_err_t app_lvgl_add_touch(lv_display_t *lv_disp, esp_lcd_touch_handle_t tp, lv_indev_t **lv_touch_indev)
+{
     const lvgl_port_touch_cfg_t touch_cfg = {
-        .disp = *lv_disp,
+        .disp = lv_disp,
         .handle = tp,
     };
     *lv_touch_indev = lvgl_port_add_touch(&touch_cfg);
+    return *lv_touch_indev != NULL ? ESP_OK : ESP_FAIL;
+}
+
+// I2C + GT911 (reset y esperas del controlador) mientras app_main levanta el panel RGB
+static SemaphoreHandle_t touch_done = NULL;
+static esp_err_t touch_err = ESP_FAIL;
+
+// Núcleos RGB565 de los blends de LVGL: si los vectoriales no dan lo mismo que
+// la referencia píxel a píxel, se vuelve a los escalares
+static void kernels_self_test(void)
+{
+    uint16_t *scratch = malloc(RGB565_SELF_TEST_PIXELS * sizeof(uint16_t));
+    if (scratch == NULL) {
+        return;
+    }
+    unsigned failed = rgb565_kernels_self_test(scratch, RGB565_SELF_TEST_PIXELS);
+    if (failed != 0 && rgb565_kernels_simd()) {
+        ESP_LOGE("MAIN", "Núcleos RGB565 vectoriales incorrectos (0x%x): se usan los escalares", failed);
+        rgb565_kernels_set_simd(false);
+        failed = rgb565_kernels_self_test(scratch, RGB565_SELF_TEST_PIXELS);
+    }
+    if (failed != 0) {
+        ESP_LOGE("MAIN", "Núcleos RGB565 escalares incorrectos (0x%x)", failed);
+    }
+    free(scratch);
+}
+
+// Todas las llamadas de LVGL a lv_memcpy (--wrap en CMakeLists.txt): las filas
+// que copia al sincronizar los framebuffers en modo directo van por rgb565_copy
+void *__wrap_lv_memcpy(void *dst, const void *src, size_t len)
+{
+    return rgb565_memcpy(dst, src, len);
+}
 
-    return ESP_OK;
+static void touch_init_task(void *arg)
+{
+    // La CPU está libre mientras el GT911 sale de reset
+    kernels_self_test();
+    touch_err = app_touch_init(&my_bus, &touch_io_handle, &touch_handle);
+    boot_profile_mark("touch");
+    xSemaphoreGive(touch_done);
+    vTaskDelete(NULL);
+}
+
+// Primer frame pintado: encender la retroiluminación (sin mostrar basura antes)
+static void first_frame_cb(void)
+{
+    gpio_set_level(BSP_LCD_GPIO_BK_LIGHT, BSP_LCD_BK_LIGHT_ON_LEVEL);
+}
+
+// NVS compartido por los ajustes y el perfil de render
+static void app_nvs_init(void)
+{
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        // Partición llena o de otra versión de IDF: se pierde lo guardado
+        ESP_LOGW("MAIN", "Borrando NVS (%s)", esp_err_to_name(err));
+        nvs_flash_erase();
+        err = nvs_flash_init();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE("MAIN", "NVS no disponible (%s)", esp_err_to_name(err));
+    }
+}
+
+static esp_err_t lcd_init_on_core(void *arg)
+{
+    return app_lcd_init(arg, &lcd_panel);
+}
+
+static esp_err_t uart_init_on_core(void *arg)
+{
+    return uart_utils_init() ? ESP_OK : ESP_FAIL;
+}
+
+// Marca de cada refresco del display para el jitter de SCHED:STATS
+static bool refr_jitter_hook(void)
+{
+    sched_periodic_mark(SCHED_PERIODIC_LVGL_REFR);
+    return false;
+}
+
+// Panel y LVGL con el perfil guardado. Si un perfil no por defecto no cabe en
+// memoria se olvida y se reinicia con el de por defecto, en vez de quedarse sin pantalla.
+static void app_display_init(void)
+{
+    const render_profile_t *rp = render_profile_load();
+    // La ISR del panel (relleno de los bounce buffers) queda en el núcleo que la reserva
+    esp_err_t err = sched_run_on_core(sched_lcd_isr_core(), lcd_init_on_core, (void *)rp);
+    boot_profile_mark("lcd");
+    if (err == ESP_OK) {
+        err = app_lvgl_init(rp, lcd_panel, &lvgl_disp);
+    }
+    boot_profile_mark("lvgl");
+    if (err != ESP_OK && !render_profile_is_default(rp)) {
+        ESP_LOGE("MAIN", "Perfil de render '%s' no aplicable (%s): reinicio con el de por defecto",
+                 rp->name, esp_err_to_name(err));
+        render_profile_reset();
+        esp_restart();
+    }
+    ESP_ERROR_CHECK(err);
 }
 
 void app_main(void)
 {
+    boot_profile_mark("app_main");
+    app_nvs_init();
+
+    // Retroiluminación apagada hasta el primer frame
+    const gpio_config_t bk_light = {
+        .pin_bit_mask = (1 << BSP_LCD_GPIO_BK_LIGHT),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&bk_light));
+    gpio_set_level(BSP_LCD_GPIO_BK_LIGHT, !BSP_LCD_BK_LIGHT_ON_LEVEL);
+
+    // Táctil en paralelo con el UART y el panel
+    touch_done = xSemaphoreCreateBinary();
+    xTaskCreate(touch_init_task, "touch_init", 4096, NULL, 2, NULL);
+
     // Configuración UART
     uart_config_t uart_config = {
         .baud_rate = UART_BAUD_RATE,
@@ -231,50 +343,83 @@ void app_main(void)
     // Asignar los pines GPIO17 y GPIO18 al UART1
     uart_set_pin(UART_PORT_NUM, UART_TX_PIN, UART_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
 
-    // Instalar el controlador UART con un buffer de 1024 bytes
-    uart_driver_install(UART_PORT_NUM, 4096, 0, 0, NULL, 0);
-    
-    // Inicializar UART Utils
-    if (!uart_utils_init()) {
+    // Inicializar UART Utils (instala el driver con cola de eventos; su ISR, en
+    // el núcleo que indique el plan de planificación)
+    if (sched_run_on_core(sched_uart_isr_core(), uart_init_on_core, NULL) != ESP_OK) {
         ESP_LOGE("MAIN", "Failed to initialize UART utils");
         return;
     }
+    if (!uart_tx_init()) {
+        ESP_LOGE("MAIN", "Failed to initialize UART TX");
+        return;
+    }
+    // Volcado de trazas bajo demanda: TRACE:DUMP, TRACE:RAW, TRACE:CLEAR
+    uart_register_handler("TRACE", trace_command_handler);
+    // Perfiles de render y benchmark: RENDER:LIST, RENDER:SET=<perfil>, RENDER:BENCH
+    render_profile_register_commands();
+    // Plan de planificación y medida de carga y jitter: SCHED:STATS, SCHED:RESET, SCHED:WATCH=<s>
+    sched_register_commands();
+    boot_profile_mark("uart");
+
+    // Inicializar LCD y LVGL
+    app_display_init();
+
+    // Registro comprimido de telemetría (DLOG:EXPORT para volcarlo); su última
+    // muestra es lo primero que se enseña
+    datalog_service_init();
+    boot_profile_mark("datalog");
 
-    // Inicializar LCD
-    ESP_ERROR_CHECK(app_lcd_init(&lcd_panel));
-    ESP_ERROR_CHECK(app_touch_init(&my_bus, &touch_io_handle, &touch_handle));
-    ESP_ERROR_CHECK(app_lvgl_init(lcd_panel, touch_handle, &lvgl_disp, &lvgl_touch_indev));
-    // Configuración de retroiluminación
-    const gpio_config_t bk_light = {
-        .pin_bit_mask = (1 << BSP_LCD_GPIO_BK_LIGHT),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    ESP_ERROR_CHECK(gpio_config(&bk_light));
-    gpio_set_level(BSP_LCD_GPIO_BK_LIGHT, BSP_LCD_BK_LIGHT_ON_LEVEL);
-
-    // Inicializar pantallas
-    main_screen = lv_obj_create(NULL);     // Crear objeto para la pantalla principal
-    settings_screen = lv_obj_create(NULL); // Crear objeto para la pantalla de ajustes
-
-    // Añadir contenido a las pantallas
-    create_main_screen(main_screen);       // Inicializar contenido de la pantalla principal
-    create_settings_screen(settings_screen); // Inicializar contenido de la pantalla de ajustes
-
-    // Crear el panel de navegación en ambas pantallas
     lvgl_port_lock(0);
-    create_nav_panel(main_screen, go_to_main_screen, go_to_settings_screen, go_back);
-    create_nav_panel(settings_screen, go_to_main_screen, go_to_settings_screen, go_back);
+    // Las actualizaciones de la UI se aplican una vez por refresco del display
+    ui_update_init(lvgl_disp);
+    ui_update_register(refr_jitter_hook);
+
+    // Barra de navegación y pantalla principal; el resto se construye al
+    // visitarlas por primera vez (screen_manager.h)
+    screen_manager_init(lvgl_disp);
+    tp_data_t last;
+    if (datalog_service_last(&last)) {
+        telemetry_store_restore(&last);
+    }
+    boot_profile_watch_first_frame(lvgl_disp, first_frame_cb);
+    render_bench_init(lvgl_disp, bench_screens, sizeof(bench_screens) / sizeof(bench_screens[0]));
     lvgl_port_unlock();
+    boot_profile_mark("main_screen");
+
+    // Esperar al táctil (normalmente ya ha terminado)
+    if (xSemaphoreTake(touch_done, pdMS_TO_TICKS(2000)) != pdTRUE || touch_err != ESP_OK ||
+        app_lvgl_add_touch(lvgl_disp, touch_handle, &lvgl_touch_indev) != ESP_OK) {
+        ESP_LOGE("MAIN", "Táctil no disponible (%s)", esp_err_to_name(touch_err));
+    }
+
+    // Historial de alarmas: recuperar lo guardado en flash antes de recibir tramas
+    alarm_log_init();
 
-    // Mostrar la pantalla principal al inicio
-    lv_scr_load(main_screen);
+    // Ajustes guardados en NVS; la pantalla de ajustes los toma al crearse
+    settings_store_init();
+    settings_screen_init();
+    boot_profile_mark("services");
 
     // Crear tarea para manejar LVGL
     //xTaskCreate(lvgl_task, "lvgl_task", 4096, NULL, 5, NULL);
 
-    // Crear tarea para recibir datos del UART
-    xTaskCreate(uart_receive_task, "uart_receive_task", 4096, NULL, 10, NULL);
+    // Núcleo, prioridad y pila de cada tarea: sched_tasks.h
+
+    // Crear la tarea que procesa las tramas y, después, la que las recibe del UART
+    TaskHandle_t parser_task = NULL;
+    sched_task_create(SCHED_TASK_UART_PARSER, uart_parser_task, NULL, &parser_task);
+    sched_task_create(SCHED_TASK_UART_RX, uart_receive_task, parser_task, NULL);
+
+    // Crear tarea para enviar comandos al controlador
+    sched_task_create(SCHED_TASK_UART_TX, uart_tx_task, NULL, NULL);
+
+    // Crear tarea que guarda el historial de alarmas en flash (baja prioridad)
+    sched_task_create(SCHED_TASK_ALARM_LOG, alarm_log_task, NULL, NULL);
+
+    // Crear tarea que guarda en NVS los ajustes modificados (baja prioridad)
+    sched_task_create(SCHED_TASK_SETTINGS, settings_store_task, NULL, NULL);
+
+    // Crear tarea que registra la telemetría en flash y atiende los volcados (baja prioridad)
+    sched_task_create(SCHED_TASK_DATALOG, datalog_task, NULL, NULL);
+    boot_profile_done();
 }
@@ -1,7 +1,8 @@
 #include "nav_panel.h"
 #include "logo.h" // Archivo generado con la imagen (debe estar definido como LVGL compatible)
 
-lv_obj_t *create_nav_panel(lv_obj_t *parent, nav_callback_t home_cb, nav_callback_t settings_cb, nav_callback_t back_cb) {  
+lv_obj_t *create_nav_panel(lv_obj_t *parent, nav_callback_t home_cb, nav_callback_t settings_cb, nav_callback_t alarms_cb,
+                           nav_callback_t trends_cb, nav_callback_t back_cb) {  
 
     // Crear el panel de navegación
     lv_obj_t *nav_panel = lv_obj_create(parent);
@@ -25,10 +26,18 @@ lv_obj_t *create_nav_panel(lv_obj_t *parent, nav_callback_t home_cb, nav_callbac
     lv_obj_set_width(logo_img, 70);  // Ancho máximo del logo
     lv_obj_set_height(logo_img, 70); // Altura máxima del logo
 
-    // Crear un estilo para el título
+    // Estilos compartidos: se inicializan una sola vez (lv_style_init sobre un
+    // estilo en uso perdería sus propiedades)
     static lv_style_t style_title;
-    lv_style_init(&style_title);
-    lv_style_set_text_font(&style_title, &lv_font_montserrat_20); // Aplicar la fuente de 20 píxeles
+    static lv_style_t style_button_label;
+    static bool styles_ready = false;
+    if (!styles_ready) {
+        lv_style_init(&style_title);
+        lv_style_set_text_font(&style_title, &lv_font_montserrat_20); // Aplicar la fuente de 20 píxeles
+        lv_style_init(&style_button_label);
+        lv_style_set_text_font(&style_button_label, &lv_font_montserrat_20); // Fuente Montserrat 20 píxeles
+        styles_ready = true;
+    }
 
     // Crear el título y aplicar el estilo
     lv_obj_t *title = lv_label_create(nav_panel);
@@ -36,26 +45,20 @@ lv_obj_t *create_nav_panel(lv_obj_t *parent, nav_callback_t home_cb, nav_callbac
     lv_obj_add_style(title, &style_title, 0);
     lv_obj_align(title, LV_ALIGN_LEFT_MID, 90, 0);
 
-    // Crear un estilo para los textos de los botones
-    static lv_style_t style_button_label;
-    lv_style_init(&style_button_label);
-    lv_style_set_text_font(&style_button_label, &lv_font_montserrat_20); // Fuente Montserrat 20 píxeles
-
     // Botón de inicio
     lv_obj_t *btn_home = lv_btn_create(nav_panel);
     lv_obj_set_size(btn_home, 110, 60);
-    lv_obj_align(btn_home, LV_ALIGN_CENTER, -120, 0); // Alineado cerca del centro
+    lv_obj_align(btn_home, LV_ALIGN_CENTER, -175, 0); // Alineado cerca del centro
     lv_obj_t *label_home = lv_label_create(btn_home);
     lv_label_set_text(label_home, "Inicio");
     lv_obj_add_style(label_home, &style_button_label, 0); // Aplicar el estilo
     lv_obj_center(label_home); // Centrar la etiqueta dentro del botón
-    lv_obj_center(label_home); // Centrar la etiqueta dentro del botón
     lv_obj_add_event_cb(btn_home, (lv_event_cb_t)home_cb, LV_EVENT_CLICKED, NULL);
 
     // Botón de ajustes
     lv_obj_t *btn_settings = lv_btn_create(nav_panel);
     lv_obj_set_size(btn_settings, 110, 60);
-    lv_obj_align(btn_settings, LV_ALIGN_CENTER, 20, 0); // Alineado cerca del centro
+    lv_obj_align(btn_settings, LV_ALIGN_CENTER, -60, 0); // Alineado cerca del centro
     lv_obj_t *label_settings = lv_label_create(btn_settings);
     lv_label_set_text(label_settings, "Ajustes");
     lv_obj_add_style(label_settings, &style_button_label, 0); // Aplicar el estilo
@@ -63,6 +66,26 @@ lv_obj_t *create_nav_panel(lv_obj_t *parent, nav_callback_t home_cb, nav_callbac
     // lv_obj_align(label_settings, LV_ALIGN_CENTER, -3, 0); // Mover texto ligeramente
     lv_obj_add_event_cb(btn_settings, (lv_event_cb_t)settings_cb, LV_EVENT_CLICKED, NULL);
 
+    // Botón del historial de alarmas
+    lv_obj_t *btn_alarms = lv_btn_create(nav_panel);
+    lv_obj_set_size(btn_alarms, 110, 60);
+    lv_obj_align(btn_alarms, LV_ALIGN_CENTER, 55, 0); // A continuación de ajustes
+    lv_obj_t *label_alarms = lv_label_create(btn_alarms);
+    lv_label_set_text(label_alarms, "Alarmas");
+    lv_obj_add_style(label_alarms, &style_button_label, 0); // Aplicar el estilo
+    lv_obj_center(label_alarms); // Centrar la etiqueta dentro del botón
+    lv_obj_add_event_cb(btn_alarms, (lv_event_cb_t)alarms_cb, LV_EVENT_CLICKED, NULL);
+
+    // Botón de las gráficas de tendencia
+    lv_obj_t *btn_trends = lv_btn_create(nav_panel);
+    lv_obj_set_size(btn_trends, 110, 60);
+    lv_obj_align(btn_trends, LV_ALIGN_CENTER, 170, 0); // Entre alarmas y atrás
+    lv_obj_t *label_trends = lv_label_create(btn_trends);
+    lv_label_set_text(label_trends, "Graficas");
+    lv_obj_add_style(label_trends, &style_button_label, 0); // Aplicar el estilo
+    lv_obj_center(label_trends); // Centrar la etiqueta dentro del botón
+    lv_obj_add_event_cb(btn_trends, (lv_event_cb_t)trends_cb, LV_EVENT_CLICKED, NULL);
+
     // Botón de atrás
     lv_obj_t *btn_back = lv_btn_create(nav_panel);
     lv_obj_set_size(btn_back, 110, 60);
@@ -9,11 +9,14 @@ typedef void (*nav_callback_t)(void);
 
 /**
  * @brief Crea un panel de navegación con botones.
- * @param parent El objeto padre (pantalla activa).
+ * @param parent El objeto padre (la capa superior del display: screen_manager lo crea una vez).
  * @param home_cb Callback para el botón de pantalla principal.
  * @param settings_cb Callback para el botón de ajustes.
+ * @param alarms_cb Callback para el botón del historial de alarmas.
+ * @param trends_cb Callback para el botón de las gráficas de tendencia.
  * @param back_cb Callback para el botón de atrás.
  */
-lv_obj_t *create_nav_panel(lv_obj_t *parent, nav_callback_t home_cb, nav_callback_t settings_cb, nav_callback_t back_cb);
+lv_obj_t *create_nav_panel(lv_obj_t *parent, nav_callback_t home_cb, nav_callback_t settings_cb, nav_callback_t alarms_cb,
+                           nav_callback_t trends_cb, nav_callback_t back_cb);
 
 #endif // NAV_PANEL_H
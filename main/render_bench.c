@@ -0,0 +1,392 @@
+#include "render_bench.h"
+#include <stdio.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "lv_demos.h"
+#include "bsp.h"
+#include "uart_config.h"
+#include "ui_update.h"
+#include "render_profile.h"
+#include "rgb565_kernels.h"
+#include "screen_manager.h"
+
+typedef enum {
+    SCENE_FULL,     // Pantalla entera invalidada en cada frame
+    SCENE_SCROLL,   // Primer contenedor con scroll, ida y vuelta
+    SCENE_NAV,      // Cambio de pantalla en cada frame
+} scene_kind_t;
+
+static lv_display_t *display = NULL;
+static const render_bench_screen_t *screens = NULL;
+static size_t screen_count = 0;
+static atomic_uint requested;       // RENDER_BENCH_* pendientes
+static atomic_bool running;
+
+// Estado de la escena en curso; sólo contexto de LVGL
+static struct {
+    unsigned scope;
+    size_t scene;           // 2 por pantalla (FULL, SCROLL) y NAV al final
+    scene_kind_t kind;
+    lv_obj_t *screen;
+    lv_obj_t *scroller;
+    int32_t scroll_max;
+    int32_t scroll_y;
+    int32_t scroll_step;
+    size_t nav_index;
+    lv_obj_t *home;         // Pantalla activa antes del benchmark
+    lv_obj_t *demo_screen;
+    lv_timer_t *timer;
+    int64_t start_us;       // 0 hasta el primer refresco de la escena
+    int64_t refr_start_us;
+    int64_t flush_start_us;
+    uint32_t frame_flush_us;
+    uint32_t frames;
+    uint64_t render_us;
+    uint64_t flush_us;
+    uint64_t idle_start[portNUM_PROCESSORS];
+} bench;
+
+static uint64_t idle_time(int core) {
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    return ulTaskGetIdleRunTimeCounterForCore(core);
+#else
+    (void)core;
+    return 0;
+#endif
+}
+
+// Primer descendiente cuyo contenido no cabe (scroll vertical posible)
+static lv_obj_t *find_scroller(lv_obj_t *obj) {
+    uint32_t count = lv_obj_get_child_count(obj);
+    for (uint32_t i = 0; i < count; i++) {
+        lv_obj_t *child = lv_obj_get_child(obj, (int32_t)i);
+        if (lv_obj_has_flag(child, LV_OBJ_FLAG_SCROLLABLE) && lv_obj_get_scroll_bottom(child) > 0) {
+            return child;
+        }
+        lv_obj_t *found = find_scroller(child);
+        if (found != NULL) {
+            return found;
+        }
+    }
+    return NULL;
+}
+
+static void scene_name(char *buf, size_t size) {
+    if (bench.kind == SCENE_NAV) {
+        snprintf(buf, size, "nav");
+    } else {
+        snprintf(buf, size, "%s_%s", screens[bench.scene / 2].name, bench.kind == SCENE_FULL ? "full" : "scroll");
+    }
+}
+
+// Prepara la escena bench.scene o la siguiente que se pueda medir; false si no quedan
+static bool start_scene(void) {
+    for (; bench.scene <= 2 * screen_count; bench.scene++) {
+        if (bench.scene == 2 * screen_count) {
+            if (screen_count < 2) {
+                continue;
+            }
+            bench.kind = SCENE_NAV;
+            bench.nav_index = 0;
+            bench.screen = screens[0].get();
+        } else {
+            bench.kind = bench.scene % 2 == 0 ? SCENE_FULL : SCENE_SCROLL;
+            bench.screen = screens[bench.scene / 2].get();
+        }
+        if (bench.screen == NULL) {
+            continue;
+        }
+        lv_scr_load(bench.screen);
+        if (bench.kind == SCENE_SCROLL) {
+            lv_obj_update_layout(bench.screen);
+            bench.scroller = find_scroller(bench.screen);
+            if (bench.scroller == NULL) {
+                continue;
+            }
+            bench.scroll_y = lv_obj_get_scroll_y(bench.scroller);
+            bench.scroll_max = bench.scroll_y + lv_obj_get_scroll_bottom(bench.scroller);
+            bench.scroll_step = RENDER_BENCH_SCROLL_STEP;
+        }
+        lv_obj_invalidate(bench.screen);
+        bench.start_us = 0;
+        bench.frames = 0;
+        bench.render_us = 0;
+        bench.flush_us = 0;
+        return true;
+    }
+    return false;
+}
+
+static void report_scene(int64_t now) {
+    char name[40];
+    uint32_t elapsed = (uint32_t)(now - bench.start_us);
+    uint32_t fps_x10 = (uint32_t)((uint64_t)bench.frames * 10000000u / elapsed);
+    int cpu[portNUM_PROCESSORS];
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        uint64_t idle = idle_time(c) - bench.idle_start[c];
+        cpu[c] = idle >= elapsed ? 0 : (int)(100 - idle * 100 / elapsed);
+#else
+        cpu[c] = -1;
+#endif
+    }
+    scene_name(name, sizeof(name));
+    printf("BENCH,%s,%s,%lu,%lu.%lu,%lu,%lu,%d,%d\n", render_profile_active()->name, name,
+           (unsigned long)bench.frames, (unsigned long)(fps_x10 / 10), (unsigned long)(fps_x10 % 10),
+           (unsigned long)(bench.frames ? bench.render_us / bench.frames : 0),
+           (unsigned long)(bench.frames ? bench.flush_us / bench.frames : 0),
+           cpu[0], portNUM_PROCESSORS > 1 ? cpu[portNUM_PROCESSORS - 1] : -1);
+}
+
+// false si la demo no está compilada
+static bool start_demo(void) {
+#if LV_USE_DEMO_BENCHMARK
+    // La demo se adueña de la pantalla activa y deja su resumen en el log de LVGL
+    bench.demo_screen = lv_obj_create(NULL);
+    lv_scr_load(bench.demo_screen);
+    lv_demo_benchmark();
+    printf("BENCH,%s,demo,started\n", render_profile_active()->name);
+    return true;
+#else
+    printf("BENCH,%s,demo,unavailable\n", render_profile_active()->name);
+    return false;
+#endif
+}
+
+// Vuelta a la pantalla de antes; el screen_manager puede volver a descartar
+static void release_screens(void) {
+    lv_scr_load(bench.home);
+    screen_manager_hold(false);
+}
+
+static void finish(void) {
+    lv_timer_set_period(lv_display_get_refr_timer(display), LV_DEF_REFR_PERIOD);
+    lv_timer_pause(bench.timer);
+    // Con la demo, las pantallas siguen retenidas hasta RENDER:BENCH=home
+    if (!(bench.scope & RENDER_BENCH_DEMO) || !start_demo()) {
+        release_screens();
+    }
+    printf("BENCH,%s,end\n", render_profile_active()->name);
+    atomic_store(&running, false);
+}
+
+// Al terminar un frame: preparar el siguiente según la escena
+static void next_frame(void) {
+    switch (bench.kind) {
+    case SCENE_FULL:
+        lv_obj_invalidate(bench.screen);
+        break;
+    case SCENE_SCROLL:
+        bench.scroll_y += bench.scroll_step;
+        if (bench.scroll_y >= bench.scroll_max || bench.scroll_y <= 0) {
+            bench.scroll_y = bench.scroll_y <= 0 ? 0 : bench.scroll_max;
+            bench.scroll_step = -bench.scroll_step;
+        }
+        lv_obj_scroll_to_y(bench.scroller, bench.scroll_y, LV_ANIM_OFF);
+        break;
+    case SCENE_NAV:
+        bench.nav_index = (bench.nav_index + 1) % screen_count;
+        lv_obj_t *scr = screens[bench.nav_index].get();
+        if (scr != NULL) {
+            lv_scr_load(scr);
+        }
+        break;
+    }
+}
+
+static void display_event_cb(lv_event_t *e) {
+    if (!atomic_load_explicit(&running, memory_order_relaxed) || !(bench.scope & RENDER_BENCH_SCREENS)) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_REFR_START:
+        bench.refr_start_us = now;
+        bench.frame_flush_us = 0;
+        if (bench.start_us == 0) {
+            bench.start_us = now;
+            for (int c = 0; c < portNUM_PROCESSORS; c++) {
+                bench.idle_start[c] = idle_time(c);
+            }
+        }
+        break;
+    case LV_EVENT_FLUSH_START:
+    case LV_EVENT_FLUSH_WAIT_START:
+        bench.flush_start_us = now;
+        break;
+    case LV_EVENT_FLUSH_FINISH:
+    case LV_EVENT_FLUSH_WAIT_FINISH:
+        bench.frame_flush_us += (uint32_t)(now - bench.flush_start_us);
+        break;
+    case LV_EVENT_REFR_READY:
+        // Sólo cuentan los refrescos que han pintado algo
+        if (bench.frame_flush_us > 0) {
+            uint32_t frame_us = (uint32_t)(now - bench.refr_start_us);
+            bench.frames++;
+            bench.flush_us += bench.frame_flush_us;
+            bench.render_us += frame_us > bench.frame_flush_us ? frame_us - bench.frame_flush_us : 0;
+        }
+        next_frame();
+        break;
+    default:
+        break;
+    }
+}
+
+static void scene_timer_cb(lv_timer_t *timer) {
+    int64_t now = esp_timer_get_time();
+    if (bench.start_us == 0 || now - bench.start_us < (int64_t)RENDER_BENCH_SCENE_MS * 1000) {
+        return;
+    }
+    report_scene(now);
+    bench.scene++;
+    if (!start_scene()) {
+        finish();
+    }
+}
+
+// Un núcleo RGB565 sobre un búfer de w x h; devuelve MB/s (bytes de destino escritos)
+static uint32_t kernel_throughput(unsigned kernel, uint16_t *dst, const uint16_t *src, int32_t w, int32_t h) {
+    const int32_t stride = w * (int32_t)sizeof(uint16_t);
+    const uint32_t bytes = (uint32_t)(stride * h);
+    const uint32_t reps = RENDER_BENCH_KERNEL_BYTES / bytes + 1;
+
+    int64_t start = esp_timer_get_time();
+    for (uint32_t r = 0; r < reps; r++) {
+        switch (kernel) {
+        case RGB565_KERNEL_FILL: rgb565_fill(dst, w, h, stride, (uint16_t)(0x1234 + r)); break;
+        case RGB565_KERNEL_FILL_OPA: rgb565_fill_opa(dst, w, h, stride, (uint16_t)(0x1234 + r), 128); break;
+        case RGB565_KERNEL_COPY: rgb565_copy(dst, stride, src, stride, w, h); break;
+        default: rgb565_blend(dst, stride, src, stride, w, h, 128); break;
+        }
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    return elapsed > 0 ? (uint32_t)((uint64_t)bytes * reps / (uint64_t)elapsed) : 0;
+}
+
+// Throughput de cada núcleo RGB565, vectorial y escalar, en PSRAM (framebuffers)
+// y en SRAM interna (búferes de dibujo de los perfiles PARTIAL)
+static void kernel_bench(void) {
+    static const struct {
+        const char *name;
+        uint32_t caps;
+        int32_t rows;
+    } mems[] = {
+        { "psram", MALLOC_CAP_SPIRAM, 120 },
+        { "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA, 10 },
+    };
+    static const char *const names[] = { "fill", "fill_opa", "copy", "blend" };
+    const bool simd = rgb565_kernels_simd();
+
+    printf("KERNEL,kernel,mem,impl,mb_s\n");
+    for (size_t m = 0; m < sizeof(mems) / sizeof(mems[0]); m++) {
+        size_t bytes = (size_t)BSP_LCD_H_RES * mems[m].rows * sizeof(uint16_t);
+        uint16_t *dst = heap_caps_aligned_alloc(16, bytes, mems[m].caps);
+        uint16_t *src = heap_caps_aligned_alloc(16, bytes, mems[m].caps);
+        if (dst == NULL || src == NULL) {
+            printf("KERNEL,%s,no_memory\n", mems[m].name);
+        } else {
+            for (size_t i = 0; i < bytes / sizeof(uint16_t); i++) {
+                src[i] = (uint16_t)(i * 2654435761u >> 16);
+            }
+            for (int impl = simd ? 0 : 1; impl < 2; impl++) {
+                rgb565_kernels_set_simd(impl == 0);
+                for (unsigned k = 0; k < 4; k++) {
+                    printf("KERNEL,%s,%s,%s,%lu\n", names[k], mems[m].name, impl == 0 ? "pie" : "scalar",
+                           (unsigned long)kernel_throughput(1u << k, dst, src, BSP_LCD_H_RES, mems[m].rows));
+                }
+            }
+        }
+        heap_caps_free(dst);
+        heap_caps_free(src);
+    }
+    rgb565_kernels_set_simd(simd);
+}
+
+static void start(unsigned scope) {
+    bench.scope = scope;
+    if (scope & RENDER_BENCH_KERNELS) {
+        kernel_bench();
+    }
+    if (!(scope & (RENDER_BENCH_SCREENS | RENDER_BENCH_DEMO))) {
+        atomic_store(&running, false);
+        return;
+    }
+    // Las escenas guardan punteros a pantallas y la demo vuelve a bench.home: la
+    // barra de navegación sigue activa, pero sin descartar ninguna hasta el final
+    if (bench.demo_screen == NULL) {
+        bench.home = lv_screen_active();
+    }
+    screen_manager_hold(true);
+    if (!(scope & RENDER_BENCH_SCREENS)) {
+        if (!start_demo()) {
+            release_screens();
+        }
+        atomic_store(&running, false);
+        return;
+    }
+    // Construir antes todas las pantallas: la escena de navegación no debe medir su creación
+    for (size_t i = 0; i < screen_count; i++) {
+        screens[i].get();
+    }
+    printf("BENCH,%s,config,draw_units=%d\n", render_profile_active()->name, LV_DRAW_SW_DRAW_UNIT_CNT);
+    printf("BENCH,profile,scene,frames,fps,render_us,flush_us,cpu0,cpu1\n");
+    // Sin límite de 33 ms entre refrescos: se mide cuánto tarda cada frame
+    lv_timer_set_period(lv_display_get_refr_timer(display), 1);
+    bench.scene = 0;
+    if (!start_scene()) {
+        finish();
+        return;
+    }
+    lv_timer_resume(bench.timer);
+}
+
+static void go_home(void) {
+    if (bench.demo_screen == NULL) {
+        return;
+    }
+    release_screens();
+    lv_obj_delete_async(bench.demo_screen);
+    bench.demo_screen = NULL;
+}
+
+// Hook de ui_update: las peticiones llegan de la tarea parser
+static bool bench_poll_hook(void) {
+    unsigned scope = atomic_exchange(&requested, 0);
+    if (scope == 0) {
+        return false;
+    }
+    if (scope & RENDER_BENCH_HOME) {
+        go_home();
+    }
+    if (scope & (RENDER_BENCH_SCREENS | RENDER_BENCH_DEMO | RENDER_BENCH_KERNELS)) {
+        start(scope & (RENDER_BENCH_SCREENS | RENDER_BENCH_DEMO | RENDER_BENCH_KERNELS));
+    } else {
+        atomic_store(&running, false);
+    }
+    return true;
+}
+
+void render_bench_init(lv_display_t *disp, const render_bench_screen_t *bench_screens, size_t count) {
+    display = disp;
+    screens = bench_screens;
+    screen_count = count;
+    bench.timer = lv_timer_create(scene_timer_cb, 100, NULL);
+    lv_timer_pause(bench.timer);
+    lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_ALL, NULL);
+    ui_update_register(bench_poll_hook);
+}
+
+bool render_bench_request(unsigned scope) {
+    if (display == NULL || atomic_exchange(&running, true)) {
+        return false;
+    }
+    atomic_fetch_or(&requested, scope);
+    return true;
+}
@@ -0,0 +1,36 @@
+// render_bench.h
+#ifndef RENDER_BENCH_H
+#define RENDER_BENCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "lvgl.h"
+
+// Benchmark de render en el propio equipo. Por cada pantalla de la aplicación
+// mide durante RENDER_BENCH_SCENE_MS un redibujado completo por frame, el
+// desplazamiento de su primer contenedor con scroll y, al final, la navegación
+// entre todas ellas; después puede lanzar lv_demo_benchmark (que imprime su
+// propio resumen en el log de LVGL). Los resultados salen por la consola en CSV:
+//
+//   BENCH,perfil,escena,frames,fps,render_us,flush_us,cpu0,cpu1
+//
+// precedidas de "BENCH,perfil,config,draw_units=<n>". render_us y flush_us son
+// medias por frame (flush incluye la espera del panel); cpu es la carga de cada núcleo en % (-1 sin CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS).
+
+#define RENDER_BENCH_SCREENS 0x01   // Escenas con las pantallas de la aplicación
+#define RENDER_BENCH_DEMO 0x02      // lv_demo_benchmark
+#define RENDER_BENCH_HOME 0x04      // Cerrar la demo y volver a la pantalla anterior
+#define RENDER_BENCH_KERNELS 0x08   // MB/s de cada núcleo RGB565 (rgb565_kernels.h)
+
+typedef struct {
+    const char *name;
+    lv_obj_t *(*get)(void);     // Pantalla (se puede construir en ese momento)
+} render_bench_screen_t;
+
+// Con el lock de LVGL, tras ui_update_init. screens debe seguir vivo.
+void render_bench_init(lv_display_t *disp, const render_bench_screen_t *screens, size_t count);
+
+// Desde cualquier tarea; arranca en el siguiente refresco. false si ya hay uno en marcha.
+bool render_bench_request(unsigned scope);
+
+#endif // RENDER_BENCH_H
@@ -0,0 +1,123 @@
+#include "render_profile.h"
+#include <string.h>
+#include "esp_log.h"
+#include "nvs.h"
+#include "uart_config.h"
+#include "uart_utils.h"
+#include "render_bench.h"
+
+#define RENDER_PROFILE(name, mode, lines, bufs, fbs, bounce, tearing) {#name, mode, lines, bufs, fbs, bounce, tearing},
+static const render_profile_t profiles[] = {
+#include "render_profiles.h"
+};
+#undef RENDER_PROFILE
+
+#define PROFILE_COUNT (sizeof(profiles) / sizeof(profiles[0]))
+
+static const render_profile_t *active = &profiles[0];
+
+static const render_profile_t *find_profile(const char *name) {
+    for (size_t i = 0; i < PROFILE_COUNT; i++) {
+        if (strcmp(profiles[i].name, name) == 0) {
+            return &profiles[i];
+        }
+    }
+    return NULL;
+}
+
+const render_profile_t *render_profile_load(void) {
+    nvs_handle_t nvs;
+    char name[32];
+    size_t len = sizeof(name);
+
+    active = &profiles[0];
+    if (nvs_open(RENDER_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return active; // Nada guardado todavía
+    }
+    if (nvs_get_str(nvs, RENDER_NVS_KEY, name, &len) == ESP_OK) {
+        const render_profile_t *stored = find_profile(name);
+        if (stored != NULL) {
+            active = stored;
+        } else {
+            ESP_LOGW("RENDER", "Perfil guardado '%s' desconocido: se usa '%s'", name, active->name);
+        }
+    }
+    nvs_close(nvs);
+    ESP_LOGI("RENDER", "Perfil de render '%s'", active->name);
+    return active;
+}
+
+const render_profile_t *render_profile_active(void) {
+    return active;
+}
+
+bool render_profile_is_default(const render_profile_t *profile) {
+    return profile == &profiles[0];
+}
+
+static bool store_profile_name(const char *name) {
+    nvs_handle_t nvs;
+    if (nvs_open(RENDER_NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return false;
+    }
+    esp_err_t err = name != NULL ? nvs_set_str(nvs, RENDER_NVS_KEY, name) : nvs_erase_key(nvs, RENDER_NVS_KEY);
+    if (err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND) {
+        err = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return err == ESP_OK;
+}
+
+void render_profile_reset(void) {
+    store_profile_name(NULL);
+}
+
+static void render_command_handler(const char *data) {
+    const char *arg = strchr(data, ':');
+    if (arg == NULL) {
+        return;
+    }
+    arg++;
+    if (strncmp(arg, "LIST", 4) == 0) {
+        for (size_t i = 0; i < PROFILE_COUNT; i++) {
+            const render_profile_t *p = &profiles[i];
+            ESP_LOGI("RENDER", "%c %-16s modo=%d lineas=%u x%u fbs=%u bounce=%u tearing=%d",
+                     p == active ? '*' : ' ', p->name, p->mode, p->draw_lines, p->draw_buffers,
+                     p->num_fbs, p->bounce_lines, p->avoid_tearing);
+        }
+    } else if (strncmp(arg, "SET=", 4) == 0) {
+        // El nombre acaba en el terminador '*' o al final de la trama
+        char name[32];
+        size_t len = strcspn(arg + 4, "*;");
+        if (len >= sizeof(name)) {
+            return;
+        }
+        memcpy(name, arg + 4, len);
+        name[len] = '\0';
+        if (find_profile(name) == NULL) {
+            ESP_LOGW("RENDER", "Perfil '%s' desconocido (RENDER:LIST)", name);
+        } else if (store_profile_name(name)) {
+            ESP_LOGI("RENDER", "Perfil '%s' guardado; se aplica al reiniciar", name);
+        } else {
+            ESP_LOGE("RENDER", "No se pudo guardar el perfil en NVS");
+        }
+    } else if (strncmp(arg, "BENCH", 5) == 0) {
+        unsigned scope = RENDER_BENCH_SCREENS;
+        if (strncmp(arg + 5, "=demo", 5) == 0) {
+            scope = RENDER_BENCH_DEMO;
+        } else if (strncmp(arg + 5, "=kernels", 8) == 0) {
+            scope = RENDER_BENCH_KERNELS;
+        } else if (strncmp(arg + 5, "=all", 4) == 0) {
+            scope = RENDER_BENCH_KERNELS | RENDER_BENCH_SCREENS | RENDER_BENCH_DEMO;
+        } else if (strncmp(arg + 5, "=home", 5) == 0) {
+            scope = RENDER_BENCH_HOME;
+        }
+        if (!render_bench_request(scope)) {
+            ESP_LOGW("RENDER", "Benchmark no disponible o ya en marcha");
+        }
+    }
+}
+
+void render_profile_register_commands(void) {
+    uart_register_handler("RENDER", render_command_handler);
+}
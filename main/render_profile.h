@@ -0,0 +1,48 @@
+// render_profile.h
+#ifndef RENDER_PROFILE_H
+#define RENDER_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Estrategia de render (modo de LVGL, búferes y framebuffers del panel)
+// elegida al arrancar por nombre desde NVS. La tabla está en render_profiles.h.
+//
+// Comandos (prefijo "RENDER"):
+//   RENDER:LIST            perfiles disponibles y el activo
+//   RENDER:SET=<nombre>    guarda el perfil en NVS; se aplica al reiniciar
+//   RENDER:BENCH[=<esc>]   benchmark (render_bench.h); esc = screens, demo,
+//                          kernels, all o home
+
+typedef enum {
+    RENDER_MODE_DIRECT,     // LVGL dibuja sólo lo invalidado en el framebuffer
+    RENDER_MODE_FULL,       // LVGL redibuja la pantalla entera en cada frame
+    RENDER_MODE_PARTIAL,    // Búferes de dibujo internos; el flush copia al framebuffer
+} render_mode_t;
+
+typedef struct {
+    const char *name;
+    render_mode_t mode;
+    uint16_t draw_lines;    // Alto de cada búfer de dibujo (PARTIAL)
+    uint8_t draw_buffers;   // 1 o 2 (PARTIAL)
+    uint8_t num_fbs;
+    uint16_t bounce_lines;  // 0 = sin bounce buffer
+    bool avoid_tearing;
+} render_profile_t;
+
+// Perfil guardado en NVS o el de por defecto. NVS ya inicializado.
+const render_profile_t *render_profile_load(void);
+
+// Perfil en uso (tras render_profile_load)
+const render_profile_t *render_profile_active(void);
+
+// El primero de la tabla, el que se usa si no hay nada guardado
+bool render_profile_is_default(const render_profile_t *profile);
+
+// Borra el perfil guardado: el siguiente arranque usa el de por defecto
+void render_profile_reset(void);
+
+// Registra el comando RENDER (tras uart_utils_init)
+void render_profile_register_commands(void);
+
+#endif // RENDER_PROFILE_H
@@ -0,0 +1,17 @@
+// Perfiles de render: RENDER_PROFILE(nombre, modo, líneas, búferes, fbs, bounce, tearing)
+//   modo     RENDER_MODE_DIRECT / _FULL dibujan en los framebuffers del panel (PSRAM);
+//            RENDER_MODE_PARTIAL dibuja en búferes DMA internos de `líneas` de alto
+//   búferes  búferes de dibujo de LVGL (sólo PARTIAL: 1 o 2)
+//   fbs      framebuffers del panel RGB
+//   bounce   líneas del bounce buffer del panel (0 = sin bounce buffer)
+//   tearing  esperar a vsync para cambiar de framebuffer (sólo DIRECT/FULL con 2 fbs)
+// El primero es el de por defecto. Se añaden al final: el nombre se guarda en NVS.
+
+RENDER_PROFILE(direct_bb10,  RENDER_MODE_DIRECT,  0,  0, 2, 10, true)
+RENDER_PROFILE(direct_bb20,  RENDER_MODE_DIRECT,  0,  0, 2, 20, true)
+RENDER_PROFILE(direct_nobb,  RENDER_MODE_DIRECT,  0,  0, 2, 0,  true)
+RENDER_PROFILE(full_bb10,    RENDER_MODE_FULL,    0,  0, 2, 10, true)
+RENDER_PROFILE(partial_20x2, RENDER_MODE_PARTIAL, 20, 2, 1, 10, false)
+RENDER_PROFILE(partial_40x2, RENDER_MODE_PARTIAL, 40, 2, 1, 10, false)
+RENDER_PROFILE(partial_80,   RENDER_MODE_PARTIAL, 80, 1, 1, 10, false)
+RENDER_PROFILE(partial_40_nobb, RENDER_MODE_PARTIAL, 40, 2, 1, 0, false)
@@ -0,0 +1,265 @@
+#include "rgb565_kernels.h"
+#include <string.h>
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#if CONFIG_IDF_TARGET_ESP32S3
+#define HAVE_PIE 1
+// rgb565_kernels_esp32s3.S: punteros alineados a 16 bytes, blocks > 0 bloques de 16 bytes
+void rgb565_pie_fill16(uint16_t *dest, uint32_t blocks, uint32_t pattern);
+void rgb565_pie_copy16(uint16_t *dest, const uint16_t *src, uint32_t blocks);
+#else
+#define HAVE_PIE 0
+#endif
+
+// Filas de al menos este ancho usan PIE (la cabeza hasta alinear son <= 7 píxeles)
+#define PIE_MIN_PIXELS 16
+
+typedef uint32_t __attribute__((may_alias)) px2_t;  // Dos píxeles en un acceso de 32 bits
+
+static bool use_simd = HAVE_PIE;
+
+#define NEXT_ROW(p, stride) ((void *)((uint8_t *)(p) + (stride)))
+
+static inline uint32_t mix2(uint32_t fg, uint32_t bg, uint8_t opa) {
+    return rgb565_mix((uint16_t)fg, (uint16_t)bg, opa) |
+           (uint32_t)rgb565_mix((uint16_t)(fg >> 16), (uint16_t)(bg >> 16), opa) << 16;
+}
+
+static void fill_row(uint16_t *d, int32_t w, uint16_t color) {
+    uint32_t pair = color | (uint32_t)color << 16;
+#if HAVE_PIE
+    if (use_simd && w >= PIE_MIN_PIXELS) {
+        while (((uintptr_t)d & 15) != 0) {
+            *d++ = color;
+            w--;
+        }
+        uint32_t blocks = (uint32_t)w >> 3;
+        rgb565_pie_fill16(d, blocks, pair);
+        d += blocks * 8;
+        w -= (int32_t)blocks * 8;
+    }
+#endif
+    if (w > 0 && ((uintptr_t)d & 2) != 0) {
+        *d++ = color;
+        w--;
+    }
+    for (; w >= 2; w -= 2, d += 2) {
+        *(px2_t *)d = pair;
+    }
+    if (w > 0) {
+        *d = color;
+    }
+}
+
+static void fill_opa_row(uint16_t *d, int32_t w, uint16_t color, uint8_t opa) {
+    if (w > 0 && ((uintptr_t)d & 2) != 0) {
+        *d = rgb565_mix(color, *d, opa);
+        d++;
+        w--;
+    }
+    // Fondo uniforme (lo habitual): se repite el último resultado
+    uint32_t last_bg = 0;
+    uint32_t last_res = mix2(color | (uint32_t)color << 16, 0, opa);
+    for (; w >= 2; w -= 2, d += 2) {
+        uint32_t bg = *(px2_t *)d;
+        if (bg != last_bg) {
+            last_bg = bg;
+            last_res = mix2(color | (uint32_t)color << 16, bg, opa);
+        }
+        *(px2_t *)d = last_res;
+    }
+    if (w > 0) {
+        *d = rgb565_mix(color, *d, opa);
+    }
+}
+
+static void copy_row(uint16_t *d, const uint16_t *s, int32_t w) {
+#if HAVE_PIE
+    if (use_simd && w >= PIE_MIN_PIXELS && (((uintptr_t)d ^ (uintptr_t)s) & 15) == 0) {
+        while (((uintptr_t)d & 15) != 0) {
+            *d++ = *s++;
+            w--;
+        }
+        uint32_t blocks = (uint32_t)w >> 3;
+        rgb565_pie_copy16(d, s, blocks);
+        d += blocks * 8;
+        s += blocks * 8;
+        w -= (int32_t)blocks * 8;
+    }
+#endif
+    memcpy(d, s, (size_t)w * sizeof(uint16_t));
+}
+
+static void blend_row(uint16_t *d, const uint16_t *s, int32_t w, uint8_t opa) {
+    if ((((uintptr_t)d ^ (uintptr_t)s) & 2) != 0) {
+        // Alineaciones distintas: píxel a píxel
+        for (int32_t x = 0; x < w; x++) {
+            d[x] = rgb565_mix(s[x], d[x], opa);
+        }
+        return;
+    }
+    if (w > 0 && ((uintptr_t)d & 2) != 0) {
+        *d = rgb565_mix(*s, *d, opa);
+        d++;
+        s++;
+        w--;
+    }
+    for (; w >= 2; w -= 2, d += 2, s += 2) {
+        uint32_t bg = *(px2_t *)d;
+        uint32_t fg = *(const px2_t *)s;
+        if (fg != bg) {     // Iguales: la mezcla no cambia nada y se ahorra la escritura
+            *(px2_t *)d = mix2(fg, bg, opa);
+        }
+    }
+    if (w > 0) {
+        *d = rgb565_mix(*s, *d, opa);
+    }
+}
+
+void rgb565_fill(uint16_t *dest, int32_t w, int32_t h, int32_t stride, uint16_t color) {
+    if (stride == w * 2) {  // Filas contiguas: un solo tramo
+        w *= h;
+        h = 1;
+    }
+    for (int32_t y = 0; y < h; y++, dest = NEXT_ROW(dest, stride)) {
+        fill_row(dest, w, color);
+    }
+}
+
+void rgb565_fill_opa(uint16_t *dest, int32_t w, int32_t h, int32_t stride, uint16_t color, uint8_t opa) {
+    if (stride == w * 2) {
+        w *= h;
+        h = 1;
+    }
+    for (int32_t y = 0; y < h; y++, dest = NEXT_ROW(dest, stride)) {
+        fill_opa_row(dest, w, color, opa);
+    }
+}
+
+void rgb565_copy(uint16_t *dest, int32_t dest_stride, const uint16_t *src, int32_t src_stride, int32_t w,
+                 int32_t h) {
+    if (dest_stride == w * 2 && src_stride == w * 2) {
+        w *= h;
+        h = 1;
+    }
+    for (int32_t y = 0; y < h; y++, dest = NEXT_ROW(dest, dest_stride), src = NEXT_ROW(src, src_stride)) {
+        copy_row(dest, src, w);
+    }
+}
+
+void rgb565_blend(uint16_t *dest, int32_t dest_stride, const uint16_t *src, int32_t src_stride, int32_t w,
+                  int32_t h, uint8_t opa) {
+    if (dest_stride == w * 2 && src_stride == w * 2) {
+        w *= h;
+        h = 1;
+    }
+    for (int32_t y = 0; y < h; y++, dest = NEXT_ROW(dest, dest_stride), src = NEXT_ROW(src, src_stride)) {
+        blend_row(dest, src, w, opa);
+    }
+}
+
+void *rgb565_memcpy(void *dest, const void *src, size_t len) {
+    if (len < PIE_MIN_PIXELS * sizeof(uint16_t) || len > INT32_MAX ||
+        ((len | (uintptr_t)dest | (uintptr_t)src) & 1) != 0) {
+        return memcpy(dest, src, len);
+    }
+    rgb565_copy(dest, (int32_t)len, src, (int32_t)len, (int32_t)(len / 2), 1);
+    return dest;
+}
+
+bool rgb565_kernels_simd_available(void) {
+    return HAVE_PIE;
+}
+
+bool rgb565_kernels_simd(void) {
+    return use_simd;
+}
+
+void rgb565_kernels_set_simd(bool enable) {
+    use_simd = enable && HAVE_PIE;
+}
+
+// Autotest: referencia píxel a píxel, como los bucles C de LVGL
+
+#define TEST_STRIDE 96      // Píxeles por fila de cada zona
+#define TEST_ROWS 4
+#define TEST_AREA (TEST_STRIDE * TEST_ROWS)
+
+static uint32_t rng;
+
+static uint16_t random_pixel(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (uint16_t)rng;
+}
+
+// few_colors: fondos casi uniformes, para la caché de fill_opa_row
+static void randomize(uint16_t *p, bool few_colors) {
+    for (size_t i = 0; i < TEST_AREA; i++) {
+        p[i] = few_colors ? (uint16_t)(0x1234 * (random_pixel() % 3)) : random_pixel();
+    }
+}
+
+static void reference(unsigned kernel, uint16_t *d, const uint16_t *s, int32_t w, uint16_t color, uint8_t opa) {
+    for (int32_t y = 0; y < TEST_ROWS; y++, d += TEST_STRIDE, s += TEST_STRIDE) {
+        for (int32_t x = 0; x < w; x++) {
+            switch (kernel) {
+            case RGB565_KERNEL_FILL: d[x] = color; break;
+            case RGB565_KERNEL_FILL_OPA: d[x] = rgb565_mix(color, d[x], opa); break;
+            case RGB565_KERNEL_COPY: d[x] = s[x]; break;
+            default: d[x] = rgb565_mix(s[x], d[x], opa); break;
+            }
+        }
+    }
+}
+
+static void run(unsigned kernel, uint16_t *d, const uint16_t *s, int32_t w, uint16_t color, uint8_t opa) {
+    const int32_t stride = TEST_STRIDE * sizeof(uint16_t);
+    switch (kernel) {
+    case RGB565_KERNEL_FILL: rgb565_fill(d, w, TEST_ROWS, stride, color); break;
+    case RGB565_KERNEL_FILL_OPA: rgb565_fill_opa(d, w, TEST_ROWS, stride, color, opa); break;
+    case RGB565_KERNEL_COPY: rgb565_copy(d, stride, s, stride, w, TEST_ROWS); break;
+    default: rgb565_blend(d, stride, s, stride, w, TEST_ROWS, opa); break;
+    }
+}
+
+unsigned rgb565_kernels_self_test(uint16_t *scratch, size_t pixels) {
+    const unsigned all = RGB565_KERNEL_FILL | RGB565_KERNEL_FILL_OPA | RGB565_KERNEL_COPY | RGB565_KERNEL_BLEND;
+    if (pixels < RGB565_SELF_TEST_PIXELS) {
+        return all;
+    }
+    uint16_t *src = scratch;
+    uint16_t *ref = scratch + TEST_AREA;
+    uint16_t *out = scratch + 2 * TEST_AREA;
+    unsigned failed = 0;
+
+    rng = 0x2545F491;
+    // Anchos cortos uno a uno y largos a saltos; desplazamientos de 0..7 píxeles
+    // para el destino y el origen con la misma alineación o distinta. El ancho
+    // TEST_STRIDE sin desplazamiento prueba las filas contiguas.
+    for (int32_t w = 1; w <= TEST_STRIDE; w += w < 24 ? 1 : 9) {
+        for (int32_t off = 0; off < 8; off++) {
+            int32_t max_off = TEST_STRIDE - w;
+            int32_t d_off = off <= max_off ? off : 0;
+            int32_t s_offs[2] = { d_off, (d_off + 1 + w) % 8 <= max_off ? (d_off + 1 + w) % 8 : 0 };
+            for (int i = 0; i < 2; i++) {
+                for (unsigned kernel = RGB565_KERNEL_FILL; kernel & all; kernel <<= 1) {
+                    uint16_t color = random_pixel();
+                    uint8_t opa = (uint8_t)random_pixel();
+                    randomize(src, false);
+                    randomize(ref, (w & 1) != 0);
+                    memcpy(out, ref, TEST_AREA * sizeof(uint16_t));
+                    reference(kernel, ref + d_off, src + s_offs[i], w, color, opa);
+                    run(kernel, out + d_off, src + s_offs[i], w, color, opa);
+                    if (memcmp(ref, out, TEST_AREA * sizeof(uint16_t)) != 0) {
+                        failed |= kernel;
+                    }
+                }
+            }
+        }
+    }
+    return failed;
+}
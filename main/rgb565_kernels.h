@@ -0,0 +1,68 @@
+// rgb565_kernels.h
+#ifndef RGB565_KERNELS_H
+#define RGB565_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Núcleos RGB565 del render por software: relleno sólido, relleno con
+// opacidad, copia opaca y mezcla con opacidad. rgb565_lv_blend.h los engancha a
+// los blends de LVGL; el resultado es idéntico bit a bit al de los bucles C de
+// LVGL 9.2 (rgb565_mix = lv_color_16_16_mix).
+//
+// En ESP32-S3 el relleno y la copia usan instrucciones PIE de 128 bits sobre
+// el tramo de cada fila alineado a 16 bytes (la cabeza y la cola, escalares).
+// Las mezclas leen y escriben dos píxeles por acceso de 32 bits: la mezcla de
+// LVGL depende de la aritmética modular de 32 bits, que PIE (carriles de 32
+// bits con saturación, sin multiplicación de 32 bits) no reproduce.
+// Strides en bytes, como en los descriptores de LVGL.
+// Sin dependencias de ESP-IDF.
+
+#define RGB565_KERNEL_FILL 0x01
+#define RGB565_KERNEL_FILL_OPA 0x02
+#define RGB565_KERNEL_COPY 0x04
+#define RGB565_KERNEL_BLEND 0x08
+
+// Mezcla de un píxel: fg sobre bg con opacidad opa (0..255)
+static inline uint16_t rgb565_mix(uint16_t fg, uint16_t bg, uint8_t opa) {
+    if (opa == 255) {
+        return fg;
+    }
+    if (opa == 0) {
+        return bg;
+    }
+    if (fg == bg) {
+        return fg;
+    }
+    uint32_t mix = ((uint32_t)opa + 4) >> 3;
+    uint32_t b = ((uint32_t)bg | (uint32_t)bg << 16) & 0x07E0F81F;
+    uint32_t f = ((uint32_t)fg | (uint32_t)fg << 16) & 0x07E0F81F;
+    uint32_t r = ((((f - b) * mix) >> 5) + b) & 0x07E0F81F;
+    return (uint16_t)((r >> 16) | r);
+}
+
+void rgb565_fill(uint16_t *dest, int32_t w, int32_t h, int32_t stride, uint16_t color);
+void rgb565_fill_opa(uint16_t *dest, int32_t w, int32_t h, int32_t stride, uint16_t color, uint8_t opa);
+void rgb565_copy(uint16_t *dest, int32_t dest_stride, const uint16_t *src, int32_t src_stride, int32_t w,
+                 int32_t h);
+void rgb565_blend(uint16_t *dest, int32_t dest_stride, const uint16_t *src, int32_t src_stride, int32_t w,
+                  int32_t h, uint8_t opa);
+
+// memcpy que pasa por rgb565_copy cuando el tramo son píxeles (longitud y
+// punteros pares) y da para PIE; si no, memcpy. Es el lv_memcpy de LVGL
+// (--wrap en main/CMakeLists.txt): sincronización de framebuffers, draw_buf.
+void *rgb565_memcpy(void *dest, const void *src, size_t len);
+
+// Núcleos vectoriales disponibles y en uso (false: todo escalar)
+bool rgb565_kernels_simd_available(void);
+bool rgb565_kernels_simd(void);
+void rgb565_kernels_set_simd(bool enable);
+
+// Compara los núcleos en uso con bucles de referencia píxel a píxel, con
+// anchos y alineaciones variados. scratch: al menos RGB565_SELF_TEST_PIXELS.
+// Devuelve los RGB565_KERNEL_* que no coinciden (0 = todo bien).
+#define RGB565_SELF_TEST_PIXELS (3 * 4 * 96)
+unsigned rgb565_kernels_self_test(uint16_t *scratch, size_t pixels);
+
+#endif // RGB565_KERNELS_H
@@ -0,0 +1,28 @@
+// rgb565_lv_blend.h
+#ifndef RGB565_LV_BLEND_H
+#define RGB565_LV_BLEND_H
+
+// Lo incluyen los blends por software de LVGL (CONFIG_LV_DRAW_SW_ASM_CUSTOM_INCLUDE),
+// no la aplicación. Cada macro recibe el descriptor del blend y devuelve
+// LV_RESULT_OK si lo resuelve rgb565_kernels; los casos sin macro (máscaras,
+// otros formatos y modos de mezcla) siguen en los bucles de LVGL.
+
+#include "rgb565_kernels.h"
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_RGB565(dsc) \
+    (rgb565_fill((uint16_t *)(dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                 lv_color_to_u16((dsc)->color)), LV_RESULT_OK)
+
+#define LV_DRAW_SW_COLOR_BLEND_TO_RGB565_WITH_OPA(dsc) \
+    (rgb565_fill_opa((uint16_t *)(dsc)->dest_buf, (dsc)->dest_w, (dsc)->dest_h, (dsc)->dest_stride, \
+                     lv_color_to_u16((dsc)->color), (dsc)->opa), LV_RESULT_OK)
+
+#define LV_DRAW_SW_RGB565_BLEND_NORMAL_TO_RGB565(dsc) \
+    (rgb565_copy((uint16_t *)(dsc)->dest_buf, (dsc)->dest_stride, (const uint16_t *)(dsc)->src_buf, \
+                 (dsc)->src_stride, (dsc)->dest_w, (dsc)->dest_h), LV_RESULT_OK)
+
+#define LV_DRAW_SW_RGB565_BLEND_NORMAL_TO_RGB565_WITH_OPA(dsc) \
+    (rgb565_blend((uint16_t *)(dsc)->dest_buf, (dsc)->dest_stride, (const uint16_t *)(dsc)->src_buf, \
+                  (dsc)->src_stride, (dsc)->dest_w, (dsc)->dest_h, (dsc)->opa), LV_RESULT_OK)
+
+#endif // RGB565_LV_BLEND_H
@@ -0,0 +1,263 @@
+#include "sched_profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "lvgl.h"
+#include "uart_config.h"
+#include "uart_utils.h"
+
+typedef struct {
+    const char *name;
+    uint32_t stack;
+    UBaseType_t prio;
+    int core;               // En SCHED_PROFILE_SPLIT
+} task_cfg_t;
+
+static const task_cfg_t tasks[SCHED_TASK_COUNT] = {
+#define SCHED_TASK(id, name, stack, prio, core) [SCHED_TASK_##id] = { name, stack, prio, core },
+#include "sched_tasks.h"
+#undef SCHED_TASK
+};
+
+typedef struct {
+    const char *name;
+    uint32_t period_us;
+    int64_t last_us;
+    uint32_t count;
+    uint64_t sum_abs_us;
+    int32_t max_late_us;
+    int32_t max_early_us;
+} periodic_t;
+
+static portMUX_TYPE periodic_lock = portMUX_INITIALIZER_UNLOCKED;
+static periodic_t periodics[SCHED_PERIODIC_COUNT] = {
+    [SCHED_PERIODIC_LVGL_REFR] = { "lvgl_refr", LV_DEF_REFR_PERIOD * 1000 },
+    [SCHED_PERIODIC_DATALOG] = { "datalog", DATALOG_PERIOD_S * 1000000 },
+};
+
+#if SCHED_PROFILE == SCHED_PROFILE_SPLIT
+#define PROFILE_NAME "split"
+#define LCD_ISR_CORE 0
+#define UART_ISR_CORE 0
+#else
+#define PROFILE_NAME "free"
+#define LCD_ISR_CORE (-1)
+#define UART_ISR_CORE (-1)
+#endif
+
+int sched_task_core(sched_task_t task) {
+    return SCHED_PROFILE == SCHED_PROFILE_SPLIT ? tasks[task].core : -1;
+}
+
+UBaseType_t sched_task_priority(sched_task_t task) {
+    return tasks[task].prio;
+}
+
+uint32_t sched_task_stack(sched_task_t task) {
+    return tasks[task].stack;
+}
+
+BaseType_t sched_task_create(sched_task_t task, TaskFunction_t fn, void *arg, TaskHandle_t *handle) {
+    int core = sched_task_core(task);
+    return xTaskCreatePinnedToCore(fn, tasks[task].name, tasks[task].stack, arg, tasks[task].prio, handle,
+                                   core < 0 ? tskNO_AFFINITY : core);
+}
+
+int sched_lcd_isr_core(void) {
+    return LCD_ISR_CORE;
+}
+
+int sched_uart_isr_core(void) {
+    return UART_ISR_CORE;
+}
+
+typedef struct {
+    esp_err_t (*fn)(void *arg);
+    void *arg;
+    esp_err_t result;
+    TaskHandle_t waiter;
+} run_ctx_t;
+
+static void run_task(void *arg) {
+    run_ctx_t *ctx = arg;
+    ctx->result = ctx->fn(ctx->arg);
+    xTaskNotifyGive(ctx->waiter);
+    vTaskDelete(NULL);
+}
+
+esp_err_t sched_run_on_core(int core, esp_err_t (*fn)(void *arg), void *arg) {
+    if (core < 0 || core == xPortGetCoreID()) {
+        return fn(arg);
+    }
+    run_ctx_t ctx = { fn, arg, ESP_FAIL, xTaskGetCurrentTaskHandle() };
+    if (xTaskCreatePinnedToCore(run_task, "sched_run", 4096, &ctx, uxTaskPriorityGet(NULL), NULL, core) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return ctx.result;
+}
+
+void sched_periodic_mark(sched_periodic_t periodic) {
+    periodic_t *p = &periodics[periodic];
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&periodic_lock);
+    if (p->last_us != 0) {
+        int32_t dev = (int32_t)(now - p->last_us - p->period_us);
+        p->count++;
+        p->sum_abs_us += dev < 0 ? -dev : dev;
+        if (dev > p->max_late_us) {
+            p->max_late_us = dev;
+        }
+        if (dev < p->max_early_us) {
+            p->max_early_us = dev;
+        }
+    }
+    p->last_us = now;
+    portEXIT_CRITICAL(&periodic_lock);
+}
+
+// Intervalo de medida: contadores de tiempo de ejecución al empezar
+static struct {
+    TaskHandle_t handle;
+    uint32_t runtime;
+} snap[SCHED_STATS_MAX_TASKS];
+static size_t snap_count;
+static uint32_t snap_total;
+static uint32_t snap_idle[portNUM_PROCESSORS];
+
+static uint32_t snap_runtime(TaskHandle_t handle) {
+    for (size_t i = 0; i < snap_count; i++) {
+        if (snap[i].handle == handle) {
+            return snap[i].runtime;
+        }
+    }
+    return 0;   // Tarea creada durante el intervalo
+}
+
+// SCHED:STATS/RESET llegan por la tarea del parser y el informe periódico por
+// sched_watch: un intervalo (y un informe) a la vez
+static SemaphoreHandle_t stats_mutex;
+
+// Imprime el intervalo que termina (si print) y empieza otro; con stats_mutex tomado
+static void stats_interval_locked(bool print) {
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    TaskStatus_t *status = malloc(SCHED_STATS_MAX_TASKS * sizeof(TaskStatus_t));
+    if (status == NULL) {
+        return;
+    }
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t n = uxTaskGetSystemState(status, SCHED_STATS_MAX_TASKS, &total);
+    uint32_t elapsed = (uint32_t)total - snap_total;
+
+    if (print && elapsed > 0) {
+        printf("SCHED profile=%s intervalo=%lu ms\n", PROFILE_NAME, (unsigned long)(elapsed / 1000));
+        printf("SCHED %-20s %4s %4s %6s %6s\n", "tarea", "core", "prio", "cpu%", "pila");
+        for (UBaseType_t i = 0; i < n; i++) {
+            uint32_t run = status[i].ulRunTimeCounter - snap_runtime(status[i].xHandle);
+            uint32_t pct_x10 = (uint32_t)((uint64_t)run * 1000 / elapsed);
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+            int core = status[i].xCoreID == tskNO_AFFINITY ? -1 : (int)status[i].xCoreID;
+#else
+            int core = -2;  // Sin CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+#endif
+            printf("SCHED %-20s %4d %4u %4lu.%lu %6lu\n", status[i].pcTaskName, core,
+                   (unsigned)status[i].uxCurrentPriority, (unsigned long)(pct_x10 / 10),
+                   (unsigned long)(pct_x10 % 10), (unsigned long)status[i].usStackHighWaterMark);
+        }
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            uint32_t idle = (uint32_t)ulTaskGetIdleRunTimeCounterForCore(c) - snap_idle[c];
+            int load = idle >= elapsed ? 0 : (int)(100 - (uint64_t)idle * 100 / elapsed);
+            printf("SCHED core %d carga %d%%%s\n", c, load, load >= SCHED_CORE_BUSY_WARN ? " SATURADO" : "");
+        }
+    }
+    snap_count = n < SCHED_STATS_MAX_TASKS ? n : SCHED_STATS_MAX_TASKS;
+    for (size_t i = 0; i < snap_count; i++) {
+        snap[i].handle = status[i].xHandle;
+        snap[i].runtime = status[i].ulRunTimeCounter;
+    }
+    snap_total = (uint32_t)total;
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        snap_idle[c] = (uint32_t)ulTaskGetIdleRunTimeCounterForCore(c);
+    }
+    free(status);
+#else
+    if (print) {
+        printf("SCHED profile=%s (sin estadísticas de tiempo de ejecución)\n", PROFILE_NAME);
+    }
+#endif
+
+    // Jitter: desviación de cada intervalo respecto al periodo
+    periodic_t copy[SCHED_PERIODIC_COUNT];
+    portENTER_CRITICAL(&periodic_lock);
+    memcpy(copy, periodics, sizeof(copy));
+    for (int i = 0; i < SCHED_PERIODIC_COUNT; i++) {
+        periodics[i].count = 0;
+        periodics[i].sum_abs_us = 0;
+        periodics[i].max_late_us = 0;
+        periodics[i].max_early_us = 0;
+    }
+    portEXIT_CRITICAL(&periodic_lock);
+    if (print) {
+        printf("SCHED %-12s %9s %6s %9s %9s %9s\n", "periodica", "periodo", "n", "media_us", "tarde_us",
+               "pronto_us");
+        for (int i = 0; i < SCHED_PERIODIC_COUNT; i++) {
+            printf("SCHED %-12s %9lu %6lu %9lu %9ld %9ld\n", copy[i].name, (unsigned long)copy[i].period_us,
+                   (unsigned long)copy[i].count,
+                   (unsigned long)(copy[i].count ? copy[i].sum_abs_us / copy[i].count : 0),
+                   (long)copy[i].max_late_us, (long)copy[i].max_early_us);
+        }
+    }
+}
+
+static void stats_interval(bool print) {
+    xSemaphoreTake(stats_mutex, portMAX_DELAY);
+    stats_interval_locked(print);
+    xSemaphoreGive(stats_mutex);
+}
+
+static volatile uint32_t watch_period_s;
+static TaskHandle_t watch_task_handle;
+
+static void watch_task(void *arg) {
+    while (watch_period_s > 0) {
+        vTaskDelay(pdMS_TO_TICKS(watch_period_s * 1000));
+        if (watch_period_s > 0) {
+            stats_interval(true);
+        }
+    }
+    watch_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+static void sched_command_handler(const char *data) {
+    const char *arg = strchr(data, ':');
+    if (arg == NULL) {
+        return;
+    }
+    arg++;
+    if (strncmp(arg, "STATS", 5) == 0) {
+        stats_interval(true);
+    } else if (strncmp(arg, "RESET", 5) == 0) {
+        stats_interval(false);
+    } else if (strncmp(arg, "WATCH=", 6) == 0) {
+        watch_period_s = (uint32_t)strtoul(arg + 6, NULL, 10);
+        if (watch_period_s > 0 && watch_task_handle == NULL) {
+            stats_interval(false);
+            // Prioridad mínima: medir sin quitar tiempo a lo medido
+            xTaskCreatePinnedToCore(watch_task, "sched_watch", 3072, NULL, 1, &watch_task_handle, tskNO_AFFINITY);
+        }
+    }
+}
+
+void sched_register_commands(void) {
+    ESP_LOGI("SCHED", "Plan de planificación '%s'", PROFILE_NAME);
+    if (stats_mutex == NULL && (stats_mutex = xSemaphoreCreateMutex()) == NULL) {
+        ESP_LOGE("SCHED", "Sin memoria para el mutex de SCHED:STATS");
+        return;
+    }
+    uart_register_handler("SCHED", sched_command_handler);
+}
@@ -0,0 +1,69 @@
+// sched_profile.h
+#ifndef SCHED_PROFILE_H
+#define SCHED_PROFILE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Plan de planificación elegido al compilar con SCHED_PROFILE (uart_config.h):
+// núcleo y prioridad de cada tarea (sched_tasks.h) y núcleo de las ISR del
+// panel RGB (relleno de los bounce buffers) y del UART, que quedan en el
+// núcleo que las reserva.
+//
+//   SCHED_PROFILE_SPLIT  núcleo 0: ISR del panel y del UART, tareas UART y
+//                        servicios; núcleo 1: tarea de LVGL. Las unidades de
+//                        dibujo de LVGL no tienen afinidad y usan los dos.
+//   SCHED_PROFILE_FREE   mismas prioridades, todo sin afinidad (para comparar)
+//
+// Modo de medida (prefijo "SCHED"):
+//   SCHED:STATS          por tarea: núcleo, prioridad, % de CPU y pila libre;
+//                        carga de cada núcleo y jitter de las tareas periódicas,
+//                        todo desde el anterior STATS o RESET
+//   SCHED:RESET          empieza un intervalo de medida
+//   SCHED:WATCH=<s>      STATS cada s segundos (0 = parar)
+// El % de CPU necesita CONFIG_FREERTOS_USE_TRACE_FACILITY y
+// CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS.
+
+#define SCHED_PROFILE_SPLIT 0
+#define SCHED_PROFILE_FREE 1
+
+typedef enum {
+#define SCHED_TASK(id, name, stack, prio, core) SCHED_TASK_##id,
+#include "sched_tasks.h"
+#undef SCHED_TASK
+    SCHED_TASK_COUNT
+} sched_task_t;
+
+// Tareas periódicas cuyo jitter se mide
+typedef enum {
+    SCHED_PERIODIC_LVGL_REFR,   // Refresco del display (LV_DEF_REFR_PERIOD)
+    SCHED_PERIODIC_DATALOG,     // Muestreo del datalog (DATALOG_PERIOD_S)
+    SCHED_PERIODIC_COUNT
+} sched_periodic_t;
+
+// Núcleo de la tarea en el plan (-1 = sin afinidad), prioridad y pila
+int sched_task_core(sched_task_t task);
+UBaseType_t sched_task_priority(sched_task_t task);
+uint32_t sched_task_stack(sched_task_t task);
+
+// xTaskCreatePinnedToCore con los valores del plan
+BaseType_t sched_task_create(sched_task_t task, TaskFunction_t fn, void *arg, TaskHandle_t *handle);
+
+// Núcleos para las ISR del panel y del UART (-1 = el de quien las reserve)
+int sched_lcd_isr_core(void);
+int sched_uart_isr_core(void);
+
+// Ejecuta fn en una tarea fija en core y espera a que termine, para que las
+// interrupciones que reserve fn queden en ese núcleo. core < 0 o el núcleo
+// actual: se llama directamente.
+esp_err_t sched_run_on_core(int core, esp_err_t (*fn)(void *arg), void *arg);
+
+// Comienzo de una vuelta de una tarea periódica (una sola tarea por periodo)
+void sched_periodic_mark(sched_periodic_t periodic);
+
+// Registra el comando SCHED (tras uart_utils_init)
+void sched_register_commands(void);
+
+#endif // SCHED_PROFILE_H
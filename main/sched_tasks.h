@@ -0,0 +1,15 @@
+// Tareas de la aplicación: SCHED_TASK(id, nombre, pila, prioridad, núcleo en SCHED_PROFILE_SPLIT)
+//   UART (8..10)     por encima de todo: el driver sólo guarda
+//                    UART_DRIVER_RX_BUFFER_SIZE bytes y una ráfaga no debe esperar
+//   LVGL (4)         por encima de sus unidades de dibujo (3, LV_THREAD_PRIO_HIGH)
+//                    para repartir trabajo en cuanto terminan
+//   servicios (2)    flash y NVS, al fondo
+// LVGL la crea esp_lvgl_port con estos valores (su nombre es "taskLVGL").
+
+SCHED_TASK(UART_RX,     "uart_receive_task",   4096, 10, 0)
+SCHED_TASK(UART_PARSER, "uart_parser_task",    4096,  9, 0)
+SCHED_TASK(UART_TX,     "uart_tx_task",        4096,  8, 0)
+SCHED_TASK(LVGL,        "taskLVGL",            8192,  4, 1)
+SCHED_TASK(ALARM_LOG,   "alarm_log_task",      3072,  2, 0)
+SCHED_TASK(SETTINGS,    "settings_store_task", 3072,  2, 0)
+SCHED_TASK(DATALOG,     "datalog_task",        3072,  2, 0)
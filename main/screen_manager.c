@@ -0,0 +1,178 @@
+#include "screen_manager.h"
+#include <stddef.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "uart_config.h"
+#include "nav_panel.h"
+#include "screens.h"
+#include "settings_screen.h"
+#include "alarm_log_screen.h"
+#include "trend_screen.h"
+
+typedef struct {
+    const char *name;
+    void (*create)(lv_obj_t *scr);
+    bool keep;
+} screen_def_t;
+
+static const screen_def_t defs[SCREEN_COUNT] = {
+#define SCREEN(id, name, create, keep) [SCREEN_##id] = { name, create, keep },
+#include "ui_screens.h"
+#undef SCREEN
+};
+
+typedef struct {
+    lv_obj_t *scr;
+    size_t cost;            // Heap consumido al crearla
+    uint32_t last_use;      // Valor de use_clock en su última visita
+} screen_slot_t;
+
+static screen_slot_t slots[SCREEN_COUNT];
+static size_t total_cost;
+static uint32_t use_clock;
+
+static bool held;           // screen_manager_hold: sin descartes
+
+static screen_id_t stack[SCREEN_STACK_DEPTH];
+static size_t depth;        // stack[depth - 1] es la visible
+
+static lv_obj_t *create_screen(screen_id_t id) {
+    screen_slot_t *slot = &slots[id];
+    if (slot->scr != NULL) {
+        return slot->scr;
+    }
+    int64_t start = esp_timer_get_time();
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    slot->scr = lv_obj_create(NULL);
+    if (slot->scr == NULL) {
+        ESP_LOGE("SCREEN", "Sin memoria para la pantalla %s", defs[id].name);
+        return NULL;
+    }
+    defs[id].create(slot->scr);
+    size_t free_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    // Otras tareas también reservan y liberan: es una estimación
+    slot->cost = free_before > free_after ? free_before - free_after : 0;
+    total_cost += slot->cost;
+    ESP_LOGI("SCREEN", "Pantalla %s creada en %lu ms, %u KB (total %u KB)", defs[id].name,
+             (unsigned long)((esp_timer_get_time() - start) / 1000), (unsigned)(slot->cost / 1024),
+             (unsigned)(total_cost / 1024));
+    return slot->scr;
+}
+
+static void evict(screen_id_t id) {
+    screen_slot_t *slot = &slots[id];
+    // Borrado inmediato: nunca es la visible y la navegación llega desde la
+    // barra de la capa superior, fuera de la pantalla que se borra
+    lv_obj_delete(slot->scr);
+    slot->scr = NULL;
+    total_cost -= slot->cost;
+    ESP_LOGI("SCREEN", "Pantalla %s descartada, %u KB (total %u KB)", defs[id].name, (unsigned)(slot->cost / 1024),
+             (unsigned)(total_cost / 1024));
+    slot->cost = 0;
+}
+
+// Descarta las menos usadas recientemente hasta entrar en el presupuesto
+static void enforce_budget(lv_obj_t *visible) {
+    while (!held && total_cost > SCREEN_MEM_BUDGET) {
+        int victim = -1;
+        for (int i = 0; i < SCREEN_COUNT; i++) {
+            if (slots[i].scr == NULL || slots[i].scr == visible || defs[i].keep) {
+                continue;
+            }
+            if (victim < 0 || slots[i].last_use < slots[victim].last_use) {
+                victim = i;
+            }
+        }
+        if (victim < 0) {
+            return;     // Sólo quedan la visible y las fijas
+        }
+        evict((screen_id_t)victim);
+    }
+}
+
+static void load(screen_id_t id) {
+    lv_obj_t *scr = create_screen(id);
+    if (scr == NULL) {
+        return;
+    }
+    slots[id].last_use = ++use_clock;
+    if (lv_screen_active() != scr) {
+        lv_screen_load(scr);
+    }
+    enforce_budget(scr);
+}
+
+void screen_manager_show(screen_id_t id) {
+    if (id >= SCREEN_COUNT) {
+        return;
+    }
+    size_t i = 0;
+    while (i < depth && stack[i] != id) {
+        i++;
+    }
+    if (i < depth) {
+        depth = i + 1;      // Ya estaba: desapilar hasta ella
+    } else {
+        if (depth == SCREEN_STACK_DEPTH) {
+            // Pila llena: se olvida la más antigua por encima de la de inicio
+            for (size_t j = 1; j + 1 < depth; j++) {
+                stack[j] = stack[j + 1];
+            }
+            depth--;
+        }
+        stack[depth++] = id;
+    }
+    load(id);
+}
+
+void screen_manager_back(void) {
+    if (depth > 1) {
+        depth--;
+    }
+    load(stack[depth - 1]);
+}
+
+void screen_manager_home(void) {
+    depth = 1;
+    load(stack[0]);
+}
+
+lv_obj_t *screen_manager_get(screen_id_t id) {
+    return id < SCREEN_COUNT ? create_screen(id) : NULL;
+}
+
+void screen_manager_hold(bool hold) {
+    held = hold;
+    enforce_budget(lv_screen_active());
+}
+
+// Callbacks de la barra de navegación
+static void nav_home(void) {
+    screen_manager_home();
+}
+
+static void nav_settings(void) {
+    screen_manager_show(SCREEN_SETTINGS);
+}
+
+static void nav_alarms(void) {
+    screen_manager_show(SCREEN_ALARMS);
+}
+
+static void nav_trends(void) {
+    screen_manager_show(SCREEN_TRENDS);
+}
+
+void screen_manager_init(lv_display_t *disp) {
+    create_nav_panel(lv_display_get_layer_top(disp), nav_home, nav_settings, nav_alarms, nav_trends,
+                     screen_manager_back);
+    for (int i = 0; i < SCREEN_COUNT; i++) {
+        if (defs[i].keep) {
+            create_screen((screen_id_t)i);
+        }
+    }
+    stack[0] = (screen_id_t)0;
+    depth = 1;
+    load(stack[0]);
+}
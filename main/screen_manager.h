@@ -0,0 +1,45 @@
+// screen_manager.h
+#ifndef SCREEN_MANAGER_H
+#define SCREEN_MANAGER_H
+
+#include "lvgl.h"
+
+// Navegación entre las pantallas de ui_screens.h:
+//   - la barra de navegación se crea una sola vez en la capa superior del
+//     display y se ve sobre todas las pantallas
+//   - pila de "atrás" de SCREEN_STACK_DEPTH entradas; volver a una pantalla
+//     que ya está en la pila la desapila hasta ella, así que no crece en bucles
+//   - cada pantalla se crea en su primera visita; tras cada cambio, mientras
+//     lo creado supere SCREEN_MEM_BUDGET se descarta la menos usada
+//     recientemente (nunca la visible ni las fijas)
+// El coste de una pantalla es el heap que consumió al crearse. Todo en el
+// contexto de LVGL (o con su lock).
+
+typedef enum {
+#define SCREEN(id, name, create, keep) SCREEN_##id,
+#include "ui_screens.h"
+#undef SCREEN
+    SCREEN_COUNT
+} screen_id_t;
+
+// Crea la barra de navegación y las pantallas fijas y carga la de inicio
+void screen_manager_init(lv_display_t *disp);
+
+// Carga la pantalla (creándola si hace falta) y la apila
+void screen_manager_show(screen_id_t id);
+
+// Vuelve a la anterior de la pila (en la de inicio no hace nada)
+void screen_manager_back(void);
+
+// Vacía la pila y vuelve a la de inicio
+void screen_manager_home(void);
+
+// La pantalla, creándola si hace falta, sin cargarla ni descartar otras
+// (RENDER:BENCH). Puede devolver NULL si la creación falla.
+lv_obj_t *screen_manager_get(screen_id_t id);
+
+// Suspende los descartes mientras hold (RENDER:BENCH guarda punteros a las
+// pantallas y la barra sigue activa); al soltar se vuelve al presupuesto
+void screen_manager_hold(bool hold);
+
+#endif // SCREEN_MANAGER_H
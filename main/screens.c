@@ -5,110 +5,46 @@
 #include "esp_log.h"
 #include "esp_lvgl_port.h"
 #include "uart_utils.h"
-
-// Definiciones de errores
-#define NUM_ERRORES 8
-
-const char *mensajes_errores[NUM_ERRORES] = {
-    "Error 0: Sobrecalentamiento T1",
-    "Error 1: Sobrecalentamiento T2",
-    "Error 2: Volumen fuera de rango",
-    "Error 3: Comunicacion UART fallida",
-    "Error 4: Sensor de temperatura desconectado",
-    "Error 5: Bateria baja",
-    "Error 6: Memoria insuficiente",
-    "Error 7: Otro error desconocido"
-};
-
-// Función para verificar si un bit específico está activado
-bool is_bit_set(uint8_t byte, uint8_t bit_position) {
-    if (bit_position >= 8) {
-        // Posición de bit inválida
-        return false;
-    }
-    return (byte & (1 << bit_position)) != 0;
-}
-
-// Función para obtener los mensajes de errores activos
-char* get_active_errors(uint8_t error_byte) {
-    // Estimar el tamaño máximo necesario
-    size_t max_size = NUM_ERRORES * 50; // Ajusta según tus mensajes
-    char *error_messages = (char*)malloc(max_size);
-    if (error_messages == NULL) {
-        // Manejar error de asignación de memoria
-        return NULL;
-    }
-    error_messages[0] = '\0'; // Inicializar cadena vacía
-
-    for (uint8_t i = 0; i < NUM_ERRORES; i++) {
-        if (is_bit_set(error_byte, i)) {
-            strcat(error_messages, mensajes_errores[i]);
-            strcat(error_messages, "\n"); // Nueva línea para cada error
-        }
-    }
-
-    if (strlen(error_messages) == 0) {
-        strcpy(error_messages, "Ninguna");
-    }
-
-    return error_messages;
-}
+#include "uart_tx.h"
+#include "telemetry_store.h"
+#include "ui_update.h"
+#include "ui_format.h"
+#include "alarms.h"
 
 static lv_obj_t *label_temp1;
 static lv_obj_t *label_temp2;
 static lv_obj_t *label_volume;
 static lv_obj_t *label_alarm; // Etiqueta para errores
 
-// Definir la estructura para los datos UART
-typedef struct {
-    float t1;
-    float t2;
-    int vol;
-    uint8_t errores;
-} uart_data_t;
-
-static uart_data_t latest_data;
-
-// Función de callback para actualizar las etiquetas
-static void update_labels_callback(void *param) {
-    uart_data_t *data = (uart_data_t *)param;
-    lv_label_set_text_fmt(label_temp1, "T1: %.2f °C", data->t1);
-    lv_label_set_text_fmt(label_temp2, "T2: %.2f °C", data->t2);
-    lv_label_set_text_fmt(label_volume, "Volumen: %d ml", data->vol);
-    
-    // Obtener los mensajes de errores activos
-    char *errores_activos = get_active_errors(data->errores);
-    if (errores_activos != NULL) {
-        lv_label_set_text(label_alarm, errores_activos);
-        free(errores_activos); // Liberar la memoria asignada
-    } else {
-        lv_label_set_text(label_alarm, "Error al procesar errores");
+// Observers de los subjects del almacén: se ejecutan en el contexto de LVGL
+static void temp_observer_cb(lv_observer_t *observer, lv_subject_t *subject) {
+    char text[24];
+    if (!telemetry_store_has_data()) {
+        return; // Mantener "--" hasta la primera trama
     }
+    ui_fmt_label(text, sizeof(text), lv_observer_get_user_data(observer),
+                 lv_subject_get_int(subject), 2, " °C");
+    ui_label_set_text_if_changed(lv_observer_get_target_obj(observer), text);
 }
 
-static void screen_data_handler(const char *data) {
-    ESP_LOGI("SCREEN", "Handler invocado con: %s", data);
-    if (strncmp(data, "DATA", 4) == 0) {
-        float t1, t2;
-        int vol;
-        uint8_t errores = 0;
-        // Parsear ERR=0xXX
-        int parsed = sscanf(data, "DATA:T1=%f;T2=%f;VOL=%d;ERR=0x%hhX;", &t1, &t2, &vol, &errores);
-        if (parsed >= 3) {
-            ESP_LOGI("SCREEN", "Datos procesados: T1=%.2f, T2=%.2f, Volumen=%d", t1, t2, vol);
-
-            // Almacenar los datos más recientes
-            latest_data.t1 = t1;
-            latest_data.t2 = t2;
-            latest_data.vol = vol;
-            latest_data.errores = errores;
-
-            // Programar la actualización de las etiquetas en el loop principal de LVGL
-            lv_async_call(update_labels_callback, &latest_data);
-        } else {
-            ESP_LOGW("SCREEN", "Formato de datos incorrecto: %s", data);
-        }
+static void volume_observer_cb(lv_observer_t *observer, lv_subject_t *subject) {
+    char text[24];
+    if (!telemetry_store_has_data()) {
+        return;
     }
+    ui_fmt_label(text, sizeof(text), "Volumen: ", lv_subject_get_int(subject), 0, " ml");
+    ui_label_set_text_if_changed(lv_observer_get_target_obj(observer), text);
+}
+
+static void alarm_observer_cb(lv_observer_t *observer, lv_subject_t *subject) {
+    // El subject sólo cambia cuando cambia el mapa: no se regenera el texto por trama
+    static char alarm_text[ALARM_TEXT_SIZE];
+    alarm_set_t alarms;
+    if (!telemetry_store_read_alarms(&alarms)) {
+        return;
+    }
+    alarm_render(&alarms, alarm_text, sizeof(alarm_text));
+    ui_label_set_text_if_changed(lv_observer_get_target_obj(observer), alarm_text);
 }
 
 // Callback genérico para manejar eventos de botones
@@ -118,10 +54,10 @@ void button_event_handler(lv_event_t *e) {
 
     if (strcmp(btn_label, "START") == 0) {
         ESP_LOGI("BUTTON", "Botón Start presionado.");
-        send_command("CMD:STA01*");
+        uart_tx_send("CMD:STA01*", UART_TX_FLAG_IDEMPOTENT);
     } else if (strcmp(btn_label, "STOP") == 0) {
         ESP_LOGI("BUTTON", "Botón Stop presionado.");
-        send_command("CMD:STO01*");
+        uart_tx_send("CMD:STO01*", UART_TX_FLAG_IDEMPOTENT);
     } else if (strcmp(btn_label, "RESET") == 0) {
         ESP_LOGI("BUTTON", "Botón Reset presionado.");
         send_command("CMD:RES01*");
@@ -134,8 +70,8 @@ void button_event_handler(lv_event_t *e) {
 void create_main_screen(lv_obj_t *scr) {
     ESP_LOGI("SCREEN", "Creando pantalla principal");
 
-    // Configura el handler para la pantalla principal
-    uart_register_handler(screen_data_handler);
+    // Registra los manejadores DATA/DLT del almacén de telemetría
+    telemetry_store_init();
     // Fondo de la pantalla principal
     lv_obj_t *bg = lv_obj_create(scr);
     lv_obj_set_size(bg, lv_pct(100), lv_pct(100));
@@ -204,6 +140,12 @@ void create_main_screen(lv_obj_t *scr) {
     lv_obj_set_style_text_font(label_alarm, &lv_font_montserrat_20, 0);
     lv_obj_align(label_alarm, LV_ALIGN_TOP_LEFT, 10, 10); // Alineado dentro del cuadro de alarmas
 
+    // Enlazar las etiquetas con el almacén de telemetría
+    lv_subject_add_observer_obj(telemetry_store_subject(TELEMETRY_SUBJECT_T1), temp_observer_cb, label_temp1, "T1: ");
+    lv_subject_add_observer_obj(telemetry_store_subject(TELEMETRY_SUBJECT_T2), temp_observer_cb, label_temp2, "T2: ");
+    lv_subject_add_observer_obj(telemetry_store_subject(TELEMETRY_SUBJECT_VOL), volume_observer_cb, label_volume, NULL);
+    lv_subject_add_observer_obj(telemetry_store_subject(TELEMETRY_SUBJECT_ALARMS), alarm_observer_cb, label_alarm, NULL);
+
     // Crear botones y asignar el callback genérico
     struct {
         const char *label;
@@ -0,0 +1,13 @@
+// Registro de claves de las tramas SETTINGS: SETTINGS_KEY(nombre, tipo, mínimo, máximo)
+// Una clave nueva es una línea más; su hueco es la posición en la tabla.
+// P1..P8 deben ser las primeras: se corresponden con los campos del protocolo binario.
+
+SETTINGS_KEY(P1, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(P2, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(P3, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(P4, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(P5, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(P6, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(P7, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(P8, KV_TYPE_INT, 0, 100)
+SETTINGS_KEY(CHK, KV_TYPE_BOOL, 0, 1)
@@ -0,0 +1,116 @@
+// settings_rx.c
+#include "settings_rx.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "uart_utils.h"
+
+#define SETTINGS_KEY(name, type, min, max) {#name, type, min, max, SETTINGS_SLOT_##name},
+static const kv_key_t settings_keys[SETTINGS_SLOT_COUNT] = {
+#include "settings_keys.h"
+};
+#undef SETTINGS_KEY
+
+_Static_assert(SETTINGS_SLOT_P1 == 0 && SETTINGS_SLOT_P8 == TP_SETTINGS_PARAMS - 1,
+               "P1..P8 deben ocupar los primeros huecos");
+
+static kv_registry_t settings_registry;
+static uint16_t settings_index[KV_INDEX_SIZE(SETTINGS_SLOT_COUNT)];
+
+// Claves pendientes de mostrar: el parser las acumula y el siguiente refresco
+// del display las consume. Sin malloc por trama; de cada clave se guarda el último valor.
+static settings_data_t pending_settings;
+static bool pending_available = false;
+static portMUX_TYPE pending_lock = portMUX_INITIALIZER_UNLOCKED;
+
+bool settings_rx_take(settings_data_t *out) {
+    portENTER_CRITICAL(&pending_lock);
+    bool available = pending_available;
+    if (available) {
+        *out = pending_settings;
+        memset(pending_settings.present, 0, sizeof(pending_settings.present));
+        pending_available = false;
+    }
+    portEXIT_CRITICAL(&pending_lock);
+    return available;
+}
+
+// Acumula los valores recibidos para el siguiente refresco del display
+static void publish_settings(const settings_data_t *data) {
+    portENTER_CRITICAL(&pending_lock);
+    for (int slot = 0; slot < SETTINGS_SLOT_COUNT; slot++) {
+        if (settings_has(data, slot)) {
+            pending_settings.values[slot] = data->values[slot];
+        }
+    }
+    for (size_t i = 0; i < sizeof(pending_settings.present) / sizeof(pending_settings.present[0]); i++) {
+        pending_settings.present[i] |= data->present[i];
+    }
+    pending_available = true;
+    portEXIT_CRITICAL(&pending_lock);
+}
+
+// Manejador de datos de configuración (prefijo "SETTINGS" registrado en uart_register_handler)
+static void settings_data_handler(const char *data) {
+    const char *prefix = "SETTINGS:";
+    size_t prefix_len = strlen(prefix);
+    if (strncmp(data, prefix, prefix_len) != 0) {
+        ESP_LOGW("SETTINGS", "Trama ignorada (no comienza con 'SETTINGS:'): %s", data);
+        return;
+    }
+
+    // El framer ya quitó CR/LF; la trama se recorre sin copiarla
+    settings_data_t settings_data = {0};
+    kv_error_t err;
+    if (kv_parse(&settings_registry, data + prefix_len, strlen(data + prefix_len), settings_data.values,
+                 settings_data.present, &err) != KV_OK) {
+        ESP_LOGW("SETTINGS", "Trama SETTINGS rechazada: %s en '%s' (columna %u)", kv_result_str(err.result),
+                 err.key != NULL ? err.key->name : "?", (unsigned)(prefix_len + err.offset));
+        return;
+    }
+
+    publish_settings(&settings_data);
+}
+
+// Valor binario en su hueco, con los límites del registro como en la trama de texto
+static bool settings_set_checked(settings_data_t *data, int slot, int32_t value) {
+    if (kv_check(&settings_keys[slot], value) != KV_OK) {
+        ESP_LOGW("SETTINGS", "Trama SETTINGS binaria rechazada: %s=%ld fuera de rango", settings_keys[slot].name,
+                 (long)value);
+        return false;
+    }
+    data->values[slot] = value;
+    data->present[slot >> 5] |= 1u << (slot & 31);
+    return true;
+}
+
+// Manejador de la trama binaria TP_MSG_SETTINGS
+static void settings_bin_handler(const tp_msg_t *msg) {
+    settings_data_t settings_data = {0};
+
+    // Como kv_parse: un valor fuera de rango descarta la trama completa
+    for (int i = 0; i < TP_SETTINGS_PARAMS; i++) {
+        if (!settings_set_checked(&settings_data, SETTINGS_SLOT_P1 + i, msg->settings.params[i])) {
+            return;
+        }
+    }
+    if (!settings_set_checked(&settings_data, SETTINGS_SLOT_CHK, msg->settings.chk)) {
+        return;
+    }
+
+    publish_settings(&settings_data);
+}
+
+const kv_key_t *settings_rx_key(int slot) {
+    return &settings_keys[slot];
+}
+
+bool settings_rx_init(void) {
+    if (!kv_registry_init(&settings_registry, settings_keys, SETTINGS_SLOT_COUNT, settings_index,
+                          sizeof(settings_index) / sizeof(settings_index[0]))) {
+        ESP_LOGE("SETTINGS", "Registro de claves SETTINGS inválido");
+        return false;
+    }
+    return uart_register_handler("SETTINGS", settings_data_handler) &&
+           uart_register_bin_handler(TP_MSG_SETTINGS, settings_bin_handler);
+}
@@ -0,0 +1,38 @@
+#ifndef SETTINGS_RX_H
+#define SETTINGS_RX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kv_parser.h"
+
+// Tramas SETTINGS del controlador, de texto y binarias: se validan con el
+// registro de claves y se acumulan hasta que el display las recoge. Sin LVGL.
+
+// Huecos del registro de claves: SETTINGS_SLOT_P1 ... SETTINGS_SLOT_CHK
+#define SETTINGS_KEY(name, type, min, max) SETTINGS_SLOT_##name,
+enum {
+#include "settings_keys.h"
+    SETTINGS_SLOT_COUNT
+};
+#undef SETTINGS_KEY
+
+typedef struct {
+    int32_t values[SETTINGS_SLOT_COUNT];                // Valor de cada clave del registro
+    uint32_t present[(SETTINGS_SLOT_COUNT + 31) / 32];  // Claves recibidas en la trama
+} settings_data_t;
+
+static inline bool settings_has(const settings_data_t *data, int slot) {
+    return (data->present[slot >> 5] >> (slot & 31)) & 1;
+}
+
+// Construye el registro y registra los handlers "SETTINGS" y TP_MSG_SETTINGS
+bool settings_rx_init(void);
+
+// Clave de un hueco: nombre y límites
+const kv_key_t *settings_rx_key(int slot);
+
+// Recoge las claves acumuladas desde la llamada anterior (de cada una, el
+// último valor); false si no llegó ninguna
+bool settings_rx_take(settings_data_t *out);
+
+#endif // SETTINGS_RX_H
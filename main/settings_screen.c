@@ -3,9 +3,17 @@
 #include "uart_config.h" // Incluye la configuración de UART si es necesario
 #include "esp_log.h"
 #include "esp_lvgl_port.h"
-#include <stdlib.h> // Para malloc y free
+#include "freertos/FreeRTOS.h"
+#include <stdlib.h> // Para atoi
+#include <stdint.h>
 #include <string.h>
 #include "uart_utils.h" // Incluye las funciones de UART centralizadas
+#include "uart_tx.h"
+#include "trace.h"
+#include "settings_rx.h"
+#include "ui_update.h"
+#include "ui_format.h"
+#include "settings_store.h"
 
 #define NUM_PARAMS 8
 
@@ -16,16 +24,16 @@ lv_obj_t *param_value_labels[NUM_PARAMS] = {NULL};
 typedef struct
 {
     lv_obj_t *label;   // Etiqueta del valor asociado
+    int slot;          // Hueco del registro (SETTINGS_SLOT_P1 + i)
     int increment;     // Incremento (positivo o negativo)
     lv_timer_t *timer; // Temporizador para manejar mantenimientos prolongados
 } btn_data_t;
 
-// Definición de la estructura para datos de configuración
-typedef struct
-{
-    int params[NUM_PARAMS]; // Almacena los valores de P1 a P8
-    bool chk;               // Almacena el estado del checkbox
-} settings_data_t;
+_Static_assert(NUM_PARAMS == TP_SETTINGS_PARAMS, "una etiqueta por parámetro del protocolo");
+_Static_assert(SETTINGS_SLOT_COUNT <= SETTINGS_STORE_SLOTS, "el blob de settings_store no tiene sitio para todas las claves");
+
+// Valores por defecto si NVS no tiene nada guardado
+static const int32_t default_values[SETTINGS_SLOT_COUNT] = {50, 100, 75, 25, 33, 77, 34, 32};
 
 // Funciones de callback para los botones de incremento, decremento y acciones
 static void increment_callback(lv_event_t *e);
@@ -42,51 +50,51 @@ lv_obj_t *checkbox;
 // Función para actualizar el estado del checkbox
 void actualizar_checkbox(lv_obj_t *checkbox, bool estado)
 {
-    if (estado)
+    // Sólo se toca (e invalida) el checkbox si cambia de estado
+    if (ui_obj_set_state_if_changed(checkbox, LV_STATE_CHECKED, estado))
     {
-        lv_obj_add_state(checkbox, LV_STATE_CHECKED); // Marcar el checkbox
-        ESP_LOGI("Checkbox", "El checkbox fue marcado programáticamente");
-    }
-    else
-    {
-        lv_obj_remove_state(checkbox, LV_STATE_CHECKED); // Desmarcar el checkbox
-        ESP_LOGI("Checkbox", "El checkbox fue desmarcado programáticamente");
+        ESP_LOGI("Checkbox", "El checkbox fue %s programáticamente", estado ? "marcado" : "desmarcado");
     }
 }
 
-// Función para limpiar caracteres no deseados
-void clean_data(char *data)
+// Hook de ui_update: actualiza la UI de settings una vez por refresco del display
+static bool update_settings_ui_hook(void)
 {
-    char *src = data, *dst = data;
-    while (*src)
+    settings_data_t data;
+
+    if (!settings_rx_take(&data))
     {
-        if (*src != '\r' && *src != '\n')
+        return false;
+    }
+
+    // Lo recibido del controlador también se guarda (agrupado por settings_store)
+    for (int slot = 0; slot < SETTINGS_SLOT_COUNT; slot++)
+    {
+        if (settings_has(&data, slot))
         {
-            *dst++ = *src;
+            settings_store_set(slot, data.values[slot]);
         }
-        src++;
     }
-    *dst = '\0';
-}
 
-// Función de callback para actualizar la UI de settings
-static void update_settings_ui_callback(void *param)
-{
-    settings_data_t *data = (settings_data_t *)param;
-
-    if (data == NULL)
+    // Pantalla sin construir o descartada: tomará los valores de settings_store al crearse
+    if (checkbox == NULL)
     {
-        ESP_LOGE("UPDATE_UI", "Datos nulos en update_settings_ui_callback");
-        return;
+        return false;
     }
 
-    // Actualizar cada parámetro
+    // Actualizar cada parámetro recibido
     for (int i = 0; i < NUM_PARAMS; i++)
     {
+        if (!settings_has(&data, SETTINGS_SLOT_P1 + i))
+        {
+            continue;
+        }
         if (param_value_labels[i] != NULL)
         {
-            lv_label_set_text_fmt(param_value_labels[i], "%d", data->params[i]);
-            ESP_LOGI("SETTINGS", "Parametro P%d actualizado a: %d", i + 1, data->params[i]);
+            char text[12];
+            ui_fmt_int(text, sizeof(text), data.values[SETTINGS_SLOT_P1 + i]);
+            ui_label_set_text_if_changed(param_value_labels[i], text);
+            TRACE(SETTINGS_PARAM, i + 1, data.values[SETTINGS_SLOT_P1 + i], 0);
         }
         else
         {
@@ -95,108 +103,19 @@ static void update_settings_ui_callback(void *param)
     }
 
     // Actualizar el checkbox
-    if (checkbox != NULL)
-    {
-        actualizar_checkbox(checkbox, data->chk);
-        ESP_LOGI("SETTINGS", "Checkbox actualizado a: %d", data->chk);
-    }
-    else
-    {
-        ESP_LOGE("SETTINGS", "Checkbox no está inicializado");
-    }
-
-    // Liberar la memoria asignada a data
-    free(data);
-}
-
-// Manejador de datos de configuración
-static void settings_data_handler(const char *data)
-{
-    ESP_LOGI("SCREEN", "Handler invocado en settings con: %s", data);
-
-    // Limpiar caracteres no deseados
-    char cleaned_data[512];
-    strncpy(cleaned_data, data, sizeof(cleaned_data) - 1);
-    cleaned_data[sizeof(cleaned_data) - 1] = '\0';
-    clean_data(cleaned_data);
-
-    ESP_LOGI("SCREEN", "Datos limpiados: %s", cleaned_data);
-
-    // Verificar que la cadena comience con "SETTINGS:"
-    const char *prefix = "SETTINGS:";
-    if (strncmp(cleaned_data, prefix, strlen(prefix)) == 0)
+    if (settings_has(&data, SETTINGS_SLOT_CHK))
     {
-        ESP_LOGI("SETTINGS", "Procesando datos de configuración: %s", cleaned_data + strlen(prefix));
-
-        // Puntero al inicio de los datos después de "SETTINGS:"
-        char *params_str = cleaned_data + strlen(prefix);
-
-        // Crear una estructura para almacenar los datos
-        settings_data_t *settings_data = (settings_data_t *)malloc(sizeof(settings_data_t));
-        if (settings_data == NULL)
+        if (checkbox != NULL)
         {
-            ESP_LOGE("SETTINGS", "No se pudo asignar memoria para settings_data_t");
-            return;
+            actualizar_checkbox(checkbox, data.values[SETTINGS_SLOT_CHK] != 0);
+            TRACE(SETTINGS_CHK, data.values[SETTINGS_SLOT_CHK], 0, 0);
         }
-        memset(settings_data, 0, sizeof(settings_data_t));
-
-        // Tokenizar la cadena por ';' para obtener cada par clave-valor
-        char *token = strtok(params_str, ";");
-        while (token != NULL)
+        else
         {
-            // Buscar la posición del '='
-            char *equals_pos = strchr(token, '=');
-            if (equals_pos != NULL)
-            {
-                // Separar la clave y el valor
-                *equals_pos = '\0';
-                char *key = token;
-                char *value_str = equals_pos + 1;
-                int value = atoi(value_str);
-
-                // Procesar según la clave
-                if (strncmp(key, "P", 1) == 0)
-                {
-                    // Procesar parámetros P1 a P8
-                    int param_num = atoi(key + 1); // Obtener el número después de 'P'
-
-                    if (param_num >= 1 && param_num <= NUM_PARAMS)
-                    {
-                        settings_data->params[param_num - 1] = value;
-                        ESP_LOGI("SETTINGS", "Parametro P%d enviado para actualización: %d", param_num, value);
-                    }
-                    else
-                    {
-                        ESP_LOGW("SETTINGS", "Parametro P%d fuera de rango", param_num);
-                    }
-                }
-                else if (strcmp(key, "CHK") == 0)
-                {
-                    // Procesar el checkbox
-                    settings_data->chk = (value != 0);
-                    ESP_LOGI("SETTINGS", "Checkbox enviado para actualización: %d", value);
-                }
-                else
-                {
-                    ESP_LOGW("SETTINGS", "Clave desconocida: %s", key);
-                }
-            }
-            else
-            {
-                ESP_LOGW("SETTINGS", "Formato de token incorrecto: %s", token);
-            }
-
-            // Obtener el siguiente token
-            token = strtok(NULL, ";");
+            ESP_LOGE("SETTINGS", "Checkbox no está inicializado");
         }
-
-        // Programar la actualización de la UI en el contexto seguro de LVGL
-        lv_async_call(update_settings_ui_callback, settings_data);
-    }
-    else
-    {
-        ESP_LOGW("SETTINGS", "Trama ignorada (no comienza con 'SETTINGS:'): %s", cleaned_data);
     }
+    return true;
 }
 
 // Función para manejar incrementos o decrementos
@@ -219,6 +138,7 @@ static void update_value(btn_data_t *btn_data)
         value = 100;
 
     lv_label_set_text_fmt(btn_data->label, "%d", value);
+    settings_store_set(btn_data->slot, value); // Sin tocar la flash: se escribe al soltar
 }
 
 // Función estática para manejar el temporizador
@@ -326,7 +246,8 @@ static void checkbox_event_handler(lv_event_t *e)
 {
     lv_obj_t *checkbox = lv_event_get_target(e);
 
-    if (lv_obj_has_state(checkbox, LV_STATE_CHECKED))
+    bool checked = lv_obj_has_state(checkbox, LV_STATE_CHECKED);
+    if (checked)
     {
         ESP_LOGI("Checkbox", "El checkbox está marcado");
     }
@@ -334,6 +255,38 @@ static void checkbox_event_handler(lv_event_t *e)
     {
         ESP_LOGI("Checkbox", "El checkbox está desmarcado");
     }
+    settings_store_set(SETTINGS_SLOT_CHK, checked);
+}
+
+void settings_screen_init(void)
+{
+    // Los últimos guardados en NVS o, si no hay, los valores por defecto
+    int32_t values[SETTINGS_SLOT_COUNT];
+    memcpy(values, default_values, sizeof(values));
+    if (settings_store_restore(values, SETTINGS_SLOT_COUNT) > 0)
+    {
+        ESP_LOGI("SETTINGS", "Valores restaurados de NVS");
+    }
+    // Un blob antiguo puede traer valores fuera del rango actual de la clave
+    for (int slot = 0; slot < SETTINGS_SLOT_COUNT; slot++)
+    {
+        const kv_key_t *key = settings_rx_key(slot);
+        if (values[slot] < key->min || values[slot] > key->max)
+        {
+            settings_store_set(slot, values[slot] < key->min ? key->min : key->max);
+        }
+    }
+
+    // Lo recibido antes de abrir la pantalla se guarda igualmente
+    ui_update_register(update_settings_ui_hook);
+    settings_rx_init();
+}
+
+// Pantalla descartada (screen_manager): el hook deja de tocar sus widgets
+static void screen_delete_callback(lv_event_t *e)
+{
+    checkbox = NULL;
+    memset(param_value_labels, 0, sizeof(param_value_labels));
 }
 
 // Función para crear la pantalla de ajustes
@@ -341,19 +294,23 @@ void create_settings_screen(lv_obj_t *scr)
 {
     ESP_LOGI("SETTINGS", "Creando pantalla de ajustes");
 
-    // Configura el handler para la pantalla de ajustes
-    uart_register_handler(settings_data_handler);
-
     // Fondo de la pantalla
     lv_obj_t *bg = lv_obj_create(scr);
     lv_obj_set_size(bg, LV_PCT(100), LV_PCT(100));
     lv_obj_set_style_bg_color(bg, lv_color_hex(0xFFFFFF), LV_PART_MAIN); // Blanco
     lv_obj_set_style_bg_opa(bg, LV_OPA_COVER, LV_PART_MAIN);
 
-    // Fuente Montserrat 20
+    lv_obj_add_event_cb(scr, screen_delete_callback, LV_EVENT_DELETE, NULL);
+
+    // Fuente Montserrat 20 (una sola vez: la pantalla puede recrearse)
     static lv_style_t font_style;
-    lv_style_init(&font_style);
-    lv_style_set_text_font(&font_style, &lv_font_montserrat_20);
+    static bool font_style_ready = false;
+    if (!font_style_ready)
+    {
+        lv_style_init(&font_style);
+        lv_style_set_text_font(&font_style, &lv_font_montserrat_20);
+        font_style_ready = true;
+    }
 
     // Título
     lv_obj_t *title = lv_label_create(scr);
@@ -381,8 +338,14 @@ void create_settings_screen(lv_obj_t *scr)
 
     // Parámetros
     const char *param_labels[] = {"Parametro 1", "Parametro 2", "Parametro 3", "Parametro 4", "Parametro 5", "Parametro 6", "Parametro 7", "Parametro 8"};
-    int initial_values[] = {50, 100, 75, 25, 33, 77, 34, 32};
-    const int num_params = sizeof(initial_values) / sizeof(initial_values[0]);
+    int32_t initial_values[SETTINGS_SLOT_COUNT];
+    memcpy(initial_values, default_values, sizeof(initial_values));
+    settings_store_get(initial_values, SETTINGS_SLOT_COUNT);
+    const int num_params = NUM_PARAMS;
+    if (initial_values[SETTINGS_SLOT_CHK])
+    {
+        lv_obj_add_state(checkbox, LV_STATE_CHECKED);
+    }
 
     // Margen superior inicial después del título
     int row_spacing = 15; // Espaciado entre filas
@@ -408,7 +371,7 @@ void create_settings_screen(lv_obj_t *scr)
 
         // Campo de valor
         lv_obj_t *value_label = lv_label_create(param_row);
-        lv_label_set_text_fmt(value_label, "%d", initial_values[i]);
+        lv_label_set_text_fmt(value_label, "%d", (int)initial_values[i]);
         lv_obj_add_style(value_label, &font_style, 0);
         lv_obj_align(value_label, LV_ALIGN_CENTER, 0, 0);
 
@@ -426,6 +389,7 @@ void create_settings_screen(lv_obj_t *scr)
             continue; // O manejar el error según sea necesario
         }
         btn_inc_data->label = value_label;
+        btn_inc_data->slot = SETTINGS_SLOT_P1 + i;
         btn_inc_data->increment = 1;
         btn_inc_data->timer = NULL;
 
@@ -454,6 +418,7 @@ void create_settings_screen(lv_obj_t *scr)
             continue; // O manejar el error según sea necesario
         }
         btn_dec_data->label = value_label;
+        btn_dec_data->slot = SETTINGS_SLOT_P1 + i;
         btn_dec_data->increment = -1;
         btn_dec_data->timer = NULL;
 
@@ -506,7 +471,7 @@ static void request_values_callback(lv_event_t *e)
 {
     ESP_LOGI("Settings", "Request Current Values clicked");
     // Aquí puedes implementar la lógica para solicitar valores actuales por UART
-    send_command("GET_SETTINGS*"); // Enviar comando por UART usando función centralizada
+    uart_tx_send("GET_SETTINGS*", UART_TX_FLAG_IDEMPOTENT); // Encolar sin bloquear; peticiones repetidas se agrupan
 }
 
 // Callback para enviar los cambios
@@ -549,5 +514,5 @@ static void apply_changes_callback(lv_event_t *e)
 
     // Enviar la trama por UART
     ESP_LOGI("Settings", "Enviando comando: %s", command);
-    send_command(command); // Enviar comando por UART usando función centralizada
+    uart_tx_send(command, UART_TX_FLAG_REPLACE); // Si aún no salió el anterior, se envía sólo el último
 }
@@ -3,6 +3,11 @@
 
 #include "lvgl.h"
 
+// Registro de claves, manejadores SETTINGS y valores guardados en NVS. Al
+// arrancar, tras settings_store_init; la pantalla puede crearse más tarde.
+void settings_screen_init(void);
+
+// Construye los widgets con los valores actuales (en la primera visita)
 void create_settings_screen(lv_obj_t *scr);
 
 #endif // SETTINGS_SCREEN_H
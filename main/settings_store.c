@@ -0,0 +1,194 @@
+#include "settings_store.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "nvs.h"
+#include "uart_config.h"
+#include "telemetry_proto.h"    // tp_crc16
+#include "trace.h"
+
+#define SETTINGS_BLOB_VERSION 1
+
+// Blob en NVS; sólo se guardan los count primeros valores
+typedef struct {
+    uint16_t version;
+    uint16_t count;
+    uint16_t crc;           // CRC16 de values[0..count)
+    uint16_t reserved;
+    int32_t values[SETTINGS_STORE_SLOTS];
+} settings_blob_t;
+
+static nvs_handle_t nvs = 0;
+static bool nvs_ready = false;
+
+// Estado actual (lo escriben la UI y la tarea parser) y último blob guardado
+static portMUX_TYPE store_lock = portMUX_INITIALIZER_UNLOCKED;
+static int32_t values[SETTINGS_STORE_SLOTS];
+static uint16_t value_count;        // Huecos con valor: 0..value_count-1
+static size_t restored_count;
+static bool dirty = false;
+static TickType_t first_change;     // Primer cambio aún sin guardar
+static TickType_t last_change;
+
+static settings_blob_t saved;       // Sólo settings_store_task (y init)
+static TaskHandle_t task_handle = NULL;
+static settings_store_stats_t stats;
+
+static uint16_t blob_crc(const settings_blob_t *blob) {
+    return tp_crc16((const uint8_t *)blob->values, blob->count * sizeof(int32_t));
+}
+
+static size_t blob_size(const settings_blob_t *blob) {
+    return offsetof(settings_blob_t, values) + blob->count * sizeof(int32_t);
+}
+
+void settings_store_init(void) {
+    esp_err_t err = nvs_open(SETTINGS_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE("SETTINGS_STORE", "NVS no disponible (%s): ajustes sin persistencia", esp_err_to_name(err));
+        stats.errors++;
+        return;
+    }
+    nvs_ready = true;
+
+    settings_blob_t blob;
+    size_t len = sizeof(blob);
+    err = nvs_get_blob(nvs, SETTINGS_NVS_KEY, &blob, &len);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        ESP_LOGI("SETTINGS_STORE", "Sin ajustes guardados: valores por defecto");
+        return;
+    }
+    if (err != ESP_OK || len < offsetof(settings_blob_t, values) || blob.version != SETTINGS_BLOB_VERSION ||
+        blob.count > SETTINGS_STORE_SLOTS || len != blob_size(&blob) || blob.crc != blob_crc(&blob)) {
+        ESP_LOGW("SETTINGS_STORE", "Blob de ajustes inválido (%s, %u bytes): valores por defecto",
+                 esp_err_to_name(err), (unsigned)len);
+        return;
+    }
+    saved = blob;
+    memcpy(values, blob.values, blob.count * sizeof(int32_t));
+    value_count = blob.count;
+    restored_count = blob.count;
+    stats.restored = true;
+    ESP_LOGI("SETTINGS_STORE", "%u ajustes restaurados", (unsigned)blob.count);
+}
+
+size_t settings_store_restore(int32_t *out, size_t count) {
+    if (count > SETTINGS_STORE_SLOTS) {
+        count = SETTINGS_STORE_SLOTS;
+    }
+    portENTER_CRITICAL(&store_lock);
+    size_t n = restored_count < count ? restored_count : count;
+    memcpy(out, values, n * sizeof(int32_t));
+    // Las claves nuevas (no guardadas aún) parten del valor por defecto
+    memcpy(values, out, count * sizeof(int32_t));
+    if (value_count < count) {
+        value_count = (uint16_t)count;
+    }
+    portEXIT_CRITICAL(&store_lock);
+    return n;
+}
+
+void settings_store_set(unsigned slot, int32_t value) {
+    if (slot >= SETTINGS_STORE_SLOTS) {
+        return;
+    }
+    bool notify = false;
+    TickType_t now = xTaskGetTickCount();
+
+    portENTER_CRITICAL(&store_lock);
+    if (slot >= value_count || values[slot] != value) {
+        // Sin settings_store_restore previo, los huecos intermedios quedan a 0
+        for (unsigned i = value_count; i < slot; i++) {
+            values[i] = 0;
+        }
+        if (slot >= value_count) {
+            value_count = (uint16_t)(slot + 1);
+        }
+        values[slot] = value;
+        if (!dirty) {
+            first_change = now;
+            notify = true;
+        }
+        dirty = true;
+        last_change = now;
+        stats.changes++;
+    }
+    portEXIT_CRITICAL(&store_lock);
+
+    if (notify && task_handle != NULL) {
+        xTaskNotifyGive(task_handle);
+    }
+}
+
+size_t settings_store_get(int32_t *out, size_t count) {
+    portENTER_CRITICAL(&store_lock);
+    size_t n = value_count < count ? value_count : count;
+    memcpy(out, values, n * sizeof(int32_t));
+    portEXIT_CRITICAL(&store_lock);
+    return n;
+}
+
+static void save(const settings_blob_t *blob) {
+    if (blob->count == saved.count && memcmp(blob->values, saved.values, blob->count * sizeof(int32_t)) == 0) {
+        stats.skipped++; // Vuelta al valor guardado: nada que escribir
+        return;
+    }
+    esp_err_t err = nvs_set_blob(nvs, SETTINGS_NVS_KEY, blob, blob_size(blob));
+    if (err == ESP_OK) {
+        err = nvs_commit(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE("SETTINGS_STORE", "No se pudieron guardar los ajustes: %s", esp_err_to_name(err));
+        stats.errors++;
+        return;
+    }
+    saved = *blob;
+    stats.writes++;
+    TRACE(SETTINGS_SAVE, blob->count, stats.writes, stats.changes);
+}
+
+void settings_store_task(void *arg) {
+    task_handle = xTaskGetCurrentTaskHandle();
+
+    while (true) {
+        portENTER_CRITICAL(&store_lock);
+        bool pending = dirty;
+        portEXIT_CRITICAL(&store_lock);
+        if (!pending || !nvs_ready) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        // Esperar a que los cambios se calmen, sin pasar de SETTINGS_SAVE_MAX_DELAY_MS
+        settings_blob_t blob = { .version = SETTINGS_BLOB_VERSION };
+        while (true) {
+            TickType_t now = xTaskGetTickCount();
+            TickType_t quiet_until, deadline;
+
+            portENTER_CRITICAL(&store_lock);
+            quiet_until = last_change + pdMS_TO_TICKS(SETTINGS_SAVE_DELAY_MS);
+            deadline = first_change + pdMS_TO_TICKS(SETTINGS_SAVE_MAX_DELAY_MS);
+            bool ready = (int32_t)(now - quiet_until) >= 0 || (int32_t)(now - deadline) >= 0;
+            if (ready) {
+                blob.count = value_count;
+                memcpy(blob.values, values, value_count * sizeof(int32_t));
+                dirty = false;
+            }
+            portEXIT_CRITICAL(&store_lock);
+
+            if (ready) {
+                break;
+            }
+            TickType_t until = (int32_t)(quiet_until - deadline) < 0 ? quiet_until : deadline;
+            vTaskDelay(until - now);
+        }
+        blob.crc = blob_crc(&blob);
+        save(&blob);
+    }
+}
+
+void settings_store_get_stats(settings_store_stats_t *out) {
+    if (out != NULL) {
+        *out = stats;
+    }
+}
@@ -0,0 +1,45 @@
+// settings_store.h
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Copia persistente de los valores de ajustes (huecos de settings_keys.h) en
+// NVS: un único blob con versión, número de valores y CRC, que se lee una vez
+// al arrancar. Los cambios se apuntan en RAM sin bloquear y settings_store_task
+// los escribe cuando llevan SETTINGS_SAVE_DELAY_MS sin cambiar (o, si no paran
+// de cambiar, como mucho cada SETTINGS_SAVE_MAX_DELAY_MS); mantener pulsado
+// +/- acaba en una sola escritura.
+
+#define SETTINGS_STORE_SLOTS 32     // Valores que caben en el blob
+
+typedef struct {
+    uint32_t changes;       // Valores modificados
+    uint32_t writes;        // Escrituras del blob en NVS
+    uint32_t skipped;       // Escrituras evitadas: el blob ya estaba así en NVS
+    uint32_t errors;        // Fallos de NVS
+    bool restored;          // Se recuperó un blob válido al arrancar
+} settings_store_stats_t;
+
+// Abre su espacio de NVS (ya inicializado) y lee el blob. Llamar antes de
+// settings_screen_init.
+void settings_store_init(void);
+
+// Tarea de baja prioridad que escribe los cambios agrupados
+void settings_store_task(void *arg);
+
+// values llega con los valores por defecto y sale con los guardados encima;
+// ese conjunto pasa a ser el estado del store. Devuelve cuántos se restauraron.
+size_t settings_store_restore(int32_t *values, size_t count);
+
+// Apunta el valor de un hueco; sólo programa una escritura si cambia
+void settings_store_set(unsigned slot, int32_t value);
+
+// Valores actuales (restaurados y modificados después); devuelve cuántos se copiaron
+size_t settings_store_get(int32_t *values, size_t count);
+
+void settings_store_get_stats(settings_store_stats_t *out);
+
+#endif // SETTINGS_STORE_H
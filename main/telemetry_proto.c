@@ -0,0 +1,303 @@
+// telemetry_proto.c
+#include "telemetry_proto.h"
+#include <string.h>
+
+#define TP_DATA_PAYLOAD 9                              // t1(2) t2(2) vol(4) err(1)
+#define TP_SETTINGS_PAYLOAD (TP_SETTINGS_PARAMS * 2 + 1) // params(2 c/u) flags(1)
+#define TP_DELTA_HEADER 5                               // seq(4) mask(1)
+
+uint16_t tp_crc16(const uint8_t *data, size_t len) {
+    // CRC-16/CCITT-FALSE: polinomio 0x1021, valor inicial 0xFFFF
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+size_t tp_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    size_t out = 1;       // Reservar el primer byte de código
+    size_t code_pos = 0;
+    uint8_t code = 1;
+
+    if (cap == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[code_pos] = code;
+            code_pos = out++;
+            code = 1;
+        } else {
+            if (out >= cap) {
+                return 0;
+            }
+            dst[out++] = src[i];
+            code++;
+            if (code == 0xFF) {
+                dst[code_pos] = code;
+                code_pos = out++;
+                code = 1;
+            }
+        }
+        if (out > cap) {
+            return 0;
+        }
+    }
+    dst[code_pos] = code;
+    return out;
+}
+
+size_t tp_cobs_decode(const uint8_t *src, size_t len, uint8_t *dst, size_t cap) {
+    size_t in = 0;
+    size_t out = 0;
+
+    while (in < len) {
+        uint8_t code = src[in++];
+        if (code == 0 || in + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            if (out >= cap || src[in] == 0) {
+                return 0;
+            }
+            dst[out++] = src[in++];
+        }
+        if (code != 0xFF && in < len) {
+            if (out >= cap) {
+                return 0;
+            }
+            dst[out++] = 0;
+        }
+    }
+    return out;
+}
+
+static void put_le16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    put_le16(p, (uint16_t)v);
+    put_le16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+    return (uint32_t)get_le16(p) | ((uint32_t)get_le16(p + 2) << 16);
+}
+
+// Añade el CRC al mensaje en claro y lo codifica con COBS + delimitador
+static size_t finish_frame(uint8_t *raw, size_t raw_len, uint8_t *out, size_t cap) {
+    put_le16(&raw[raw_len], tp_crc16(raw, raw_len));
+    raw_len += 2;
+
+    if (cap < 1) {
+        return 0;
+    }
+    size_t n = tp_cobs_encode(raw, raw_len, out, cap - 1);
+    if (n == 0) {
+        return 0;
+    }
+    out[n++] = TP_FRAME_DELIMITER;
+    return n;
+}
+
+size_t tp_encode_data(const tp_data_t *data, uint8_t *out, size_t cap) {
+    uint8_t raw[1 + TP_DATA_PAYLOAD + 2];
+
+    raw[0] = TP_MSG_DATA;
+    put_le16(&raw[1], (uint16_t)data->t1_centi);
+    put_le16(&raw[3], (uint16_t)data->t2_centi);
+    put_le32(&raw[5], (uint32_t)data->vol_ml);
+    raw[9] = data->errors;
+    return finish_frame(raw, 1 + TP_DATA_PAYLOAD, out, cap);
+}
+
+size_t tp_encode_settings(const tp_settings_t *settings, uint8_t *out, size_t cap) {
+    uint8_t raw[1 + TP_SETTINGS_PAYLOAD + 2];
+
+    raw[0] = TP_MSG_SETTINGS;
+    for (int i = 0; i < TP_SETTINGS_PARAMS; i++) {
+        put_le16(&raw[1 + i * 2], (uint16_t)settings->params[i]);
+    }
+    raw[1 + TP_SETTINGS_PARAMS * 2] = settings->chk ? 0x01 : 0x00;
+    return finish_frame(raw, 1 + TP_SETTINGS_PAYLOAD, out, cap);
+}
+
+size_t tp_encode_text(const char *text, uint8_t *out, size_t cap) {
+    uint8_t raw[TP_MAX_RAW];
+    size_t len = strlen(text);
+
+    if (len > TP_MAX_PAYLOAD) {
+        return 0;
+    }
+    raw[0] = TP_MSG_TEXT;
+    memcpy(&raw[1], text, len);
+    return finish_frame(raw, 1 + len, out, cap);
+}
+
+size_t tp_encode_delta(const tp_delta_t *delta, uint8_t *out, size_t cap) {
+    uint8_t raw[1 + TP_DELTA_HEADER + TP_DATA_PAYLOAD + 2];
+    uint8_t mask = delta->mask & TP_FIELD_ALL;
+    size_t n = 1 + TP_DELTA_HEADER;
+
+    if ((delta->flags & TP_DELTA_KEYFRAME) && mask != TP_FIELD_ALL) {
+        return 0;
+    }
+    raw[0] = TP_MSG_DELTA;
+    put_le32(&raw[1], delta->seq);
+    raw[5] = mask | (delta->flags & TP_DELTA_KEYFRAME);
+    if (mask & TP_FIELD_T1) {
+        put_le16(&raw[n], (uint16_t)delta->data.t1_centi);
+        n += 2;
+    }
+    if (mask & TP_FIELD_T2) {
+        put_le16(&raw[n], (uint16_t)delta->data.t2_centi);
+        n += 2;
+    }
+    if (mask & TP_FIELD_VOL) {
+        put_le32(&raw[n], (uint32_t)delta->data.vol_ml);
+        n += 4;
+    }
+    if (mask & TP_FIELD_ERR) {
+        raw[n++] = delta->data.errors;
+    }
+    return finish_frame(raw, n, out, cap);
+}
+
+size_t tp_encode_alarms(const tp_alarms_t *alarms, uint8_t *out, size_t cap) {
+    uint8_t raw[1 + TP_ALARM_WORDS * 4 + 2];
+
+    if (alarms->count == 0 || alarms->count > TP_ALARM_WORDS) {
+        return 0;
+    }
+    raw[0] = TP_MSG_ALARMS;
+    for (int i = 0; i < alarms->count; i++) {
+        put_le32(&raw[1 + i * 4], alarms->words[i]);
+    }
+    return finish_frame(raw, 1 + alarms->count * 4, out, cap);
+}
+
+size_t tp_encoded_len(tp_msg_type_t type, const tp_delta_t *delta) {
+    size_t raw = 1 + 2; // tipo + crc
+    if (type == TP_MSG_DATA) {
+        raw += TP_DATA_PAYLOAD;
+    } else {
+        raw += TP_DELTA_HEADER + ((delta->mask & TP_FIELD_T1) ? 2 : 0) + ((delta->mask & TP_FIELD_T2) ? 2 : 0) +
+               ((delta->mask & TP_FIELD_VOL) ? 4 : 0) + ((delta->mask & TP_FIELD_ERR) ? 1 : 0);
+    }
+    return raw + 1; // COBS añade un byte por cada 254 (las tramas de telemetría son más cortas)
+}
+
+// Campos presentes de una trama delta, en orden de id
+static tp_result_t decode_delta(const uint8_t *payload, size_t len, tp_delta_t *out) {
+    if (len < TP_DELTA_HEADER) {
+        return TP_ERR_LENGTH;
+    }
+    out->seq = get_le32(&payload[0]);
+    out->mask = payload[4] & TP_FIELD_ALL;
+    out->flags = payload[4] & TP_DELTA_KEYFRAME;
+    if ((payload[4] & ~(TP_FIELD_ALL | TP_DELTA_KEYFRAME)) != 0 ||
+        ((out->flags & TP_DELTA_KEYFRAME) && out->mask != TP_FIELD_ALL)) {
+        return TP_ERR_LENGTH;
+    }
+
+    size_t need = TP_DELTA_HEADER + ((out->mask & TP_FIELD_T1) ? 2 : 0) + ((out->mask & TP_FIELD_T2) ? 2 : 0) +
+                  ((out->mask & TP_FIELD_VOL) ? 4 : 0) + ((out->mask & TP_FIELD_ERR) ? 1 : 0);
+    if (len != need) {
+        return TP_ERR_LENGTH;
+    }
+
+    const uint8_t *p = &payload[TP_DELTA_HEADER];
+    if (out->mask & TP_FIELD_T1) {
+        out->data.t1_centi = (int16_t)get_le16(p);
+        p += 2;
+    }
+    if (out->mask & TP_FIELD_T2) {
+        out->data.t2_centi = (int16_t)get_le16(p);
+        p += 2;
+    }
+    if (out->mask & TP_FIELD_VOL) {
+        out->data.vol_ml = (int32_t)get_le32(p);
+        p += 4;
+    }
+    if (out->mask & TP_FIELD_ERR) {
+        out->data.errors = *p;
+    }
+    return TP_OK;
+}
+
+tp_result_t tp_decode(const uint8_t *frame, size_t len, uint8_t *work, tp_msg_t *out) {
+    size_t raw_len = tp_cobs_decode(frame, len, work, TP_MAX_RAW);
+    if (raw_len == 0) {
+        return TP_ERR_COBS;
+    }
+    if (raw_len < 3) {
+        return TP_ERR_SHORT;
+    }
+    size_t payload_len = raw_len - 3;
+    if (tp_crc16(work, raw_len - 2) != get_le16(&work[raw_len - 2])) {
+        return TP_ERR_CRC;
+    }
+
+    const uint8_t *payload = &work[1];
+    out->type = (tp_msg_type_t)work[0];
+    switch (out->type) {
+    case TP_MSG_TEXT:
+        work[1 + payload_len] = '\0'; // Sobrescribe el CRC, ya verificado
+        out->text.str = (const char *)payload;
+        out->text.len = payload_len;
+        return TP_OK;
+    case TP_MSG_DATA:
+        if (payload_len != TP_DATA_PAYLOAD) {
+            return TP_ERR_LENGTH;
+        }
+        out->data.t1_centi = (int16_t)get_le16(&payload[0]);
+        out->data.t2_centi = (int16_t)get_le16(&payload[2]);
+        out->data.vol_ml = (int32_t)get_le32(&payload[4]);
+        out->data.errors = payload[8];
+        return TP_OK;
+    case TP_MSG_SETTINGS:
+        if (payload_len != TP_SETTINGS_PAYLOAD) {
+            return TP_ERR_LENGTH;
+        }
+        for (int i = 0; i < TP_SETTINGS_PARAMS; i++) {
+            out->settings.params[i] = (int16_t)get_le16(&payload[i * 2]);
+        }
+        out->settings.chk = (payload[TP_SETTINGS_PARAMS * 2] & 0x01) != 0;
+        return TP_OK;
+    case TP_MSG_DELTA:
+        return decode_delta(payload, payload_len, &out->delta);
+    case TP_MSG_ALARMS:
+        if (payload_len == 0 || payload_len % 4 != 0 || payload_len > TP_ALARM_WORDS * 4) {
+            return TP_ERR_LENGTH;
+        }
+        out->alarms.count = (uint8_t)(payload_len / 4);
+        for (int i = 0; i < TP_ALARM_WORDS; i++) {
+            out->alarms.words[i] = i < out->alarms.count ? get_le32(&payload[i * 4]) : 0;
+        }
+        return TP_OK;
+    default:
+        return TP_ERR_TYPE;
+    }
+}
+
+const char *tp_result_str(tp_result_t res) {
+    switch (res) {
+    case TP_OK: return "ok";
+    case TP_ERR_COBS: return "cobs";
+    case TP_ERR_SHORT: return "short";
+    case TP_ERR_CRC: return "crc";
+    case TP_ERR_TYPE: return "type";
+    case TP_ERR_LENGTH: return "length";
+    default: return "?";
+    }
+}
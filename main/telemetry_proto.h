@@ -0,0 +1,122 @@
+// telemetry_proto.h
+#ifndef TELEMETRY_PROTO_H
+#define TELEMETRY_PROTO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Protocolo binario de telemetría. Sin dependencias de ESP-IDF: la misma
+// biblioteca sirve para el firmware, el controlador y las herramientas de PC.
+//
+// Trama en el cable: COBS( tipo | payload | crc16_le ) 0x00
+//   - tipo: un byte (tp_msg_type_t)
+//   - payload: campos little-endian de tamaño fijo
+//   - crc16: CRC-16/CCITT-FALSE sobre tipo + payload
+// COBS garantiza que 0x00 sólo aparece como delimitador de trama.
+
+#define TP_FRAME_DELIMITER 0x00
+#define TP_MAX_PAYLOAD 250
+#define TP_MAX_RAW (1 + TP_MAX_PAYLOAD + 2)
+#define TP_MAX_ENCODED (TP_MAX_RAW + TP_MAX_RAW / 254 + 2) // COBS + delimitador
+#define TP_SETTINGS_PARAMS 8
+#define TP_ALARM_WORDS 8        // Hasta 256 alarmas
+
+// Comando ASCII de negociación y respuesta esperada del controlador
+#define TP_NEGOTIATE_CMD "PROTO:BIN1*"
+#define TP_NEGOTIATE_ACK "PROTO:BIN1"
+
+typedef enum {
+    TP_MSG_TEXT = 0x00,      // Línea ASCII encapsulada (ACK, respuestas...)
+    TP_MSG_DATA = 0x01,      // Equivalente a DATA:T1=..;T2=..;VOL=..;ERR=..;
+    TP_MSG_SETTINGS = 0x02,  // Equivalente a SETTINGS:P1=..;...;CHK=..;
+    TP_MSG_DELTA = 0x03,     // Telemetría con secuencia: keyframe o sólo campos cambiados
+    TP_MSG_ALARMS = 0x04,    // Mapa de alarmas completo: 1..TP_ALARM_WORDS palabras de 32 bits
+    TP_MSG_MAX
+} tp_msg_type_t;
+
+typedef enum {
+    TP_OK = 0,
+    TP_ERR_COBS,        // Codificación COBS inválida
+    TP_ERR_SHORT,       // Trama demasiado corta
+    TP_ERR_CRC,         // CRC incorrecto
+    TP_ERR_TYPE,        // Tipo de mensaje desconocido
+    TP_ERR_LENGTH,      // Longitud de payload incorrecta para el tipo
+} tp_result_t;
+
+// Telemetría: temperaturas en centésimas de grado
+typedef struct {
+    int16_t t1_centi;
+    int16_t t2_centi;
+    int32_t vol_ml;
+    uint8_t errors;
+} tp_data_t;
+
+typedef struct {
+    int16_t params[TP_SETTINGS_PARAMS];
+    bool chk;
+} tp_settings_t;
+
+// Campos de la telemetría por id (bit = 1 << (id - 1)) en las tramas delta.
+// En el cable, TP_MSG_DELTA es: seq(4) | mask(1) | campos presentes en orden de id
+#define TP_FIELD_T1 0x01
+#define TP_FIELD_T2 0x02
+#define TP_FIELD_VOL 0x04
+#define TP_FIELD_ERR 0x08
+#define TP_FIELD_ALL 0x0F
+#define TP_FIELD_COUNT 4
+
+#define TP_DELTA_KEYFRAME 0x80  // flags (y bit 7 de mask en el cable): estado completo
+#define TP_DELTA_NO_SEQ 0x40    // flags: keyframe ASCII sin SEQ (controlador sin deltas)
+
+// Mapa de alarmas: bit n = alarma n. Las palabras que no vienen en la trama son 0.
+// En el cable: words[0] | words[1] | ... (le32), tantas como count
+typedef struct {
+    uint8_t count;
+    uint32_t words[TP_ALARM_WORDS];
+} tp_alarms_t;
+
+typedef struct {
+    uint32_t seq;
+    uint8_t mask;       // TP_FIELD_* presentes
+    uint8_t flags;      // TP_DELTA_*
+    tp_data_t data;     // Sólo son válidos los campos de mask
+} tp_delta_t;
+
+typedef struct {
+    tp_msg_type_t type;
+    union {
+        tp_data_t data;
+        tp_settings_t settings;
+        tp_delta_t delta;
+        tp_alarms_t alarms;
+        struct {
+            const char *str; // Apunta al buffer de decodificación, terminado en '\0'
+            size_t len;
+        } text;
+    };
+} tp_msg_t;
+
+uint16_t tp_crc16(const uint8_t *data, size_t len);
+
+// COBS; devuelven el tamaño resultante o 0 si no cabe / es inválido
+size_t tp_cobs_encode(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+size_t tp_cobs_decode(const uint8_t *src, size_t len, uint8_t *dst, size_t cap);
+
+// Codifican un mensaje completo (incluido el delimitador); 0 si no cabe
+size_t tp_encode_data(const tp_data_t *data, uint8_t *out, size_t cap);
+size_t tp_encode_settings(const tp_settings_t *settings, uint8_t *out, size_t cap);
+size_t tp_encode_text(const char *text, uint8_t *out, size_t cap);
+size_t tp_encode_delta(const tp_delta_t *delta, uint8_t *out, size_t cap);
+size_t tp_encode_alarms(const tp_alarms_t *alarms, uint8_t *out, size_t cap);
+
+// Bytes en el cable (sin delimitador) de una trama DATA o DELTA; para contabilidad
+size_t tp_encoded_len(tp_msg_type_t type, const tp_delta_t *delta);
+
+// Decodifica una trama sin el delimitador. `work` debe tener TP_MAX_RAW + 1 bytes;
+// los mensajes de texto apuntan dentro de él.
+tp_result_t tp_decode(const uint8_t *frame, size_t len, uint8_t *work, tp_msg_t *out);
+
+const char *tp_result_str(tp_result_t res);
+
+#endif // TELEMETRY_PROTO_H
@@ -0,0 +1,299 @@
+#include "telemetry_store.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "uart_config.h"
+#include "uart_utils.h"
+#include "uart_tx.h"
+#include "data_parser.h"
+#include "trace.h"
+#include "ui_update.h"
+#include "alarm_log.h"
+
+typedef struct {
+    tp_data_t data;
+    uint32_t alarm_gen;         // Cambia cada vez que cambia el mapa de alarmas
+    alarm_set_t alarms;         // Bits 0..7 de ERR, o el mapa completo de la última ALM
+} store_state_t;
+
+// Seqlock de un único escritor (la tarea parser): seq impar mientras se escribe.
+// writer_state es la copia de trabajo del escritor, sin concurrencia.
+static atomic_uint store_seq;
+static store_state_t store_state;
+static store_state_t writer_state;
+
+// TP_FIELD_* pendientes de pasar a los subjects en el próximo refresco
+// (TP_FIELD_ERR = cambió el mapa de alarmas)
+static atomic_uint store_dirty;
+
+static lv_subject_t subjects[TELEMETRY_SUBJECT_COUNT];
+static bool subjects_primed = false;    // Ya se notificaron todos una vez (contexto de LVGL)
+// Contadores: los incrementan la tarea parser (publishes, alarm_frames), el
+// contexto de LVGL (refreshes) y cualquier lector del store (read_retries)
+static struct {
+    atomic_uint publishes;
+    atomic_uint refreshes;
+    atomic_uint read_retries;
+    atomic_uint alarm_frames;
+} stats;
+
+// Tendencias de T1, T2 y volumen (PSRAM); la escribe la tarea parser en cada trama
+static trend_t trend;
+static bool trend_ready = false;
+
+// Estado reconstruido a partir de keyframes y deltas (sólo lo toca la tarea parser)
+static data_stream_t data_stream;
+
+static void store_write(void) {
+    unsigned seq = atomic_load_explicit(&store_seq, memory_order_relaxed);
+    atomic_store_explicit(&store_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy((void *)&store_state, &writer_state, sizeof(store_state));
+    atomic_store_explicit(&store_seq, seq + 2, memory_order_release);
+}
+
+static bool store_read(store_state_t *out) {
+    unsigned seq;
+    for (;;) {
+        seq = atomic_load_explicit(&store_seq, memory_order_acquire);
+        if ((seq & 1) == 0) {
+            memcpy(out, (const void *)&store_state, sizeof(*out));
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&store_seq, memory_order_relaxed) == seq) {
+                break;
+            }
+        }
+        atomic_fetch_add_explicit(&stats.read_retries, 1, memory_order_relaxed);
+    }
+    return seq != 0;
+}
+
+bool telemetry_store_read(tp_data_t *out) {
+    store_state_t state;
+    bool valid = store_read(&state);
+    *out = state.data;
+    return valid;
+}
+
+bool telemetry_store_read_alarms(alarm_set_t *out) {
+    store_state_t state;
+    bool valid = store_read(&state);
+    *out = state.alarms;
+    return valid;
+}
+
+// Hook de ui_update (contexto de LVGL, una vez por refresco): vuelca en los
+// subjects los campos cambiados desde el refresco anterior
+static bool refresh_subjects(void) {
+    store_state_t state;
+
+    uint8_t dirty = (uint8_t)atomic_exchange(&store_dirty, 0);
+    if (dirty == 0 || !store_read(&state)) {
+        return false;
+    }
+
+    const int32_t values[TELEMETRY_SUBJECT_COUNT] = {
+        state.data.t1_centi, state.data.t2_centi, state.data.vol_ml, (int32_t)state.alarm_gen,
+    };
+    // En el primer refresco con datos se notifican todos, aunque el valor coincida
+    // con el 0 inicial del subject: si no, la etiqueta se quedaría en "--"
+    for (int i = 0; i < TELEMETRY_SUBJECT_COUNT; i++) {
+        if (!subjects_primed || ((dirty & (1u << i)) && lv_subject_get_int(&subjects[i]) != values[i])) {
+            lv_subject_set_int(&subjects[i], values[i]);
+        }
+    }
+    subjects_primed = true;
+    atomic_fetch_add_explicit(&stats.refreshes, 1, memory_order_relaxed);
+    return true;
+}
+
+// Sustituye el mapa de alarmas del escritor; true si cambió
+static bool update_alarms(const alarm_set_t *alarms) {
+    if (alarm_set_equal(&writer_state.alarms, alarms)) {
+        return false;
+    }
+    alarm_log_record_changes(&writer_state.alarms, alarms);
+    writer_state.alarms = *alarms;
+    writer_state.alarm_gen++;
+    return true;
+}
+
+// Sin llamadas a LVGL: el siguiente refresco del display recoge los cambios
+void telemetry_store_publish(const tp_data_t *data, uint8_t changed) {
+    alarm_set_t alarms = writer_state.alarms;
+
+    // ERR son las alarmas 0..7 del mapa
+    alarms.words[0] = (alarms.words[0] & ~0xFFu) | data->errors;
+    writer_state.data = *data;
+    if (trend_ready) {
+        const int32_t values[TREND_SERIES] = { data->t1_centi, data->t2_centi, data->vol_ml };
+        trend_push(&trend, (uint32_t)(esp_timer_get_time() / 1000000), values);
+    }
+    if (!update_alarms(&alarms)) {
+        changed &= (uint8_t)~TP_FIELD_ERR;
+    }
+    store_write();
+    atomic_fetch_add_explicit(&stats.publishes, 1, memory_order_relaxed);
+    if (changed != 0) {
+        atomic_fetch_or(&store_dirty, changed);
+    }
+}
+
+void telemetry_store_restore(const tp_data_t *data) {
+    // El ERR de la muestra sólo se muestra: el mapa de alarmas sigue vacío, que es
+    // contra lo que el registro de alarmas compara tras su marca de arranque
+    writer_state.data = *data;
+    store_write();
+    atomic_fetch_or(&store_dirty, TP_FIELD_ALL & ~TP_FIELD_ERR);
+}
+
+void telemetry_store_publish_alarms(const alarm_set_t *alarms) {
+    if (update_alarms(alarms)) {
+        // Mantener ERR coherente con los bits 0..7 del mapa, también en el flujo
+        // reconstruido: si no, la siguiente DATA o DLT reescribiría el ERR anterior
+        writer_state.data.errors = (uint8_t)alarms->words[0];
+        data_stream.data.errors = writer_state.data.errors;
+        store_write();
+        atomic_fetch_or(&store_dirty, TP_FIELD_ERR);
+    }
+    atomic_fetch_add_explicit(&stats.alarm_frames, 1, memory_order_relaxed);
+}
+
+// Aplica una keyframe o un delta y pide una keyframe si se perdió la secuencia
+static void apply_data_frame(const tp_delta_t *frame, size_t wire_len) {
+    uint8_t changed;
+    uint32_t expected = data_stream.next_seq;
+
+    switch (data_stream_apply(&data_stream, frame, wire_len, &changed)) {
+    case DATA_STREAM_APPLIED:
+        TRACE(DATA_APPLIED, frame->seq, frame->mask | frame->flags, changed);
+        TRACE(DATA_PARSED, data_stream.data.t1_centi, data_stream.data.t2_centi, data_stream.data.vol_ml);
+        telemetry_store_publish(&data_stream.data, changed);
+        break;
+    case DATA_STREAM_NEED_KEYFRAME:
+        TRACE(DATA_GAP, expected, frame->seq, data_stream.stats.gaps);
+        if (data_stream_request_due(&data_stream, (uint32_t)(esp_timer_get_time() / 1000))) {
+            uart_tx_send("GET_KEY*", UART_TX_FLAG_IDEMPOTENT);
+        }
+        break;
+    case DATA_STREAM_IGNORED:
+        break;
+    }
+}
+
+// Trama binaria TP_MSG_DATA: keyframe sin secuencia (controladores sin deltas)
+static void bin_data_handler(const tp_msg_t *msg) {
+    tp_delta_t frame = {
+        .mask = TP_FIELD_ALL,
+        .flags = TP_DELTA_KEYFRAME | TP_DELTA_NO_SEQ,
+        .data = msg->data,
+    };
+    apply_data_frame(&frame, tp_encoded_len(TP_MSG_DATA, &frame));
+}
+
+// Trama binaria TP_MSG_DELTA: keyframe o delta con secuencia
+static void bin_delta_handler(const tp_msg_t *msg) {
+    apply_data_frame(&msg->delta, tp_encoded_len(TP_MSG_DELTA, &msg->delta));
+}
+
+static void publish_alarm_words(const tp_alarms_t *msg) {
+    alarm_set_t alarms;
+    alarm_set_clear(&alarms);
+    for (int i = 0; i < msg->count && i < ALARM_WORDS; i++) {
+        alarms.words[i] = msg->words[i];
+    }
+    telemetry_store_publish_alarms(&alarms);
+}
+
+// Trama binaria TP_MSG_ALARMS: mapa de alarmas completo
+static void bin_alarms_handler(const tp_msg_t *msg) {
+    publish_alarm_words(&msg->alarms);
+}
+
+// Sólo recibe tramas con prefijo "DATA" (registrado en uart_register_handler)
+static void data_handler(const char *data) {
+    tp_delta_t frame;
+    size_t offset;
+    data_parse_result_t res = data_parse_keyframe(data, &frame, &offset);
+    if (res == DATA_PARSE_OK) {
+        apply_data_frame(&frame, strlen(data) + 1);
+    } else {
+        TRACE(DATA_BAD, res, offset, 0);
+    }
+}
+
+// Tramas "DLT": sólo los campos que cambiaron desde la anterior
+static void delta_handler(const char *data) {
+    tp_delta_t frame;
+    size_t offset;
+    data_parse_result_t res = data_parse_delta(data, &frame, &offset);
+    if (res == DATA_PARSE_OK) {
+        apply_data_frame(&frame, strlen(data) + 1);
+    } else {
+        TRACE(DATA_BAD, res, offset, 0);
+    }
+}
+
+// Tramas "ALM": mapa de alarmas completo en hexadecimal
+static void alarms_handler(const char *data) {
+    tp_alarms_t msg;
+    size_t offset;
+    data_parse_result_t res = data_parse_alarms(data, &msg, &offset);
+    if (res == DATA_PARSE_OK) {
+        publish_alarm_words(&msg);
+    } else {
+        TRACE(DATA_BAD, res, offset, 0);
+    }
+}
+
+void telemetry_store_init(void) {
+    static const trend_level_cfg_t trend_cfg[TREND_LEVELS] = TREND_LEVELS_CFG;
+    void *trend_storage = heap_caps_malloc(trend_storage_size(trend_cfg), MALLOC_CAP_SPIRAM);
+    trend_ready = trend_init(&trend, trend_cfg, trend_storage);
+    if (!trend_ready) {
+        ESP_LOGE("TELEMETRY", "No se pudo reservar el histórico de tendencias");
+        heap_caps_free(trend_storage);
+    }
+
+    for (int i = 0; i < TELEMETRY_SUBJECT_COUNT; i++) {
+        lv_subject_init_int(&subjects[i], 0);
+    }
+    ui_update_register(refresh_subjects);
+    data_stream_init(&data_stream, DATA_KEYFRAME_RETRY_MS);
+    uart_register_handler("DATA", data_handler);
+    uart_register_handler("DLT", delta_handler);
+    uart_register_bin_handler(TP_MSG_DATA, bin_data_handler);
+    uart_register_bin_handler(TP_MSG_DELTA, bin_delta_handler);
+    uart_register_handler("ALM", alarms_handler);
+    uart_register_bin_handler(TP_MSG_ALARMS, bin_alarms_handler);
+}
+
+const trend_t *telemetry_store_trend(void) {
+    return trend_ready ? &trend : NULL;
+}
+
+bool telemetry_store_has_data(void) {
+    return atomic_load_explicit(&store_seq, memory_order_relaxed) != 0;
+}
+
+lv_subject_t *telemetry_store_subject(telemetry_subject_t subject) {
+    return subject < TELEMETRY_SUBJECT_COUNT ? &subjects[subject] : NULL;
+}
+
+void telemetry_store_get_stats(telemetry_store_stats_t *out) {
+    if (out != NULL) {
+        out->publishes = atomic_load_explicit(&stats.publishes, memory_order_relaxed);
+        out->refreshes = atomic_load_explicit(&stats.refreshes, memory_order_relaxed);
+        out->read_retries = atomic_load_explicit(&stats.read_retries, memory_order_relaxed);
+        out->alarm_frames = atomic_load_explicit(&stats.alarm_frames, memory_order_relaxed);
+    }
+}
+
+void telemetry_store_get_stream_stats(data_stream_stats_t *out) {
+    if (out != NULL) {
+        *out = data_stream.stats;
+    }
+}
@@ -0,0 +1,66 @@
+// telemetry_store.h
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lvgl.h"
+#include "telemetry_proto.h"
+#include "data_stream.h"
+#include "alarms.h"
+#include "trend_buffer.h"
+
+// Estado central de la telemetría. La capa de protocolo (tarea parser) lo
+// escribe bajo un seqlock; la UI lo recibe a través de subjects de LVGL, que
+// se actualizan una vez por refresco del display (ui_update) con los campos
+// acumulados, por muchas tramas que lleguen entre refrescos.
+
+typedef enum {
+    TELEMETRY_SUBJECT_T1,       // Centésimas de °C
+    TELEMETRY_SUBJECT_T2,       // Centésimas de °C
+    TELEMETRY_SUBJECT_VOL,      // ml
+    TELEMETRY_SUBJECT_ALARMS,   // Generación del mapa de alarmas (telemetry_store_read_alarms)
+    TELEMETRY_SUBJECT_COUNT,    // Mismo orden que los bits TP_FIELD_*
+} telemetry_subject_t;
+
+typedef struct {
+    uint32_t publishes;         // Escrituras del estado
+    uint32_t refreshes;         // Actualizaciones de subjects ejecutadas
+    uint32_t read_retries;      // Lecturas repetidas por coincidir con una escritura
+    uint32_t alarm_frames;      // Tramas ALM recibidas
+} telemetry_store_stats_t;
+
+// Inicializa los subjects y registra los manejadores DATA/DLT (antes de enlazar widgets, tras ui_update_init)
+void telemetry_store_init(void);
+
+// Publica el estado completo; changed = TP_FIELD_* que cambiaron
+void telemetry_store_publish(const tp_data_t *data, uint8_t changed);
+
+// Estado conocido antes de recibir tramas (la última muestra del datalog): se
+// muestra enseguida, pero no cuenta como publicación ni toca el mapa de alarmas
+// (su ERR puede ser de hace días). Sólo antes de crear la tarea parser.
+void telemetry_store_restore(const tp_data_t *data);
+
+// Mapa de alarmas completo (ALM); ERR de DATA sólo actualiza los bits 0..7
+void telemetry_store_publish_alarms(const alarm_set_t *alarms);
+
+// Copia coherente del último estado desde cualquier tarea. false si aún no hay datos.
+bool telemetry_store_read(tp_data_t *out);
+
+bool telemetry_store_read_alarms(alarm_set_t *out);
+
+// Ya se ha publicado al menos un estado (los subjects parten de 0)
+bool telemetry_store_has_data(void);
+
+// Tendencias (T1, T2, VOL) alimentadas con cada trama; NULL si no hay memoria
+const trend_t *telemetry_store_trend(void);
+
+// Subject enlazable a widgets con lv_subject_add_observer_obj()
+lv_subject_t *telemetry_store_subject(telemetry_subject_t subject);
+
+void telemetry_store_get_stats(telemetry_store_stats_t *out);
+
+// Contadores de keyframes/deltas: huecos, peticiones de keyframe y bytes ahorrados
+void telemetry_store_get_stream_stats(data_stream_stats_t *out);
+
+#endif // TELEMETRY_STORE_H
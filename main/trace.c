@@ -0,0 +1,139 @@
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#if (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) != 0
+#error "TRACE_RING_SIZE debe ser potencia de 2"
+#endif
+
+// Un ring por núcleo: las tareas de un núcleo sólo compiten entre sí (por
+// expropiación), y el fetch_add del índice basta para reservar el hueco
+typedef struct {
+    atomic_uint head;
+    trace_record_t records[TRACE_RING_SIZE];
+} trace_ring_t;
+
+static trace_ring_t trace_rings[portNUM_PROCESSORS];
+
+#define TRACE_EVENT(name, level, fmt) fmt,
+static const char *const trace_formats[TRACE_EV_MAX] = {
+#include "trace_events.h"
+};
+#undef TRACE_EVENT
+
+#define TRACE_EVENT(name, level, fmt) #name,
+static const char *const trace_names[TRACE_EV_MAX] = {
+#include "trace_events.h"
+};
+#undef TRACE_EVENT
+
+void trace_record(trace_event_t id, int32_t a0, int32_t a1, int32_t a2) {
+    uint32_t core = xPortGetCoreID();
+    trace_ring_t *ring = &trace_rings[core];
+    uint32_t index = atomic_fetch_add_explicit(&ring->head, 1, memory_order_relaxed);
+    trace_record_t *rec = &ring->records[index & (TRACE_RING_SIZE - 1)];
+
+    // seq a 0 mientras se escribe: el volcado descarta registros incompletos
+    atomic_store_explicit((_Atomic uint32_t *)&rec->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    rec->ts_us = (uint32_t)esp_timer_get_time();
+    rec->id = (uint16_t)id;
+    rec->core = (uint16_t)core;
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    atomic_store_explicit((_Atomic uint32_t *)&rec->seq, index + 1, memory_order_release);
+}
+
+// Copia un registro estable: seq distinto de 0 e igual antes y después de copiarlo
+static bool snapshot_record(const trace_record_t *rec, trace_record_t *out) {
+    uint32_t seq = atomic_load_explicit((_Atomic uint32_t *)&rec->seq, memory_order_acquire);
+    if (seq == 0) {
+        return false;
+    }
+    memcpy(out, rec, sizeof(*out));
+    atomic_thread_fence(memory_order_acquire);
+    return out->seq == seq &&
+           atomic_load_explicit((_Atomic uint32_t *)&rec->seq, memory_order_relaxed) == seq;
+}
+
+static void print_record(const trace_record_t *rec, bool raw) {
+    if (raw) {
+        // Mismo orden de campos que trace_record_t; lo lee tools/trace_decode.py
+        printf("TR %08lx %08lx %04x %04x %08lx %08lx %08lx\n",
+               (unsigned long)rec->seq, (unsigned long)rec->ts_us, rec->id, rec->core,
+               (unsigned long)(uint32_t)rec->args[0], (unsigned long)(uint32_t)rec->args[1], (unsigned long)(uint32_t)rec->args[2]);
+        return;
+    }
+    if (rec->id >= TRACE_EV_MAX) {
+        return;
+    }
+    printf("%10lu c%u %-14s ", (unsigned long)rec->ts_us, rec->core, trace_names[rec->id]);
+    printf(trace_formats[rec->id], (long)rec->args[0], (long)rec->args[1], (long)rec->args[2]);
+    printf("\n");
+}
+
+void trace_dump(bool raw) {
+    // Cursor por ring: se fusionan por marca de tiempo sin copiar los rings enteros
+    uint32_t next[portNUM_PROCESSORS];
+    uint32_t end[portNUM_PROCESSORS];
+
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        end[c] = atomic_load_explicit(&trace_rings[c].head, memory_order_acquire);
+        next[c] = end[c] > TRACE_RING_SIZE ? end[c] - TRACE_RING_SIZE : 0;
+    }
+
+    printf("TRACE begin level=%d ring=%d\n", TRACE_LEVEL, TRACE_RING_SIZE);
+    while (true) {
+        int best = -1;
+        trace_record_t best_rec;
+        for (int c = 0; c < portNUM_PROCESSORS; c++) {
+            trace_record_t rec;
+            // Saltar huecos sobrescritos o a medio escribir
+            while (next[c] < end[c]) {
+                const trace_record_t *slot = &trace_rings[c].records[next[c] & (TRACE_RING_SIZE - 1)];
+                if (snapshot_record(slot, &rec) && rec.seq == next[c] + 1) {
+                    break;
+                }
+                next[c]++;
+            }
+            if (next[c] < end[c] && (best < 0 || (int32_t)(rec.ts_us - best_rec.ts_us) < 0)) {
+                best = c;
+                best_rec = rec;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        print_record(&best_rec, raw);
+        next[best]++;
+    }
+    printf("TRACE end\n");
+}
+
+void trace_clear(void) {
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        for (int i = 0; i < TRACE_RING_SIZE; i++) {
+            atomic_store_explicit((_Atomic uint32_t *)&trace_rings[c].records[i].seq, 0, memory_order_relaxed);
+        }
+    }
+}
+
+void trace_command_handler(const char *data) {
+    const char *arg = strchr(data, ':');
+    if (arg == NULL) {
+        return;
+    }
+    arg++;
+    if (strncmp(arg, "DUMP", 4) == 0) {
+        trace_dump(false);
+    } else if (strncmp(arg, "RAW", 3) == 0) {
+        trace_dump(true);
+    } else if (strncmp(arg, "CLEAR", 5) == 0) {
+        trace_clear();
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart_config.h"
+
+// Trazas binarias de bajo coste para el camino caliente (RX, parser, TX, handlers).
+// Cada evento guarda id, marca de tiempo y tres enteros en un ring por núcleo, sin
+// formatear ni bloquear; el texto se genera sólo al volcar (trace_dump o comando
+// "TRACE:DUMP") o en el PC con tools/trace_decode.py a partir del volcado "TRACE:RAW".
+
+#define TRACE_LEVEL_NONE 0
+#define TRACE_LEVEL_ERROR 1
+#define TRACE_LEVEL_WARN 2
+#define TRACE_LEVEL_INFO 3
+#define TRACE_LEVEL_DEBUG 4
+#define TRACE_LEVEL_VERBOSE 5
+
+#define TRACE_EVENT(name, level, fmt) TRACE_EV_##name,
+typedef enum {
+#include "trace_events.h"
+    TRACE_EV_MAX
+} trace_event_t;
+#undef TRACE_EVENT
+
+// Nivel de cada evento como constante: TRACE() se elimina entero al compilar
+// si el evento está por encima de TRACE_LEVEL
+#define TRACE_EVENT(name, level, fmt) TRACE_LVL_##name = level,
+enum {
+#include "trace_events.h"
+};
+#undef TRACE_EVENT
+
+typedef struct {
+    uint32_t seq;       // Índice de escritura + 1; 0 = registro vacío o a medio escribir
+    uint32_t ts_us;     // esp_timer_get_time() truncado (vuelta cada ~71 min)
+    uint16_t id;        // trace_event_t
+    uint16_t core;
+    int32_t args[3];
+} trace_record_t;
+
+void trace_record(trace_event_t id, int32_t a0, int32_t a1, int32_t a2);
+
+#define TRACE(name, a0, a1, a2)                                                        \
+    do {                                                                               \
+        if (TRACE_LVL_##name <= TRACE_LEVEL) {                                         \
+            trace_record(TRACE_EV_##name, (int32_t)(a0), (int32_t)(a1), (int32_t)(a2)); \
+        }                                                                              \
+    } while (0)
+
+// Vuelca los rings por la consola ordenados por tiempo: texto o registros en hex
+void trace_dump(bool raw);
+void trace_clear(void);
+
+// Handler para el prefijo "TRACE": TRACE:DUMP, TRACE:RAW, TRACE:CLEAR
+void trace_command_handler(const char *data);
+
+#endif // TRACE_H
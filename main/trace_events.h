@@ -0,0 +1,26 @@
+// Tabla de eventos de traza: TRACE_EVENT(nombre, nivel, formato)
+// El formato recibe siempre los tres argumentos de trace_record_t como long, aunque
+// no los use todos. Lo usan trace_dump() y tools/trace_decode.py, nunca el camino caliente.
+// Añadir eventos sólo al final: el id es la posición en la tabla.
+
+TRACE_EVENT(RX_DRAIN,       TRACE_LEVEL_VERBOSE, "rx drain bytes=%ld buffered=%ld")
+TRACE_EVENT(RX_FRAME,       TRACE_LEVEL_DEBUG,   "rx frame len=%ld telemetry=%ld binary=%ld")
+TRACE_EVENT(RX_QUEUE_STALL, TRACE_LEVEL_WARN,    "rx control queue stall stalls=%ld")
+TRACE_EVENT(RX_DECODE_ERR,  TRACE_LEVEL_WARN,    "rx binary frame rejected result=%ld len=%ld")
+TRACE_EVENT(DISPATCH,       TRACE_LEVEL_DEBUG,   "dispatch prefix_len=%ld latency_us=%ld handled=%ld")
+TRACE_EVENT(DISPATCH_BIN,   TRACE_LEVEL_DEBUG,   "dispatch binary type=%ld latency_us=%ld handled=%ld")
+TRACE_EVENT(TX_SEND,        TRACE_LEVEL_DEBUG,   "tx send seq=%ld attempt=%ld len=%ld")
+TRACE_EVENT(TX_ACK,         TRACE_LEVEL_DEBUG,   "tx ack seq=%ld latency_us=%ld")
+TRACE_EVENT(TX_NAK,         TRACE_LEVEL_INFO,    "tx nak seq=%ld attempt=%ld")
+TRACE_EVENT(TX_FAILED,      TRACE_LEVEL_WARN,    "tx failed seq=%ld attempts=%ld")
+TRACE_EVENT(DATA_PARSED,    TRACE_LEVEL_DEBUG,   "data t1_centi=%ld t2_centi=%ld vol=%ld")
+TRACE_EVENT(DATA_BAD,       TRACE_LEVEL_WARN,    "data malformed field=%ld offset=%ld")
+TRACE_EVENT(SETTINGS_PARAM, TRACE_LEVEL_DEBUG,   "settings param P%ld=%ld")
+TRACE_EVENT(SETTINGS_CHK,   TRACE_LEVEL_DEBUG,   "settings chk=%ld")
+TRACE_EVENT(DATA_GAP,       TRACE_LEVEL_INFO,    "data gap expected=%ld got=%ld gaps=%ld")
+TRACE_EVENT(UI_STATS,       TRACE_LEVEL_INFO,    "ui per second updates=%ld skipped=%ld skipped_px=%ld")
+TRACE_EVENT(ALARM_EDGE,     TRACE_LEVEL_DEBUG,   "alarm edge bit=%ld edge=%ld seq=%ld")
+TRACE_EVENT(ALARM_LOG_ERR,  TRACE_LEVEL_WARN,    "alarm log flash write failed seq=%ld io_errors=%ld")
+TRACE_EVENT(DATALOG_ERR,    TRACE_LEVEL_WARN,    "datalog flash error io_errors=%ld blocks=%ld")
+TRACE_EVENT(SETTINGS_SAVE,  TRACE_LEVEL_INFO,    "settings saved count=%ld writes=%ld changes=%ld")
+TRACE_EVENT(DATA_APPLIED,   TRACE_LEVEL_DEBUG,   "data applied seq=%ld fields=0x%lx changed=0x%lx")
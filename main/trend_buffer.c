@@ -0,0 +1,148 @@
+// trend_buffer.c
+#include "trend_buffer.h"
+
+static const trend_point_t empty_point = { INT32_MAX, INT32_MIN };
+
+size_t trend_storage_size(const trend_level_cfg_t cfg[TREND_LEVELS]) {
+    size_t size = 0;
+    for (int l = 0; l < TREND_LEVELS; l++) {
+        size += (size_t)cfg[l].depth * TREND_SERIES * sizeof(trend_point_t);
+    }
+    return size;
+}
+
+bool trend_init(trend_t *t, const trend_level_cfg_t cfg[TREND_LEVELS], void *storage) {
+    trend_point_t *points = storage;
+
+    if (storage == NULL) {
+        return false;
+    }
+    for (int l = 0; l < TREND_LEVELS; l++) {
+        trend_level_t *level = &t->levels[l];
+        if (cfg[l].period_s == 0 || cfg[l].depth == 0) {
+            return false;
+        }
+        level->cfg = cfg[l];
+        level->points = points;
+        for (uint32_t i = 0; i < cfg[l].depth * TREND_SERIES; i++) {
+            points[i] = empty_point;
+        }
+        points += cfg[l].depth * TREND_SERIES;
+        atomic_init(&level->end, 0);
+        level->acc_valid = false;
+    }
+    return true;
+}
+
+static trend_point_t *bucket_points(const trend_level_t *level, uint32_t bucket) {
+    return &level->points[(bucket % level->cfg.depth) * TREND_SERIES];
+}
+
+// Cierra el intervalo acumulado y deja vacíos los que no tuvieron muestras
+static void close_bucket(trend_level_t *level, uint32_t next_bucket) {
+    trend_point_t *dst = bucket_points(level, level->acc_bucket);
+    for (int s = 0; s < TREND_SERIES; s++) {
+        dst[s] = level->acc[s];
+    }
+    uint32_t gap = next_bucket - level->acc_bucket - 1;
+    if (gap > level->cfg.depth) {
+        gap = level->cfg.depth;
+    }
+    for (uint32_t i = 1; i <= gap; i++) {
+        dst = bucket_points(level, next_bucket - i);
+        for (int s = 0; s < TREND_SERIES; s++) {
+            dst[s] = empty_point;
+        }
+    }
+    atomic_store_explicit(&level->end, next_bucket, memory_order_release);
+}
+
+void trend_push(trend_t *t, uint32_t now_s, const int32_t values[TREND_SERIES]) {
+    for (int l = 0; l < TREND_LEVELS; l++) {
+        trend_level_t *level = &t->levels[l];
+        uint32_t bucket = now_s / level->cfg.period_s;
+
+        if (level->acc_valid && bucket == level->acc_bucket) {
+            for (int s = 0; s < TREND_SERIES; s++) {
+                if (values[s] < level->acc[s].min) {
+                    level->acc[s].min = values[s];
+                }
+                if (values[s] > level->acc[s].max) {
+                    level->acc[s].max = values[s];
+                }
+            }
+            continue;
+        }
+        if (level->acc_valid && bucket > level->acc_bucket) {
+            close_bucket(level, bucket);
+        }
+        level->acc_bucket = bucket;
+        level->acc_valid = true;
+        for (int s = 0; s < TREND_SERIES; s++) {
+            level->acc[s].min = values[s];
+            level->acc[s].max = values[s];
+        }
+    }
+}
+
+uint32_t trend_end_s(const trend_t *t) {
+    const trend_level_t *level = &t->levels[0];
+    return atomic_load_explicit(&((trend_level_t *)level)->end, memory_order_acquire) * level->cfg.period_s;
+}
+
+// Nivel más grueso con al menos un intervalo por columna cuya historia llega a t_start
+static int pick_level(const trend_t *t, uint32_t t_start, uint32_t window_s, uint32_t columns) {
+    int covering = TREND_LEVELS - 1;
+    for (int l = TREND_LEVELS - 1; l >= 0; l--) {
+        const trend_level_cfg_t *cfg = &t->levels[l].cfg;
+        uint32_t end = atomic_load_explicit(&((trend_level_t *)&t->levels[l])->end, memory_order_acquire);
+        uint32_t first = end > cfg->depth ? end - cfg->depth : 0;
+        bool covers = first * cfg->period_s <= t_start;
+        if (covers) {
+            covering = l;
+            if ((uint64_t)cfg->period_s * columns <= window_s) {
+                return l;
+            }
+        }
+    }
+    return covering;
+}
+
+int trend_query(const trend_t *t, uint32_t t_end_s, uint32_t window_s, trend_point_t *out, uint32_t columns) {
+    uint32_t t_start = t_end_s > window_s ? t_end_s - window_s : 0;
+    int l = pick_level(t, t_start, window_s, columns);
+    const trend_level_t *level = &t->levels[l];
+    uint32_t period = level->cfg.period_s;
+    uint32_t end = atomic_load_explicit(&((trend_level_t *)level)->end, memory_order_acquire);
+    uint32_t first = end > level->cfg.depth ? end - level->cfg.depth : 0;
+
+    for (uint32_t c = 0; c < columns; c++) {
+        uint32_t b0 = (uint32_t)((t_start + (uint64_t)window_s * c / columns) / period);
+        uint32_t b1 = (uint32_t)((t_start + (uint64_t)window_s * (c + 1) / columns) / period);
+        if (b1 <= b0) {
+            b1 = b0 + 1;    // Ventana corta: varias columnas muestran el mismo intervalo
+        }
+        trend_point_t *col = &out[c * TREND_SERIES];
+        for (int s = 0; s < TREND_SERIES; s++) {
+            col[s] = empty_point;
+        }
+        if (b0 < first) {
+            b0 = first;
+        }
+        if (b1 > end) {
+            b1 = end;
+        }
+        for (uint32_t b = b0; b < b1; b++) {
+            const trend_point_t *src = bucket_points(level, b);
+            for (int s = 0; s < TREND_SERIES; s++) {
+                if (src[s].min < col[s].min) {
+                    col[s].min = src[s].min;
+                }
+                if (src[s].max > col[s].max) {
+                    col[s].max = src[s].max;
+                }
+            }
+        }
+    }
+    return l;
+}
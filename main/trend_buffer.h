@@ -0,0 +1,67 @@
+// trend_buffer.h
+#ifndef TREND_BUFFER_H
+#define TREND_BUFFER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+// Históricos de tendencia a varias resoluciones. Cada nivel agrupa las
+// muestras en intervalos de period_s segundos y guarda sólo el mínimo y el
+// máximo de cada serie, en un ring de depth intervalos. Todos los niveles se
+// alimentan de las mismas muestras, así que el mín/máx de un intervalo grueso
+// es exacto. Un intervalo sin muestras queda vacío (hueco en la gráfica).
+//
+// Un escritor (tarea parser) y lectores sin bloqueo (LVGL): sólo se leen
+// intervalos cerrados, que no cambian hasta que el ring da la vuelta.
+// Sin dependencias de ESP-IDF: el llamador aporta la memoria (PSRAM en el firmware).
+
+#define TREND_SERIES 3      // T1, T2 (centésimas de °C) y volumen (ml)
+#define TREND_LEVELS 3
+
+typedef struct {
+    int32_t min;
+    int32_t max;            // min > max: sin datos
+} trend_point_t;
+
+typedef struct {
+    uint32_t period_s;
+    uint32_t depth;
+} trend_level_cfg_t;
+
+typedef struct {
+    trend_level_cfg_t cfg;
+    trend_point_t *points;          // depth * TREND_SERIES, por intervalo
+    atomic_uint end;                // Intervalos cerrados: [end - depth, end)
+    uint32_t acc_bucket;            // Intervalo que se está acumulando
+    bool acc_valid;
+    trend_point_t acc[TREND_SERIES];
+} trend_level_t;
+
+typedef struct {
+    trend_level_t levels[TREND_LEVELS];  // De más fino a más grueso
+} trend_t;
+
+// Bytes de memoria que necesita trend_init para cfg
+size_t trend_storage_size(const trend_level_cfg_t cfg[TREND_LEVELS]);
+
+bool trend_init(trend_t *t, const trend_level_cfg_t cfg[TREND_LEVELS], void *storage);
+
+// Escritor: una muestra de cada serie en el instante now_s
+void trend_push(trend_t *t, uint32_t now_s, const int32_t values[TREND_SERIES]);
+
+// Fin (exclusivo, en segundos) de los datos cerrados del nivel más fino
+uint32_t trend_end_s(const trend_t *t);
+
+// Reduce [t_end_s - window_s, t_end_s) a `columns` columnas de mín/máx por serie
+// (out[columna * TREND_SERIES + serie]) usando el nivel más grueso que aún da un
+// intervalo por columna y cubre el rango. Devuelve el nivel usado. El coste
+// depende de las columnas, no de la longitud de la ventana.
+int trend_query(const trend_t *t, uint32_t t_end_s, uint32_t window_s, trend_point_t *out, uint32_t columns);
+
+static inline bool trend_point_valid(const trend_point_t *p) {
+    return p->min <= p->max;
+}
+
+#endif // TREND_BUFFER_H
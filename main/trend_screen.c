@@ -0,0 +1,314 @@
+#include "trend_screen.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "uart_config.h"
+#include "telemetry_store.h"
+#include "trend_buffer.h"
+#include "ui_update.h"
+#include "ui_format.h"
+
+// Cada gráfica es un canvas RGB565 en PSRAM con una columna por píxel: el
+// histórico se reduce a TREND_PLOT_W columnas de mín/máx (trend_query) y se
+// pintan como trazos verticales, así que el coste de dibujar no depende de la
+// ventana. Sólo se repinta cuando se cierra un intervalo nuevo o al desplazar.
+#define TREND_PLOT_W 720
+#define TREND_TEMP_H 140
+#define TREND_VOL_H 110
+#define TREND_PLOT_X 70
+
+#define SERIES_T1 0
+#define SERIES_T2 1
+#define SERIES_VOL 2
+
+typedef struct {
+    lv_obj_t *canvas;
+    lv_draw_buf_t buf;
+    lv_obj_t *label_max;
+    lv_obj_t *label_min;
+    uint8_t first_series;
+    uint8_t series_count;
+    unsigned decimals;          // Para las etiquetas de escala
+} trend_plot_t;
+
+static const uint32_t windows_s[] = { 60, 600, 3600, 6 * 3600, 24 * 3600 };
+static const char *const window_map[] = { "1 min", "10 min", "1 h", "6 h", "24 h", "" };
+static const uint32_t series_colors[TREND_SERIES] = { 0xFF8C00, 0x1E88E5, 0x2E7D32 };
+
+static lv_obj_t *trend_screen;
+static lv_obj_t *status_label;
+static trend_plot_t plot_temp;
+static trend_plot_t plot_vol;
+static trend_point_t *columns;  // TREND_PLOT_W * TREND_SERIES
+
+static uint32_t window_s = 600;
+static bool live = true;        // Seguir el final de los datos
+static uint32_t view_end_s;     // Fin de la ventana si no está en vivo
+static int32_t drag_px;         // Arrastre pendiente de convertir a segundos
+static bool view_dirty = true;
+static uint32_t rendered_end_s;
+
+static bool plot_init(trend_plot_t *plot, lv_obj_t *scr, int32_t y, int32_t h, uint8_t first, uint8_t count,
+                      unsigned decimals) {
+    uint32_t stride = LV_DRAW_BUF_STRIDE(TREND_PLOT_W, LV_COLOR_FORMAT_RGB565);
+    uint32_t size = LV_DRAW_BUF_SIZE(TREND_PLOT_W, h, LV_COLOR_FORMAT_RGB565);
+    void *data = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (data == NULL) {
+        return false;
+    }
+    memset(data, 0xFF, size); // Blanco
+    lv_draw_buf_init(&plot->buf, TREND_PLOT_W, h, LV_COLOR_FORMAT_RGB565, stride, data, size);
+
+    plot->canvas = lv_canvas_create(scr);
+    lv_canvas_set_draw_buf(plot->canvas, &plot->buf);
+    lv_obj_set_pos(plot->canvas, TREND_PLOT_X, y);
+    lv_obj_add_flag(plot->canvas, LV_OBJ_FLAG_CLICKABLE);
+
+    plot->label_max = lv_label_create(scr);
+    lv_label_set_text(plot->label_max, "");
+    lv_obj_set_pos(plot->label_max, 4, y);
+    plot->label_min = lv_label_create(scr);
+    lv_label_set_text(plot->label_min, "");
+    lv_obj_set_pos(plot->label_min, 4, y + h - 16);
+
+    plot->first_series = first;
+    plot->series_count = count;
+    plot->decimals = decimals;
+    return true;
+}
+
+static void fill_span(trend_plot_t *plot, int32_t x, int32_t y1, int32_t y2, uint16_t color) {
+    uint32_t stride = plot->buf.header.stride;
+    uint8_t *base = plot->buf.data + x * 2;
+    for (int32_t y = y1; y <= y2; y++) {
+        *(uint16_t *)(base + (uint32_t)y * stride) = color;
+    }
+}
+
+static void plot_render(trend_plot_t *plot) {
+    int32_t h = plot->buf.header.h;
+    int32_t lo = INT32_MAX;
+    int32_t hi = INT32_MIN;
+    char text[24];
+
+    // Escala vertical: mín/máx de las columnas visibles de las series de la gráfica
+    for (int c = 0; c < TREND_PLOT_W; c++) {
+        for (int s = plot->first_series; s < plot->first_series + plot->series_count; s++) {
+            const trend_point_t *p = &columns[c * TREND_SERIES + s];
+            if (trend_point_valid(p)) {
+                lo = p->min < lo ? p->min : lo;
+                hi = p->max > hi ? p->max : hi;
+            }
+        }
+    }
+
+    memset(plot->buf.data, 0xFF, plot->buf.data_size);
+    uint16_t grid = lv_color_to_u16(lv_color_hex(0xE0E0E0));
+    for (int i = 1; i < 4; i++) {
+        uint16_t *row = (uint16_t *)(plot->buf.data + (uint32_t)(h * i / 4) * plot->buf.header.stride);
+        for (int x = 0; x < TREND_PLOT_W; x++) {
+            row[x] = grid;
+        }
+    }
+
+    if (lo > hi) {
+        ui_label_set_text_if_changed(plot->label_max, "");
+        ui_label_set_text_if_changed(plot->label_min, "");
+        lv_obj_invalidate(plot->canvas);
+        return;
+    }
+    int64_t span = (int64_t)hi - lo;
+    int64_t margin = span / 20 + 1;
+    int64_t top = hi + margin;
+    int64_t range = span + 2 * margin;
+
+    for (int s = plot->first_series; s < plot->first_series + plot->series_count; s++) {
+        uint16_t color = lv_color_to_u16(lv_color_hex(series_colors[s]));
+        int32_t prev_y1 = -1;
+        int32_t prev_y2 = -1;
+        for (int c = 0; c < TREND_PLOT_W; c++) {
+            const trend_point_t *p = &columns[c * TREND_SERIES + s];
+            if (!trend_point_valid(p)) {
+                prev_y1 = -1;
+                continue;
+            }
+            int32_t y1 = (int32_t)((top - p->max) * (h - 1) / range);
+            int32_t y2 = (int32_t)((top - p->min) * (h - 1) / range);
+            // Unir con la columna anterior para que los flancos no dejen huecos
+            if (prev_y1 >= 0) {
+                if (y1 > prev_y2) {
+                    y1 = prev_y2;
+                }
+                if (y2 < prev_y1) {
+                    y2 = prev_y1;
+                }
+            }
+            fill_span(plot, c, y1, y2, color);
+            prev_y1 = (int32_t)((top - p->max) * (h - 1) / range);
+            prev_y2 = (int32_t)((top - p->min) * (h - 1) / range);
+        }
+    }
+
+    ui_fmt_label(text, sizeof(text), NULL, (int32_t)(top - margin), plot->decimals, NULL);
+    ui_label_set_text_if_changed(plot->label_max, text);
+    ui_fmt_label(text, sizeof(text), NULL, (int32_t)(top - margin - span), plot->decimals, NULL);
+    ui_label_set_text_if_changed(plot->label_min, text);
+    lv_obj_invalidate(plot->canvas);
+}
+
+static void update_status(uint32_t end_s, int level) {
+    char text[64];
+    size_t len;
+    if (live) {
+        strcpy(text, "En vivo  |  ");
+        len = strlen(text);
+    } else {
+        // Minutos por detrás del final de los datos
+        len = ui_fmt_label(text, sizeof(text), "Desplazado -", (int32_t)((end_s - view_end_s) / 60), 0, " min  |  ");
+    }
+    ui_fmt_label(text + len, sizeof(text) - len, "nivel ", level, 0, NULL);
+    ui_label_set_text_if_changed(status_label, text);
+}
+
+// Hook de ui_update: recalcula y repinta como mucho una vez por refresco
+static bool trend_refresh_hook(void) {
+    const trend_t *trend = telemetry_store_trend();
+    if (trend == NULL || columns == NULL || lv_screen_active() != trend_screen) {
+        return false;
+    }
+    uint32_t end_s = trend_end_s(trend);
+    if (live && end_s != rendered_end_s) {
+        view_dirty = true;
+    }
+
+    // Arrastre acumulado -> segundos; hacia la derecha se ve el pasado
+    int64_t shift_s = -(int64_t)drag_px * window_s / TREND_PLOT_W;
+    if (shift_s != 0) {
+        int64_t target = (int64_t)(live ? end_s : view_end_s) + shift_s;
+        drag_px = 0;
+        if (target >= end_s) {
+            live = true;
+        } else {
+            live = false;
+            view_end_s = target > window_s ? (uint32_t)target : window_s;
+        }
+        view_dirty = true;
+    }
+    if (!view_dirty) {
+        return false;
+    }
+
+    uint32_t t_end = live ? end_s : view_end_s;
+    int level = trend_query(trend, t_end, window_s, columns, TREND_PLOT_W);
+    plot_render(&plot_temp);
+    plot_render(&plot_vol);
+    update_status(end_s, level);
+    rendered_end_s = end_s;
+    view_dirty = false;
+    return true;
+}
+
+static void plot_drag_cb(lv_event_t *e) {
+    lv_point_t vect;
+    lv_indev_get_vect(lv_indev_active(), &vect);
+    drag_px += vect.x;  // Se aplica en el próximo refresco
+}
+
+static void window_changed_cb(lv_event_t *e) {
+    uint32_t index = lv_buttonmatrix_get_selected_button(lv_event_get_target(e));
+    if (index < sizeof(windows_s) / sizeof(windows_s[0])) {
+        window_s = windows_s[index];
+        view_dirty = true;
+    }
+}
+
+static void live_cb(lv_event_t *e) {
+    live = true;
+    drag_px = 0;
+    view_dirty = true;
+}
+
+static void screen_loaded_cb(lv_event_t *e) {
+    view_dirty = true;
+}
+
+static void plot_free(trend_plot_t *plot) {
+    heap_caps_free(plot->buf.data);
+    memset(plot, 0, sizeof(*plot));
+}
+
+// Pantalla descartada (screen_manager): liberar las gráficas; la ventana elegida se conserva
+static void screen_delete_cb(lv_event_t *e) {
+    trend_screen = NULL;
+    status_label = NULL;
+    plot_free(&plot_temp);
+    plot_free(&plot_vol);
+    heap_caps_free(columns);
+    columns = NULL;
+    view_dirty = true;
+}
+
+void create_trend_screen(lv_obj_t *scr) {
+    ESP_LOGI("TREND", "Creando pantalla de tendencias");
+    trend_screen = scr;
+    lv_obj_add_event_cb(scr, screen_delete_cb, LV_EVENT_DELETE, NULL);
+
+    // Fondo de la pantalla
+    lv_obj_t *bg = lv_obj_create(scr);
+    lv_obj_set_size(bg, LV_PCT(100), LV_PCT(100));
+    lv_obj_set_style_bg_color(bg, lv_color_hex(0xFFFFFF), LV_PART_MAIN); // Blanco
+    lv_obj_set_style_bg_opa(bg, LV_OPA_COVER, LV_PART_MAIN);
+
+    // Selector de ventana
+    lv_obj_t *selector = lv_buttonmatrix_create(scr);
+    lv_buttonmatrix_set_map(selector, window_map);
+    lv_buttonmatrix_set_button_ctrl_all(selector, LV_BUTTONMATRIX_CTRL_CHECKABLE);
+    lv_buttonmatrix_set_one_checked(selector, true);
+    uint32_t window_index = 0;
+    while (window_index + 1 < sizeof(windows_s) / sizeof(windows_s[0]) && windows_s[window_index] != window_s) {
+        window_index++;
+    }
+    lv_buttonmatrix_set_button_ctrl(selector, window_index, LV_BUTTONMATRIX_CTRL_CHECKED); // Al recrearla, la que había
+    lv_obj_set_size(selector, 520, 50);
+    lv_obj_set_pos(selector, TREND_PLOT_X, 95);
+    lv_obj_add_event_cb(selector, window_changed_cb, LV_EVENT_VALUE_CHANGED, NULL);
+
+    lv_obj_t *btn_live = lv_btn_create(scr);
+    lv_obj_set_size(btn_live, 100, 50);
+    lv_obj_set_pos(btn_live, TREND_PLOT_X + 530, 95);
+    lv_obj_t *label_live = lv_label_create(btn_live);
+    lv_label_set_text(label_live, "Vivo");
+    lv_obj_center(label_live);
+    lv_obj_add_event_cb(btn_live, live_cb, LV_EVENT_CLICKED, NULL);
+
+    columns = heap_caps_malloc(TREND_PLOT_W * TREND_SERIES * sizeof(trend_point_t), MALLOC_CAP_SPIRAM);
+    if (columns == NULL || !plot_init(&plot_temp, scr, 155, TREND_TEMP_H, SERIES_T1, 2, 2) ||
+        !plot_init(&plot_vol, scr, 155 + TREND_TEMP_H + 10, TREND_VOL_H, SERIES_VOL, 1, 0)) {
+        ESP_LOGE("TREND", "Sin memoria para las gráficas de tendencia");
+        heap_caps_free(columns);
+        columns = NULL;
+        return;     // Lo que sí se reservó se libera al descartar la pantalla
+    }
+    lv_obj_add_event_cb(plot_temp.canvas, plot_drag_cb, LV_EVENT_PRESSING, NULL);
+    lv_obj_add_event_cb(plot_vol.canvas, plot_drag_cb, LV_EVENT_PRESSING, NULL);
+
+    // Leyenda con el color de cada serie
+    static const char *const legend_names[TREND_SERIES] = { "T1", "T2", "Volumen" };
+    for (int s = 0; s < TREND_SERIES; s++) {
+        lv_obj_t *legend = lv_label_create(scr);
+        lv_label_set_text(legend, legend_names[s]);
+        lv_obj_set_style_text_color(legend, lv_color_hex(series_colors[s]), 0);
+        lv_obj_set_pos(legend, TREND_PLOT_X + s * 80, 155 + TREND_TEMP_H + 10 + TREND_VOL_H + 5);
+    }
+
+    status_label = lv_label_create(scr);
+    lv_label_set_text(status_label, "");
+    lv_obj_align(status_label, LV_ALIGN_BOTTOM_RIGHT, -20, -5);
+
+    lv_obj_add_event_cb(scr, screen_loaded_cb, LV_EVENT_SCREEN_LOADED, NULL);
+
+    static bool hook_registered = false;
+    if (!hook_registered) {
+        hook_registered = ui_update_register(trend_refresh_hook);
+    }
+}
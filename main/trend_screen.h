@@ -0,0 +1,9 @@
+#ifndef TREND_SCREEN_H
+#define TREND_SCREEN_H
+
+#include "lvgl.h"
+
+// Gráficas de tendencia de T1/T2 y volumen con ventanas de 1 min a 24 h
+void create_trend_screen(lv_obj_t *scr);
+
+#endif // TREND_SCREEN_H
@@ -6,4 +6,63 @@
 #define UART_TX_PIN 17  // Pin TX del ESP32 conectado al RX del ESP8266
 #define UART_RX_PIN 18  // Pin RX del ESP32 conectado al TX del ESP8266
 
+#define UART_DRIVER_RX_BUFFER_SIZE 4096 // Ring buffer del driver UART
+#define UART_DRIVER_TX_BUFFER_SIZE 1024 // Con buffer TX, uart_write_bytes no espera al cable
+#define UART_EVENT_QUEUE_LEN 20         // Profundidad de la cola de eventos del driver
+#define UART_FRAME_DELIMITER '\n'       // Terminador de trama (detección de patrón)
+#define UART_PATTERN_QUEUE_LEN 20       // Posiciones de patrón que recuerda el driver
+#define UART_RX_TIMEOUT_SYMBOLS 3       // Evento RX-timeout tras 3 símbolos de silencio
+
+#define UART_TELEMETRY_QUEUE_DEPTH 8    // Tramas DATA pendientes (descarta la más antigua)
+#define UART_CONTROL_QUEUE_DEPTH 16     // Resto de tramas pendientes (nunca descarta)
+
+#define UART_TX_QUEUE_DEPTH 16          // Comandos salientes pendientes
+#define UART_TX_MAX_COMMAND 255         // Longitud máxima de un comando
+#define UART_TX_ACK_TIMEOUT_MS 250      // Espera de ACK/NAK antes de reintentar
+#define UART_TX_MAX_RETRIES 3           // Reintentos tras el primer envío (sólo IDEMPOTENT/REPLACE)
+
+#define UART_BAUD_NEGOTIATION 1         // Negociar una velocidad mayor al arrancar (0 = fija)
+#define UART_BAUD_CANDIDATES {921600, 460800, 230400, 115200} // En orden de preferencia
+#define UART_BAUD_TEST_PATTERN "U5Z~0aU5Z~0a" // Transiciones alternas para verificar el cambio
+#define UART_BAUD_SETTLE_MS 20          // Margen tras cambiar de velocidad
+#define UART_LINK_GARBAGE_MS 3000       // Llegan bytes pero ninguna trama válida -> volver (el silencio no cuenta)
+#define UART_LINK_ERROR_BURST 8         // Errores de trama seguidos sin tramas válidas -> volver
+
+#define UART_BINARY_PROTOCOL 1          // Intentar negociar el protocolo binario (0 = sólo ASCII)
+#define UART_NEGOTIATION_TIMEOUT_MS 300 // Espera máxima de la respuesta del controlador
+
+#define DATA_KEYFRAME_RETRY_MS 1000     // Reenvío de GET_KEY* mientras no llegue la keyframe
+#define TREND_LEVELS_CFG {{1, 3600}, {10, 2160}, {60, 1440}} // {s por punto, puntos}: 1 h, 6 h y 24 h
+#define ALARM_TEXT_SIZE 512             // Texto de alarmas en pantalla; el resto se resume en "+<n> más"
+#define ALARM_HISTORY_SIZE 4096         // Flancos de alarma en RAM (PSRAM, potencia de 2, 20 bytes cada uno)
+#define ALARM_LOG_PARTITION "alarmlog"  // Partición del historial en flash (partitions.csv)
+#define ALARM_LOG_PARTITION_SUBTYPE 0x40
+#define ALARM_LOG_FLUSH_MS 500          // Agrupa los flancos de una ráfaga antes de escribir en flash
+#define SETTINGS_NVS_NAMESPACE "settings" // Ajustes persistentes en NVS (settings_store)
+#define SETTINGS_NVS_KEY "params"
+#define SETTINGS_SAVE_DELAY_MS 2000     // Escribir cuando los ajustes llevan este tiempo sin cambiar
+#define SETTINGS_SAVE_MAX_DELAY_MS 10000 // ...o como mucho tras este tiempo si no paran de cambiar
+#define DATALOG_PARTITION "datalog"     // Registro comprimido de telemetría (partitions.csv)
+#define DATALOG_PARTITION_SUBTYPE 0x41
+#define DATALOG_PERIOD_S 1              // Una muestra por segundo mientras llegan tramas
+#define DATALOG_WRITE_CHUNK 256         // Bytes codificados que se agrupan en cada escritura en flash
+#define DATALOG_FLUSH_S 30              // Máximo sin escribir lo pendiente (lo que se pierde ante un corte)
+#define DATALOG_EXPORT_LINE 64          // Bytes de bloque por línea "DL D" del volcado
+
+#define BOOT_FIRST_FRAME_TARGET_MS 500  // Aviso en el log si el primer frame llega más tarde
+#define RENDER_NVS_NAMESPACE "render"   // Perfil de render elegido (render_profile)
+#define RENDER_NVS_KEY "profile"
+#define RENDER_BENCH_SCENE_MS 3000      // Duración de cada escena del benchmark de render
+#define RENDER_BENCH_SCROLL_STEP 8      // Píxeles por frame en las escenas de scroll
+#define RENDER_BENCH_KERNEL_BYTES (4 * 1024 * 1024) // Bytes escritos por cada medida de núcleo RGB565
+#define SCREEN_STACK_DEPTH 8            // Entradas de la pila de "atrás" (screen_manager, >= 2)
+#define SCREEN_MEM_BUDGET (512 * 1024)  // Heap para pantallas creadas; por encima se descartan las menos usadas
+
+#define SCHED_PROFILE SCHED_PROFILE_SPLIT // Núcleos y prioridades (sched_profile.h, sched_tasks.h)
+#define SCHED_STATS_MAX_TASKS 32        // Tareas que cubre SCHED:STATS
+#define SCHED_CORE_BUSY_WARN 90         // % de carga de un núcleo que SCHED:STATS marca como saturado
+
+#define TRACE_LEVEL 4                   // Eventos de traza compilados (TRACE_LEVEL_* en trace.h)
+#define TRACE_RING_SIZE 512             // Registros por núcleo (potencia de 2, 24 bytes cada uno)
+
 #endif // UART_CONFIG_H
@@ -0,0 +1,342 @@
+// uart_tx.c
+#include "uart_tx.h"
+#include "uart_utils.h"
+#include "trace.h"
+#include "uart_config.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    TX_FREE = 0,
+    TX_QUEUED,      // Esperando turno
+    TX_INFLIGHT,    // Enviado, esperando ACK
+} tx_state_t;
+
+typedef struct {
+    tx_state_t state;
+    uint32_t flags;
+    uint32_t seq;
+    uint8_t attempts;
+    int8_t result;          // 0 pendiente, 1 ACK, -1 NAK
+    int64_t t_enqueue;
+    int64_t deadline;       // Fin de la espera de ACK
+    char command[UART_TX_MAX_COMMAND + 1];
+} tx_entry_t;
+
+// Un intento de envío, copiado de su entrada para formatearlo y trazarlo fuera de tx_lock
+typedef struct {
+    uint32_t seq;
+    uint8_t attempts;
+    bool sequenced;         // "<comando>#<seq>\n"; si no, el comando tal cual
+    size_t len;             // 0 = nada que enviar
+    char command[UART_TX_MAX_COMMAND + 1];
+} tx_attempt_t;
+
+// Cierre del comando en vuelo, para trazarlo fuera de tx_lock
+typedef struct {
+    uint32_t seq;
+    uint8_t attempts;
+    uint32_t latency;
+    bool acked;
+    bool naked;
+    bool failed;
+} tx_close_t;
+
+// Sólo se reintentan comandos que pueden repetirse sin efecto extra: un
+// IDEMPOTENT o un REPLACE (valores absolutos, p. ej. SETTINGS). CMD:RES01* y
+// similares salen una sola vez aunque no llegue el ACK.
+#define TX_RETRY_SAFE (UART_TX_FLAG_IDEMPOTENT | UART_TX_FLAG_REPLACE)
+
+static tx_entry_t tx_entries[UART_TX_QUEUE_DEPTH];
+static uint32_t next_seq = 1;
+static uart_tx_stats_t tx_stats;
+static TaskHandle_t tx_task_handle = NULL;
+static bool peer_sequenced; // El controlador anunció CAPS:SEQ en la negociación
+static SemaphoreHandle_t write_mutex; // uart_tx_task lo toma al escribir; uart_tx_pause lo retiene
+
+// Sección crítica corta: la comparten los callbacks de UI, el parser y la tarea TX
+static portMUX_TYPE tx_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t command_prefix_len(const char *command) {
+    const char *colon = strchr(command, ':');
+    return colon != NULL ? (size_t)(colon - command) : strlen(command);
+}
+
+bool uart_tx_send(const char *command, uint32_t flags) {
+    size_t len = strlen(command);
+    if (len == 0 || len > UART_TX_MAX_COMMAND) {
+        portENTER_CRITICAL(&tx_lock);
+        tx_stats.rejected++;
+        portEXIT_CRITICAL(&tx_lock);
+        return false;
+    }
+    size_t prefix_len = command_prefix_len(command);
+    bool accepted = false;
+    bool coalesced = false;
+
+    portENTER_CRITICAL(&tx_lock);
+    tx_entry_t *free_entry = NULL;
+    for (int i = 0; i < UART_TX_QUEUE_DEPTH && !coalesced; i++) {
+        tx_entry_t *entry = &tx_entries[i];
+        if (entry->state == TX_FREE) {
+            if (free_entry == NULL) {
+                free_entry = entry;
+            }
+            continue;
+        }
+        if ((flags & UART_TX_FLAG_IDEMPOTENT) && strcmp(entry->command, command) == 0) {
+            // El pendiente (o el que está en vuelo) ya produce el mismo efecto
+            coalesced = true;
+        } else if ((flags & UART_TX_FLAG_REPLACE) && entry->state == TX_QUEUED &&
+                   command_prefix_len(entry->command) == prefix_len &&
+                   strncmp(entry->command, command, prefix_len) == 0) {
+            // Todavía no salió: basta con enviar el valor más reciente
+            memcpy(entry->command, command, len + 1);
+            entry->flags = flags;
+            coalesced = true;
+        }
+    }
+    if (coalesced) {
+        tx_stats.coalesced++;
+        accepted = true;
+    } else if (free_entry != NULL) {
+        memcpy(free_entry->command, command, len + 1);
+        free_entry->flags = flags;
+        free_entry->seq = next_seq++;
+        free_entry->attempts = 0;
+        free_entry->result = 0;
+        free_entry->t_enqueue = esp_timer_get_time();
+        free_entry->state = TX_QUEUED;
+        tx_stats.enqueued++;
+        accepted = true;
+    } else {
+        tx_stats.rejected++;
+    }
+    portEXIT_CRITICAL(&tx_lock);
+
+    if (accepted && !coalesced && tx_task_handle != NULL) {
+        xTaskNotifyGive(tx_task_handle);
+    }
+    return accepted;
+}
+
+void send_command(const char *command) {
+    if (!uart_tx_send(command, 0)) {
+        ESP_LOGW("UART_TX", "Comando descartado (cola llena): %s", command);
+    }
+}
+
+void uart_tx_get_stats(uart_tx_stats_t *out) {
+    if (out != NULL) {
+        portENTER_CRITICAL(&tx_lock);
+        *out = tx_stats;
+        portEXIT_CRITICAL(&tx_lock);
+    }
+}
+
+// Marca el comando en vuelo con el resultado recibido (tarea parser)
+static void ack_result(const char *data, int8_t result) {
+    const char *colon = strchr(data, ':');
+    if (colon == NULL) {
+        return;
+    }
+    uint32_t seq = (uint32_t)strtoul(colon + 1, NULL, 10);
+
+    bool matched = false;
+    portENTER_CRITICAL(&tx_lock);
+    for (int i = 0; i < UART_TX_QUEUE_DEPTH; i++) {
+        if (tx_entries[i].state == TX_INFLIGHT && tx_entries[i].seq == seq) {
+            tx_entries[i].result = result;
+            matched = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&tx_lock);
+
+    if (matched) {
+        xTaskNotifyGive(tx_task_handle);
+    }
+}
+
+static void ack_handler(const char *data) {
+    ack_result(data, 1);
+}
+
+static void nak_handler(const char *data) {
+    ack_result(data, -1);
+}
+
+bool uart_tx_init(void) {
+    if (write_mutex == NULL && (write_mutex = xSemaphoreCreateMutex()) == NULL) {
+        ESP_LOGE("UART_TX", "Failed to create write mutex");
+        return false;
+    }
+    return uart_register_handler("ACK", ack_handler) &&
+           uart_register_handler("NAK", nak_handler);
+}
+
+void uart_tx_set_sequenced(bool enable) {
+    portENTER_CRITICAL(&tx_lock);
+    peer_sequenced = enable;
+    portEXIT_CRITICAL(&tx_lock);
+    if (tx_task_handle != NULL) {
+        xTaskNotifyGive(tx_task_handle);
+    }
+}
+
+void uart_tx_pause(void) {
+    if (write_mutex != NULL) {
+        xSemaphoreTake(write_mutex, portMAX_DELAY);
+    }
+}
+
+void uart_tx_resume(void) {
+    if (write_mutex != NULL) {
+        xSemaphoreGive(write_mutex);
+    }
+}
+
+// Copia el intento actual de la entrada. Requiere tx_lock.
+static void snapshot_attempt(tx_entry_t *entry, tx_attempt_t *out) {
+    entry->attempts++;
+    tx_stats.sent++;
+    out->seq = entry->seq;
+    out->attempts = entry->attempts;
+    out->sequenced = peer_sequenced;
+    out->len = strlen(entry->command);
+    memcpy(out->command, entry->command, out->len + 1);
+}
+
+// Cierra el comando en vuelo si ya tiene resultado o agotó su tiempo (en
+// `closed`), o copia el reintento en `send`. Devuelve los us que quedan de
+// espera (0 = ya no está en vuelo). Requiere tx_lock.
+static int64_t service_inflight(tx_entry_t *entry, int64_t now, tx_close_t *closed, tx_attempt_t *send) {
+    closed->seq = entry->seq;
+    closed->attempts = entry->attempts;
+    if (entry->result > 0) {
+        uint32_t latency = (uint32_t)(now - entry->t_enqueue);
+        tx_stats.acked++;
+        tx_stats.latency_last_us = latency;
+        tx_stats.latency_total_us += latency;
+        if (latency > tx_stats.latency_max_us) {
+            tx_stats.latency_max_us = latency;
+        }
+        closed->acked = true;
+        closed->latency = latency;
+        entry->state = TX_FREE;
+        return 0;
+    }
+    if (entry->result < 0 || now >= entry->deadline) {
+        if (entry->result < 0) {
+            tx_stats.naked++;
+            closed->naked = true;
+        }
+        // Si la renegociación quitó la secuencia, nadie va a confirmar el reintento
+        if (entry->attempts > UART_TX_MAX_RETRIES || !(entry->flags & TX_RETRY_SAFE) || !peer_sequenced) {
+            tx_stats.failed++;
+            closed->failed = true;
+            entry->state = TX_FREE;
+            return 0;
+        }
+        tx_stats.retries++;
+        entry->result = 0;
+        entry->deadline = now + UART_TX_ACK_TIMEOUT_MS * 1000LL;
+        snapshot_attempt(entry, send);
+    }
+    return entry->deadline - now;
+}
+
+// Comando encolado más antiguo (menor número de secuencia). Requiere tx_lock.
+static tx_entry_t *oldest_queued(void) {
+    tx_entry_t *oldest = NULL;
+    for (int i = 0; i < UART_TX_QUEUE_DEPTH; i++) {
+        tx_entry_t *entry = &tx_entries[i];
+        if (entry->state == TX_QUEUED && (oldest == NULL || (int32_t)(entry->seq - oldest->seq) < 0)) {
+            oldest = entry;
+        }
+    }
+    return oldest;
+}
+
+void uart_tx_task(void *arg) {
+    static char line[UART_TX_MAX_COMMAND + 16];
+    static tx_attempt_t send;
+    tx_entry_t *inflight = NULL;
+    TickType_t wait = 0; // Atender lo encolado antes de que arrancara la tarea
+
+    tx_task_handle = xTaskGetCurrentTaskHandle();
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        tx_close_t closed = { 0 };
+        bool more = false;
+        int64_t remaining = 0;
+        send.len = 0;
+
+        // Bajo tx_lock sólo se decide y se copia; formatear, trazar y escribir, después
+        portENTER_CRITICAL(&tx_lock);
+        int64_t now = esp_timer_get_time();
+        if (inflight != NULL) {
+            remaining = service_inflight(inflight, now, &closed, &send);
+            if (remaining == 0) {
+                inflight = NULL;
+            }
+        }
+        if (inflight == NULL) {
+            // Un solo comando en vuelo: el controlador confirma en orden
+            tx_entry_t *next = oldest_queued();
+            if (next != NULL) {
+                snapshot_attempt(next, &send);
+                // Un controlador sin CAPS:SEQ recibe el comando tal cual y no confirma:
+                // no esperar ni reintentar
+                if ((next->flags & UART_TX_FLAG_NO_ACK) || !peer_sequenced) {
+                    next->state = TX_FREE;
+                    more = true; // Pasar directamente al siguiente
+                } else {
+                    next->state = TX_INFLIGHT;
+                    next->deadline = now + UART_TX_ACK_TIMEOUT_MS * 1000LL;
+                    remaining = UART_TX_ACK_TIMEOUT_MS * 1000LL;
+                    inflight = next;
+                }
+            }
+        }
+        portEXIT_CRITICAL(&tx_lock);
+
+        if (closed.acked) {
+            TRACE(TX_ACK, closed.seq, closed.latency, 0);
+        }
+        if (closed.naked) {
+            TRACE(TX_NAK, closed.seq, closed.attempts, 0);
+        }
+        if (closed.failed) {
+            TRACE(TX_FAILED, closed.seq, closed.attempts, 0);
+        }
+        if (send.len > 0) {
+            TRACE(TX_SEND, send.seq, send.attempts, send.len);
+            int line_len = send.sequenced
+                               ? snprintf(line, sizeof(line), "%s#%lu\n", send.command, (unsigned long)send.seq)
+                               : snprintf(line, sizeof(line), "%s", send.command);
+            // Con buffer TX en el driver, uart_write_bytes sólo copia al ring buffer
+            xSemaphoreTake(write_mutex, portMAX_DELAY);
+            uart_write_bytes(UART_PORT_NUM, line, line_len);
+            xSemaphoreGive(write_mutex);
+        }
+
+        if (more) {
+            wait = 0;
+        } else if (remaining > 0) {
+            wait = pdMS_TO_TICKS((remaining + 999) / 1000);
+            wait = wait > 0 ? wait : 1;
+        } else {
+            wait = portMAX_DELAY;
+        }
+    }
+}
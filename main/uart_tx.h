@@ -0,0 +1,61 @@
+// uart_tx.h
+#ifndef UART_TX_H
+#define UART_TX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Envío asíncrono de comandos al controlador.
+//
+// Si el controlador anunció CAPS:SEQ en la negociación del enlace
+// (uart_utils.c), cada comando sale como "<comando>#<seq>\n" y el controlador
+// responde "ACK:<seq>" o "NAK:<seq>". Sin respuesta en UART_TX_ACK_TIMEOUT_MS
+// se reintenta hasta UART_TX_MAX_RETRIES veces, pero sólo los IDEMPOTENT y
+// REPLACE: el resto (p. ej. CMD:RES01*) sale una vez y, sin ACK, cuenta como
+// fallido. Sin CAPS:SEQ (controlador antiguo, o negociación aún en curso) los
+// comandos salen tal cual, p. ej. "GET_SETTINGS*", una sola vez y sin esperar ACK.
+
+#define UART_TX_FLAG_IDEMPOTENT (1u << 0) // Si ya hay uno idéntico pendiente, no se encola otro
+#define UART_TX_FLAG_REPLACE    (1u << 1) // Sustituye al pendiente con el mismo prefijo (p. ej. SETTINGS); sólo
+                                          // para comandos con valores absolutos, que pueden repetirse
+#define UART_TX_FLAG_NO_ACK     (1u << 2) // No espera confirmación
+
+typedef struct {
+    uint32_t enqueued;          // Comandos aceptados en la cola
+    uint32_t coalesced;         // Comandos absorbidos por uno pendiente (IDEMPOTENT/REPLACE)
+    uint32_t rejected;          // Cola llena o comando demasiado largo
+    uint32_t sent;              // Escrituras en el UART (incluye reintentos)
+    uint32_t retries;
+    uint32_t acked;
+    uint32_t naked;             // NAK recibidos
+    uint32_t failed;            // Agotados los reintentos
+    uint32_t latency_last_us;   // Encolado -> ACK del último comando
+    uint32_t latency_max_us;
+    uint64_t latency_total_us;  // media = total / acked
+} uart_tx_stats_t;
+
+// Registra los handlers de ACK/NAK; llamar después de uart_utils_init
+bool uart_tx_init(void);
+
+// Encola un comando sin bloquear; vuelve en microsegundos sea cual sea la velocidad del enlace
+bool uart_tx_send(const char *command, uint32_t flags);
+
+// Función para enviar comandos (sin flags)
+void send_command(const char *command);
+
+void uart_tx_get_stats(uart_tx_stats_t *out);
+
+// Formato con secuencia y ACK (true) o comandos tal cual (false); lo fija la
+// negociación del enlace
+void uart_tx_set_sequenced(bool enable);
+
+// Detiene las escrituras de uart_tx_task (espera a que acabe la que esté en
+// curso) hasta uart_tx_resume; lo usa el cambio de velocidad del enlace.
+// Los dos desde la misma tarea.
+void uart_tx_pause(void);
+void uart_tx_resume(void);
+
+// Tarea que escribe en el UART y gestiona ACK, timeouts y reintentos
+void uart_tx_task(void *arg);
+
+#endif // UART_TX_H
@@ -3,19 +3,314 @@
 #include "esp_log.h"
 #include "driver/uart.h"
 #include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include "uart_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
+#include "line_framer.h"
+#include "frame_queue.h"
+#include "trace.h"
+#include "uart_tx.h"
+#include <stdatomic.h>
 
-#define MAX_UART_HANDLERS 10
-#define UART_RX_BUFFER_SIZE 4096
+#define MAX_UART_HANDLERS 16   // Prefijos registrables
+#define DISPATCH_SLOTS 32      // Tabla hash abierta; potencia de 2 mayor que MAX_UART_HANDLERS
+#define DISPATCH_MASK (DISPATCH_SLOTS - 1)
 
-typedef void (*uart_data_handler_t)(const char *);
+typedef struct {
+    char prefix[UART_PREFIX_MAX_LEN + 1];
+    uint8_t len;                    // 0 = slot libre
+    uart_data_handler_t handler;
+} dispatch_entry_t;
 
-static uart_data_handler_t data_handlers[MAX_UART_HANDLERS] = {0};
+// Tabla de despacho inmutable una vez publicada. Los registros construyen una
+// copia nueva y la publican con un intercambio atómico del puntero (estilo RCU),
+// así el camino de recepción nunca toma un mutex.
+typedef struct {
+    dispatch_entry_t slots[DISPATCH_SLOTS];
+    uint8_t count;
+    uart_bin_handler_t bin[TP_MSG_MAX];
+    atomic_uint readers;            // Lectores dentro de la tabla
+} dispatch_table_t;
 
-// Mutex para proteger el acceso a la lista de handlers
+static dispatch_table_t dispatch_tables[2];
+static _Atomic(dispatch_table_t *) active_table = &dispatch_tables[0];
+
+// Mutex que serializa a los escritores (registro/desregistro); nunca lo toma el RX
 static SemaphoreHandle_t handlers_mutex = NULL;
 
+// Cola de eventos del driver UART (detección de patrón, RX-timeout, overflow)
+static QueueHandle_t uart_event_queue = NULL;
+
+static uart_rx_stats_t rx_stats;
+
+// Ensamblador de tramas; sólo lo usa uart_receive_task
+static line_framer_t rx_framer;
+
+// Colas SPSC entre uart_receive_task (productor) y uart_parser_task (consumidor)
+static frame_queue_t telemetry_queue;
+static frame_queue_t control_queue;
+static TaskHandle_t parser_task_handle = NULL;
+
+// Modo binario negociado: las tramas son COBS delimitadas por 0x00
+static bool binary_mode = false;
+
+// Negociación del enlace: máquina de estados que avanza dentro de
+// uart_receive_task sin bloquearla. Cada paso envía un comando y fija la
+// respuesta esperada y un plazo; mientras tanto la tarea sigue vaciando el
+// driver y encolando el resto de tramas.
+typedef enum {
+    LINK_IDLE,          // Sin negociación en curso
+    LINK_CAPS,          // CAPS?* enviado, esperando CAPS:<lista>
+    LINK_QUERY,         // BAUD?* enviado, esperando BAUD:<lista>
+    LINK_SET,           // BAUD=<r>* enviado, esperando ACK:BAUD=<r>
+    LINK_SETTLE,        // Velocidad ya cambiada, margen antes del PING
+    LINK_VERIFY,        // PING enviado a la nueva velocidad, esperando PONG
+    LINK_BACKOFF,       // Verificación fallida: dar tiempo al controlador a volver
+    LINK_PROTO,         // PROTO:BIN1* enviado, esperando la confirmación
+} link_state_t;
+
+static const uint32_t link_candidates[] = UART_BAUD_CANDIDATES;
+
+static link_state_t link_state = LINK_IDLE;
+static char link_expect[24];        // Prefijo de la respuesta esperada ("" = sólo plazo)
+static int64_t link_deadline;       // Fin del paso actual
+static size_t link_candidate;       // Siguiente candidata a probar
+static uint32_t link_pending_baud;  // Velocidad pedida con BAUD=
+static char link_baud_list[96];     // Respuesta a BAUD?
+
+// Vigilancia del enlace negociado
+static uart_link_stats_t link_stats;
+static uint32_t link_frame_errors;  // rx_stats.frame_errors al inicio de la ventana de vigilancia
+static uint32_t link_frames_seen;   // rx_stats.frames_enqueued en la última comprobación
+static int64_t link_garbage_since;  // Primer evento sin tramas válidas desde la última trama (0 = ninguno)
+
+// Cambia el terminador que buscan el driver y el framer
+static void set_frame_delimiter(char delimiter) {
+    line_framer_init(&rx_framer, delimiter);
+    uart_enable_pattern_det_baud_intr(UART_PORT_NUM, delimiter, 1, 1, 0, 0);
+    uart_pattern_queue_reset(UART_PORT_NUM, UART_PATTERN_QUEUE_LEN);
+}
+
+// Cambia la velocidad local y descarta lo recibido a la velocidad anterior.
+// uart_tx_task queda en pausa para que ningún comando salga a medias entre dos velocidades.
+static void set_local_baud(uint32_t baud) {
+    uart_tx_pause();
+    uart_wait_tx_done(UART_PORT_NUM, pdMS_TO_TICKS(100));
+    uart_set_baudrate(UART_PORT_NUM, baud);
+    uart_tx_resume();
+    uart_flush_input(UART_PORT_NUM);
+    line_framer_init(&rx_framer, UART_FRAME_DELIMITER);
+    link_stats.baud = baud;
+}
+
+// Busca `cap` en la lista "CAPS:SEQ,..." del controlador
+static bool caps_has(const char *list, const char *cap) {
+    size_t len = strlen(cap);
+    const char *p = strchr(list, ':');
+    while (p != NULL) {
+        p++;
+        if (strncmp(p, cap, len) == 0 && (p[len] == ',' || p[len] == '\0')) {
+            return true;
+        }
+        p = strchr(p, ',');
+    }
+    return false;
+}
+
+// Busca `baud` en la lista "BAUD:9600,115200,..." del controlador
+static bool baud_supported(const char *list, uint32_t baud) {
+    const char *p = strchr(list, ':');
+    while (p != NULL) {
+        char *end;
+        if (strtoul(p + 1, &end, 10) == baud) {
+            return true;
+        }
+        p = strchr(end, ',');
+    }
+    return false;
+}
+
+// Pasa al estado `state`: envía `command` (si lo hay) y espera `expect` hasta el plazo
+static void link_step(link_state_t state, const char *command, const char *expect, uint32_t timeout_ms) {
+    if (command != NULL) {
+        uart_write_bytes(UART_PORT_NUM, command, strlen(command));
+    }
+    snprintf(link_expect, sizeof(link_expect), "%s", expect);
+    link_state = state;
+    link_deadline = esp_timer_get_time() + timeout_ms * 1000LL;
+}
+
+// Fin de la negociación: fija el terminador del protocolo elegido y reinicia la vigilancia
+static void link_done(void) {
+    link_state = LINK_IDLE;
+    if (binary_mode) {
+        set_frame_delimiter(TP_FRAME_DELIMITER);
+    }
+    link_frame_errors = rx_stats.frame_errors;
+    link_frames_seen = rx_stats.frames_enqueued;
+    link_garbage_since = 0;
+#if UART_BINARY_PROTOCOL
+    ESP_LOGI("UART_UTILS", "Protocolo de telemetría: %s", binary_mode ? "binario (COBS+CRC16)" : "ASCII");
+#endif
+}
+
+static void link_negotiate_protocol(void) {
+#if UART_BINARY_PROTOCOL
+    link_step(LINK_PROTO, TP_NEGOTIATE_CMD, TP_NEGOTIATE_ACK, UART_NEGOTIATION_TIMEOUT_MS);
+#else
+    link_done();
+#endif
+}
+
+// Pide la siguiente candidata que el controlador admite, o sigue con el protocolo
+static void link_try_next_baud(void) {
+    while (link_candidate < sizeof(link_candidates) / sizeof(link_candidates[0])) {
+        uint32_t baud = link_candidates[link_candidate++];
+        if (baud_supported(link_baud_list, baud)) {
+            char command[32];
+            char ack[sizeof(link_expect)];
+            snprintf(command, sizeof(command), "BAUD=%lu*", (unsigned long)baud);
+            snprintf(ack, sizeof(ack), "ACK:BAUD=%lu", (unsigned long)baud);
+            link_pending_baud = baud;
+            link_step(LINK_SET, command, ack, UART_NEGOTIATION_TIMEOUT_MS);
+            return;
+        }
+    }
+    link_stats.negotiation_failures++;
+    link_negotiate_protocol();
+}
+
+// Velocidad, tras las capacidades
+static void link_negotiate_baud(void) {
+#if UART_BAUD_NEGOTIATION
+    link_stats.negotiations++;
+    link_step(LINK_QUERY, "BAUD?*", "BAUD:", UART_NEGOTIATION_TIMEOUT_MS);
+#else
+    link_negotiate_protocol();
+#endif
+}
+
+// Negociación de capacidades, velocidad y protocolo partiendo de UART_BAUD_RATE en ASCII:
+//   -> CAPS?*                    <- CAPS:<c1>,<c2>,...  (SEQ: comandos "<cmd>#<seq>\n" con ACK)
+//   -> BAUD?*                    <- BAUD:<r1>,<r2>,...
+//   -> BAUD=<r>*                 <- ACK:BAUD=<r>    (ambos extremos cambian tras el ACK)
+//   -> PING:<patrón>* a <r>      <- PONG:<patrón>
+//   -> PROTO:BIN1*               <- PROTO:BIN1
+// El controlador vuelve a UART_BAUD_RATE si no recibe un PING válido en 1 s,
+// así que un fallo de verificación sólo requiere volver localmente. Un
+// controlador antiguo no contesta a CAPS?* y sigue recibiendo los comandos tal cual.
+static void link_start(void) {
+    binary_mode = false;
+    set_frame_delimiter(UART_FRAME_DELIMITER);
+    // Hasta que el controlador lo confirme (puede haberse cambiado), sin secuencia
+    uart_tx_set_sequenced(false);
+    link_step(LINK_CAPS, "CAPS?*", "CAPS:", UART_NEGOTIATION_TIMEOUT_MS);
+}
+
+// Respuesta esperada del paso actual
+static void link_on_reply(const char *reply) {
+    switch (link_state) {
+    case LINK_CAPS:
+        link_stats.sequenced = caps_has(reply, "SEQ");
+        uart_tx_set_sequenced(link_stats.sequenced);
+        ESP_LOGI("UART_UTILS", "Capacidades del controlador: %s", reply + 5);
+        link_negotiate_baud();
+        break;
+    case LINK_QUERY:
+        strncpy(link_baud_list, reply, sizeof(link_baud_list) - 1);
+        link_candidate = 0;
+        link_try_next_baud();
+        break;
+    case LINK_SET:
+        set_local_baud(link_pending_baud);
+        link_step(LINK_SETTLE, NULL, "", UART_BAUD_SETTLE_MS);
+        break;
+    case LINK_VERIFY:
+        ESP_LOGI("UART_UTILS", "Velocidad negociada: %lu baudios", (unsigned long)link_stats.baud);
+        link_negotiate_protocol();
+        break;
+    case LINK_PROTO:
+        binary_mode = true;
+        link_done();
+        break;
+    default:
+        break;
+    }
+}
+
+// Plazo del paso actual vencido
+static void link_on_timeout(void) {
+    switch (link_state) {
+    case LINK_CAPS:
+        ESP_LOGI("UART_UTILS", "El controlador no anuncia capacidades; comandos sin secuencia ni ACK");
+        link_stats.sequenced = false;
+        link_negotiate_baud();
+        break;
+    case LINK_QUERY:
+        ESP_LOGI("UART_UTILS", "El controlador no negocia velocidad; se mantiene %d", UART_BAUD_RATE);
+        link_negotiate_protocol();
+        break;
+    case LINK_SET:
+    case LINK_BACKOFF:
+        link_try_next_baud();
+        break;
+    case LINK_SETTLE:
+        link_step(LINK_VERIFY, "PING:" UART_BAUD_TEST_PATTERN "*", "PONG:" UART_BAUD_TEST_PATTERN,
+                  UART_NEGOTIATION_TIMEOUT_MS);
+        break;
+    case LINK_VERIFY:
+        link_stats.verify_failures++;
+        ESP_LOGW("UART_UTILS", "Verificación fallida a %lu baudios, volviendo a %d", (unsigned long)link_stats.baud,
+                 UART_BAUD_RATE);
+        set_local_baud(UART_BAUD_RATE);
+        // Dar tiempo a que el controlador también vuelva antes de probar la siguiente
+        link_step(LINK_BACKOFF, NULL, "", 1000 + UART_BAUD_SETTLE_MS);
+        break;
+    case LINK_PROTO:
+        link_done();
+        break;
+    default:
+        break;
+    }
+}
+
+// Se queda la trama si es la respuesta que espera la negociación
+static bool link_take_reply(const line_frame_t *frame) {
+    if (link_state == LINK_IDLE || link_expect[0] == '\0' ||
+        strncmp(frame->data, link_expect, strlen(link_expect)) != 0) {
+        return false;
+    }
+    link_on_reply(frame->data);
+    return true;
+}
+
+// Espera máxima de uart_receive_task hasta el plazo de la negociación
+static TickType_t link_wait(void) {
+    if (link_state == LINK_IDLE) {
+        return portMAX_DELAY;
+    }
+    int64_t remaining = link_deadline - esp_timer_get_time();
+    if (remaining <= 0) {
+        return 0;
+    }
+    TickType_t wait = pdMS_TO_TICKS((remaining + 999) / 1000);
+    return wait > 0 ? wait : 1;
+}
+
+// Tras un reset, el controlador vuelve a UART_BAUD_RATE: a la velocidad negociada
+// sólo se ven errores de trama o bytes sin sentido. Volver a la velocidad base y renegociar.
+static void link_fallback(const char *reason) {
+    ESP_LOGW("UART_UTILS", "Enlace perdido a %lu baudios (%s); renegociando", (unsigned long)link_stats.baud, reason);
+    link_stats.fallbacks++;
+    set_local_baud(UART_BAUD_RATE);
+    link_start();
+}
+
 // Función pública para inicializar los handlers
 bool uart_utils_init(void) {
     if (handlers_mutex == NULL) {
@@ -27,6 +322,26 @@ bool uart_utils_init(void) {
         ESP_LOGI("UART_UTILS", "Handlers mutex initialized");
     }
 
+    if (uart_event_queue == NULL) {
+        line_framer_init(&rx_framer, UART_FRAME_DELIMITER);
+        if (!frame_queue_init(&telemetry_queue, UART_TELEMETRY_QUEUE_DEPTH, FRAME_QUEUE_DROP_OLDEST) ||
+            !frame_queue_init(&control_queue, UART_CONTROL_QUEUE_DEPTH, FRAME_QUEUE_NEVER_DROP)) {
+            ESP_LOGE("UART_UTILS", "Failed to allocate frame queues");
+            return false;
+        }
+
+        // El driver publica un evento por cada terminador recibido, así la trama
+        // se despacha en cuanto llega el '\n' en lugar de esperar a un sondeo
+        if (uart_driver_install(UART_PORT_NUM, UART_DRIVER_RX_BUFFER_SIZE, UART_DRIVER_TX_BUFFER_SIZE,
+                                UART_EVENT_QUEUE_LEN, &uart_event_queue, 0) != ESP_OK) {
+            ESP_LOGE("UART_UTILS", "Failed to install UART driver");
+            return false;
+        }
+        uart_enable_pattern_det_baud_intr(UART_PORT_NUM, UART_FRAME_DELIMITER, 1, 1, 0, 0);
+        uart_pattern_queue_reset(UART_PORT_NUM, UART_PATTERN_QUEUE_LEN);
+        uart_set_rx_timeout(UART_PORT_NUM, UART_RX_TIMEOUT_SYMBOLS);
+    }
+
     // Desactivar el modo eco
     const char *disable_echo_cmd = "ATE0\r\n";
     if (uart_write_bytes(UART_PORT_NUM, disable_echo_cmd, strlen(disable_echo_cmd)) == strlen(disable_echo_cmd)) {
@@ -36,123 +351,452 @@ bool uart_utils_init(void) {
         return false;
     }
 
+    // La negociación la hace uart_receive_task al arrancar, sin retrasar el resto del arranque
+    link_stats.baud = UART_BAUD_RATE;
+
     return true;
 }
 
+uint32_t uart_link_get_baud(void) {
+    return link_stats.baud;
+}
+
+void uart_get_link_stats(uart_link_stats_t *out) {
+    if (out != NULL) {
+        *out = link_stats;
+    }
+}
+
+bool uart_utils_binary_mode(void) {
+    return binary_mode;
+}
+
+// FNV-1a sobre el prefijo
+static uint32_t prefix_hash(const char *prefix, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)prefix[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Longitud del prefijo de una trama: hasta ':' o fin de cadena. 0 si es demasiado largo.
+static size_t frame_prefix_len(const char *frame) {
+    for (size_t i = 0; i <= UART_PREFIX_MAX_LEN; i++) {
+        if (frame[i] == ':' || frame[i] == '\0') {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static dispatch_entry_t *table_find(dispatch_table_t *table, const char *prefix, size_t len) {
+    uint32_t idx = prefix_hash(prefix, len) & DISPATCH_MASK;
+    for (int probe = 0; probe < DISPATCH_SLOTS; probe++) {
+        dispatch_entry_t *entry = &table->slots[(idx + probe) & DISPATCH_MASK];
+        if (entry->len == 0) {
+            return NULL;
+        }
+        if (entry->len == len && memcmp(entry->prefix, prefix, len) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void table_insert(dispatch_table_t *table, const char *prefix, size_t len, uart_data_handler_t handler) {
+    uint32_t idx = prefix_hash(prefix, len) & DISPATCH_MASK;
+    for (int probe = 0; probe < DISPATCH_SLOTS; probe++) {
+        dispatch_entry_t *entry = &table->slots[(idx + probe) & DISPATCH_MASK];
+        if (entry->len == 0) {
+            memcpy(entry->prefix, prefix, len);
+            entry->prefix[len] = '\0';
+            entry->len = len;
+            entry->handler = handler;
+            table->count++;
+            return;
+        }
+    }
+}
+
+// Obtiene la tabla activa para leerla sin bloqueo
+static dispatch_table_t *dispatch_acquire(void) {
+    for (;;) {
+        dispatch_table_t *table = atomic_load_explicit(&active_table, memory_order_acquire);
+        atomic_fetch_add_explicit(&table->readers, 1, memory_order_acq_rel);
+        // Confirmar que no se retiró entre la carga y el incremento
+        if (table == atomic_load_explicit(&active_table, memory_order_acquire)) {
+            return table;
+        }
+        atomic_fetch_sub_explicit(&table->readers, 1, memory_order_release);
+    }
+}
+
+static void dispatch_release(dispatch_table_t *table) {
+    atomic_fetch_sub_explicit(&table->readers, 1, memory_order_release);
+}
+
+// Prepara la tabla inactiva como copia de la activa. Requiere handlers_mutex.
+static dispatch_table_t *dispatch_begin_update(void) {
+    dispatch_table_t *current = atomic_load_explicit(&active_table, memory_order_acquire);
+    dispatch_table_t *next = (current == &dispatch_tables[0]) ? &dispatch_tables[1] : &dispatch_tables[0];
+
+    // Periodo de gracia: esperar a que salga cualquier lector de la versión anterior
+    while (atomic_load_explicit(&next->readers, memory_order_acquire) != 0) {
+        vTaskDelay(1);
+    }
+    memcpy(next->slots, current->slots, sizeof(next->slots));
+    memcpy(next->bin, current->bin, sizeof(next->bin));
+    next->count = current->count;
+    return next;
+}
+
+static void dispatch_publish(dispatch_table_t *next) {
+    atomic_store_explicit(&active_table, next, memory_order_release);
+}
 
-bool uart_register_handler(uart_data_handler_t handler) {
+bool uart_register_bin_handler(tp_msg_type_t type, uart_bin_handler_t handler) {
     if (handlers_mutex == NULL) {
         ESP_LOGE("UART_UTILS", "handlers_mutex not initialized");
         return false;
     }
+    if (type >= TP_MSG_MAX || type == TP_MSG_TEXT) {
+        // Los mensajes de texto se entregan a los handlers ASCII
+        ESP_LOGW("UART_UTILS", "Tipo binario no registrable: %d", type);
+        return false;
+    }
 
     bool registered = false;
     if (xSemaphoreTake(handlers_mutex, portMAX_DELAY) == pdTRUE) {
-        for (int i = 0; i < MAX_UART_HANDLERS; i++) {
-            if (data_handlers[i] == NULL) {
-                data_handlers[i] = handler;
-                ESP_LOGI("UART_UTILS", "Handler registrado en slot %d: %p", i, (void *)handler);
-                registered = true;
-                break;
-            }
+        dispatch_table_t *current = atomic_load_explicit(&active_table, memory_order_acquire);
+        if (current->bin[type] == NULL) {
+            dispatch_table_t *next = dispatch_begin_update();
+            next->bin[type] = handler;
+            dispatch_publish(next);
+            registered = true;
         }
         xSemaphoreGive(handlers_mutex);
     }
 
     if (!registered) {
-        ESP_LOGW("UART_UTILS", "No se pudo registrar el handler, máximo alcanzado");
+        ESP_LOGW("UART_UTILS", "Ya hay un handler para el tipo binario %d", type);
     }
     return registered;
 }
 
-bool uart_unregister_handler(uart_data_handler_t handler) {
+bool uart_register_handler(const char *prefix, uart_data_handler_t handler) {
     if (handlers_mutex == NULL) {
         ESP_LOGE("UART_UTILS", "handlers_mutex not initialized");
         return false;
     }
+    size_t len = strlen(prefix);
+    if (len == 0 || len > UART_PREFIX_MAX_LEN || strchr(prefix, ':') != NULL) {
+        ESP_LOGE("UART_UTILS", "Prefijo inválido: '%s'", prefix);
+        return false;
+    }
+
+    bool registered = false;
+    if (xSemaphoreTake(handlers_mutex, portMAX_DELAY) == pdTRUE) {
+        dispatch_table_t *current = atomic_load_explicit(&active_table, memory_order_acquire);
+        if (current->count < MAX_UART_HANDLERS && table_find(current, prefix, len) == NULL) {
+            dispatch_table_t *next = dispatch_begin_update();
+            table_insert(next, prefix, len, handler);
+            dispatch_publish(next);
+            ESP_LOGI("UART_UTILS", "Handler registrado para '%s': %p", prefix, (void *)handler);
+            registered = true;
+        }
+        xSemaphoreGive(handlers_mutex);
+    }
+
+    if (!registered) {
+        ESP_LOGW("UART_UTILS", "No se pudo registrar el handler para '%s' (duplicado o máximo alcanzado)", prefix);
+    }
+    return registered;
+}
+
+bool uart_unregister_handler(const char *prefix) {
+    if (handlers_mutex == NULL) {
+        ESP_LOGE("UART_UTILS", "handlers_mutex not initialized");
+        return false;
+    }
+    size_t len = strlen(prefix);
 
     bool unregistered = false;
     if (xSemaphoreTake(handlers_mutex, portMAX_DELAY) == pdTRUE) {
-        for (int i = 0; i < MAX_UART_HANDLERS; i++) {
-            if (data_handlers[i] == handler) {
-                data_handlers[i] = NULL;
-                ESP_LOGI("UART_UTILS", "Handler desregistrado del slot %d: %p", i, (void *)handler);
-                unregistered = true;
-                break;
+        dispatch_table_t *current = atomic_load_explicit(&active_table, memory_order_acquire);
+        if (len <= UART_PREFIX_MAX_LEN && table_find(current, prefix, len) != NULL) {
+            // Reconstruir sin la entrada: el sondeo lineal no admite huecos
+            dispatch_table_t *next = dispatch_begin_update();
+            memset(next->slots, 0, sizeof(next->slots));
+            next->count = 0;
+            for (int i = 0; i < DISPATCH_SLOTS; i++) {
+                const dispatch_entry_t *entry = &current->slots[i];
+                if (entry->len != 0 && !(entry->len == len && memcmp(entry->prefix, prefix, len) == 0)) {
+                    table_insert(next, entry->prefix, entry->len, entry->handler);
+                }
             }
+            dispatch_publish(next);
+            ESP_LOGI("UART_UTILS", "Handler desregistrado para '%s'", prefix);
+            unregistered = true;
         }
         xSemaphoreGive(handlers_mutex);
     }
 
     if (!unregistered) {
-        ESP_LOGW("UART_UTILS", "Handler no encontrado para desregistrar: %p", (void *)handler);
+        ESP_LOGW("UART_UTILS", "Handler no encontrado para desregistrar: '%s'", prefix);
     }
     return unregistered;
 }
 
-void send_command(const char *command) {
-    uart_write_bytes(UART_PORT_NUM, command, strlen(command));
-    ESP_LOGI("UART", "Enviado: %s", command);
+void uart_get_rx_stats(uart_rx_stats_t *out) {
+    if (out != NULL) {
+        *out = rx_stats;
+    }
 }
 
-void uart_receive_task(void *arg) {
-    char rx_buffer[128];
-    const TickType_t delay_ticks = pdMS_TO_TICKS(100);
+static void copy_queue_stats(const frame_queue_t *queue, uart_queue_stats_t *out) {
+    out->depth = queue->mask + 1;
+    out->enqueued = queue->enqueued;
+    out->dropped = queue->dropped;
+    out->high_water = queue->high_water;
+}
+
+void uart_get_queue_stats(uart_queue_stats_t *telemetry, uart_queue_stats_t *control) {
+    if (telemetry != NULL) {
+        copy_queue_stats(&telemetry_queue, telemetry);
+    }
+    if (control != NULL) {
+        copy_queue_stats(&control_queue, control);
+    }
+}
+
+// Contabiliza una trama y su latencia desde el evento del driver
+static uint32_t record_dispatch(int64_t t_event) {
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - t_event);
+    rx_stats.frames++;
+    rx_stats.latency_last_us = latency;
+    rx_stats.latency_total_us += latency;
+    if (latency > rx_stats.latency_max_us) {
+        rx_stats.latency_max_us = latency;
+    }
+    return latency;
+}
+
+// Entrega la trama al handler de su prefijo: una búsqueda en la tabla, sin mutex
+static void dispatch_frame(const char *frame, int64_t t_event) {
+    uint32_t latency = record_dispatch(t_event);
+
+    size_t len = frame_prefix_len(frame);
+    if (len == 0) {
+        return;
+    }
+    dispatch_table_t *table = dispatch_acquire();
+    dispatch_entry_t *entry = table_find(table, frame, len);
+    if (entry != NULL) {
+        entry->handler(frame);
+    }
+    dispatch_release(table);
+    TRACE(DISPATCH, len, latency, entry != NULL);
+}
 
-    static char temp_buffer[UART_RX_BUFFER_SIZE];
-    static int temp_index = 0;
+// Decodifica una trama binaria; el texto encapsulado sigue el camino ASCII
+static void dispatch_binary_frame(const frame_slot_t *frame, int64_t t_event) {
+    static uint8_t work[TP_MAX_RAW + 1];
+    tp_msg_t msg;
+
+    tp_result_t res = tp_decode((const uint8_t *)frame->data, frame->len, work, &msg);
+    if (res != TP_OK) {
+        rx_stats.decode_errors++;
+        TRACE(RX_DECODE_ERR, res, frame->len, 0);
+        return;
+    }
+    if (msg.type == TP_MSG_TEXT) {
+        dispatch_frame(msg.text.str, t_event);
+        return;
+    }
+
+    uint32_t latency = record_dispatch(t_event);
+
+    dispatch_table_t *table = dispatch_acquire();
+    uart_bin_handler_t handler = table->bin[msg.type];
+    if (handler != NULL) {
+        handler(&msg);
+    }
+    dispatch_release(table);
+    TRACE(DISPATCH_BIN, msg.type, latency, handler != NULL);
+}
+
+// Tipo binario de una trama COBS sin decodificarla: si el primer código es 1,
+// el primer byte en claro es 0x00 (TP_MSG_TEXT)
+static uint8_t binary_frame_type(const line_frame_t *frame) {
+    const uint8_t *raw = (const uint8_t *)frame->data;
+    return (frame->len >= 2 && raw[0] > 1) ? raw[1] : TP_MSG_TEXT;
+}
+
+// La telemetría periódica puede perder tramas antiguas (un delta perdido se
+// recupera pidiendo una keyframe); todo lo demás (respuestas de ajustes, ACK...)
+// va a la cola que nunca descarta
+static bool is_telemetry_frame(const line_frame_t *frame) {
+    if (binary_mode) {
+        uint8_t type = binary_frame_type(frame);
+        return type == TP_MSG_DATA || type == TP_MSG_DELTA;
+    }
+    return strncmp(frame->data, "DATA:", 5) == 0 || strncmp(frame->data, "DLT:", 4) == 0;
+}
+
+// Copia la trama a la cola correspondiente y despierta al parser
+static void enqueue_frame(const line_frame_t *frame, int64_t t_event) {
+    bool telemetry = is_telemetry_frame(frame);
+    frame_queue_t *queue = telemetry ? &telemetry_queue : &control_queue;
+    frame_slot_t *slot;
+
+    TRACE(RX_FRAME, frame->len, telemetry, binary_mode);
+    while ((slot = frame_queue_prepare(queue)) == NULL) {
+        // Cola NEVER_DROP llena, o slot aún en lectura: esperar al parser; los
+        // bytes se acumulan en el driver
+        rx_stats.queue_stalls++;
+        TRACE(RX_QUEUE_STALL, rx_stats.queue_stalls, 0, 0);
+        xTaskNotifyGive(parser_task_handle);
+        vTaskDelay(1);
+    }
+    slot->t_event = t_event;
+    slot->binary = binary_mode;
+    slot->len = frame->len;
+    memcpy(slot->data, frame->data, frame->len + 1);
+    frame_queue_publish(queue);
+    rx_stats.frames_enqueued++;
+
+    xTaskNotifyGive(parser_task_handle);
+}
+
+// Vacía todo lo que el driver tenga almacenado directamente en el ring del framer
+// y encola cada trama completa para la tarea parser
+static void drain_rx_buffer(int64_t t_event) {
+    size_t buffered = 0;
+
+    uart_get_buffered_data_len(UART_PORT_NUM, &buffered);
+    while (buffered > 0) {
+        char *dst;
+        size_t room = line_framer_write_ptr(&rx_framer, &dst);
+        size_t chunk = buffered < room ? buffered : room;
+        int length = uart_read_bytes(UART_PORT_NUM, (uint8_t *)dst, chunk, 0);
+        if (length <= 0) {
+            break;
+        }
+        line_framer_commit(&rx_framer, length);
+        rx_stats.bytes += length;
+        buffered -= length;
+        TRACE(RX_DRAIN, length, buffered, 0);
+
+        line_frame_t frame;
+        while (line_framer_next(&rx_framer, &frame)) {
+            if (frame.len > 0 && !link_take_reply(&frame)) {
+                enqueue_frame(&frame, t_event);
+            }
+        }
+        rx_stats.framer_overflows = rx_framer.overflows;
+    }
+}
+
+void uart_parser_task(void *arg) {
+    static frame_slot_t frame;
 
     while (true) {
-        int length = uart_read_bytes(UART_PORT_NUM, (uint8_t *)rx_buffer, sizeof(rx_buffer) - 1, pdMS_TO_TICKS(1000));
-        if (length > 0) {
-            rx_buffer[length] = '\0'; // Asegurar terminación de cadena
-            ESP_LOGI("UART", "Recibido fragmento: %s", rx_buffer);
-
-            // Ensamblar datos en el buffer temporal
-            if (temp_index + length < sizeof(temp_buffer) - 1) {
-                memcpy(&temp_buffer[temp_index], rx_buffer, length);
-                temp_index += length;
-                temp_buffer[temp_index] = '\0';
-
-                // Procesar cada trama completa separada por '\n'
-                char *start = temp_buffer;
-                char *newline = NULL;
-
-                while ((newline = strchr(start, '\n')) != NULL) {
-                    *newline = '\0'; // Terminar la subtrama en el delimitador
-                    ESP_LOGI("UART", "Trama completa procesada: %s", start);
-
-                    // Llamar a los handlers registrados con la subtrama
-                    if (handlers_mutex != NULL) {
-                        if (xSemaphoreTake(handlers_mutex, portMAX_DELAY) == pdTRUE) {
-                            for (int i = 0; i < MAX_UART_HANDLERS; i++) {
-                                if (data_handlers[i] != NULL) {
-                                    ESP_LOGI("UART_UTILS", "Llamando al handler en slot %d: %p", i, (void *)data_handlers[i]);
-                                    data_handlers[i](start);
-                                }
-                            }
-                            xSemaphoreGive(handlers_mutex);
-                        }
-                    }
-
-                    // Avanzar al inicio de la siguiente subtrama
-                    start = newline + 1;
-                }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 
-                // Mover datos no procesados al inicio del buffer temporal
-                if (*start != '\0') {
-                    int remaining = strlen(start);
-                    memmove(temp_buffer, start, remaining);
-                    temp_index = remaining;
-                    temp_buffer[temp_index] = '\0';
+        // Las respuestas de control tienen prioridad sobre la telemetría
+        bool pending = true;
+        while (pending) {
+            pending = false;
+            while (frame_queue_pop(&control_queue, &frame)) {
+                pending = true;
+                if (frame.binary) {
+                    dispatch_binary_frame(&frame, frame.t_event);
                 } else {
-                    temp_index = 0;
+                    dispatch_frame(frame.data, frame.t_event);
                 }
-            } else {
-                ESP_LOGE("UART", "Overflow en el buffer temporal, reiniciando");
-                temp_index = 0; // Reiniciar el buffer temporal si ocurre un overflow
+            }
+            if (frame_queue_pop(&telemetry_queue, &frame)) {
+                pending = true;
+                if (frame.binary) {
+                    dispatch_binary_frame(&frame, frame.t_event);
+                } else {
+                    dispatch_frame(frame.data, frame.t_event);
+                }
+            }
+        }
+    }
+}
+
+void uart_receive_task(void *arg) {
+    uart_event_t event;
+
+    // El handle de uart_parser_task llega como argumento para no depender del orden de arranque
+    parser_task_handle = (TaskHandle_t)arg;
+    link_start();
+
+    while (true) {
+        if (link_state != LINK_IDLE && esp_timer_get_time() >= link_deadline) {
+            link_on_timeout();
+        }
+        if (xQueueReceive(uart_event_queue, &event, link_wait()) != pdTRUE) {
+            continue;
+        }
+        int64_t t_event = esp_timer_get_time();
+
+        switch (event.type) {
+        case UART_PATTERN_DET:
+            // La posición sólo sirve para mantener sincronizada la cola de patrones;
+            // drain_rx_buffer lee todo lo disponible y el ensamblador separa las tramas
+            uart_pattern_pop_pos(UART_PORT_NUM);
+            drain_rx_buffer(t_event);
+            break;
+        case UART_DATA:
+            // RX-timeout o FIFO lleno: fragmento sin terminador todavía
+            drain_rx_buffer(t_event);
+            break;
+        case UART_FIFO_OVF:
+            rx_stats.fifo_overflows++;
+            ESP_LOGW("UART", "Overflow del FIFO hardware");
+            uart_flush_input(UART_PORT_NUM);
+            xQueueReset(uart_event_queue);
+            uart_pattern_queue_reset(UART_PORT_NUM, UART_PATTERN_QUEUE_LEN);
+            break;
+        case UART_BUFFER_FULL:
+            rx_stats.buffer_full++;
+            ESP_LOGW("UART", "Ring buffer del driver lleno");
+            uart_flush_input(UART_PORT_NUM);
+            xQueueReset(uart_event_queue);
+            uart_pattern_queue_reset(UART_PORT_NUM, UART_PATTERN_QUEUE_LEN);
+            break;
+        case UART_BREAK:
+            rx_stats.breaks++;
+            break;
+        case UART_PARITY_ERR:
+            rx_stats.parity_errors++;
+            break;
+        case UART_FRAME_ERR:
+            rx_stats.frame_errors++;
+            break;
+        default:
+            break;
+        }
+
+        if (link_state == LINK_IDLE && link_stats.baud != UART_BAUD_RATE) {
+            // Ventana de vigilancia: errores o bytes sin ninguna trama válida indican que
+            // el controlador ya no está a la velocidad negociada. El silencio no cuenta:
+            // sin eventos no se llega aquí.
+            if (rx_stats.frames_enqueued != link_frames_seen) {
+                link_frames_seen = rx_stats.frames_enqueued;
+                link_frame_errors = rx_stats.frame_errors;
+                link_garbage_since = 0;
+            } else if (rx_stats.frame_errors - link_frame_errors >= UART_LINK_ERROR_BURST) {
+                link_fallback("errores de trama");
+            } else if (link_garbage_since == 0) {
+                link_garbage_since = t_event;
+            } else if (t_event - link_garbage_since > UART_LINK_GARBAGE_MS * 1000LL) {
+                link_fallback("bytes sin tramas válidas");
             }
         }
-        vTaskDelay(delay_ticks);
     }
 }
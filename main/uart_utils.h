@@ -4,23 +4,84 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "telemetry_proto.h"
 
 // Definición del tipo de handler
 typedef void (*uart_data_handler_t)(const char *);
 
-// Función para inicializar UART Utils
+#define UART_PREFIX_MAX_LEN 15 // Longitud máxima de un prefijo registrable
+
+// Handler de mensajes binarios ya decodificados y verificados por CRC
+typedef void (*uart_bin_handler_t)(const tp_msg_t *);
+
+// Contadores del camino de recepción
+typedef struct {
+    uint32_t frames;            // Tramas completas despachadas
+    uint32_t frames_enqueued;   // Tramas completas entregadas por el framer
+    uint32_t bytes;             // Bytes leídos del driver
+    uint32_t fifo_overflows;    // Eventos UART_FIFO_OVF
+    uint32_t buffer_full;       // Eventos UART_BUFFER_FULL (ring buffer del driver lleno)
+    uint32_t breaks;            // Eventos UART_BREAK
+    uint32_t parity_errors;     // Eventos UART_PARITY_ERR
+    uint32_t frame_errors;      // Eventos UART_FRAME_ERR
+    uint32_t framer_overflows;  // Tramas descartadas por exceder el buffer de ensamblado
+    uint32_t decode_errors;     // Tramas binarias rechazadas (COBS, CRC, tipo, longitud)
+    uint32_t queue_stalls;      // Esperas del RX por la cola de control llena
+    uint32_t latency_last_us;   // Latencia evento RX -> despacho de la última trama
+    uint32_t latency_max_us;    // Latencia máxima observada
+    uint64_t latency_total_us;  // Suma de latencias (media = total / frames)
+} uart_rx_stats_t;
+
+// Estado de la negociación del enlace
+typedef struct {
+    uint32_t baud;                  // Velocidad actual del enlace
+    uint32_t negotiations;          // Negociaciones iniciadas (arranque + renegociaciones)
+    uint32_t negotiation_failures;  // Ninguna velocidad superior funcionó
+    uint32_t verify_failures;       // Patrón de prueba no recibido tras cambiar de velocidad
+    uint32_t fallbacks;             // Vueltas a UART_BAUD_RATE por errores o bytes sin tramas
+    bool sequenced;                 // El controlador anunció CAPS:SEQ (comandos con #seq y ACK)
+} uart_link_stats_t;
+
+// Contadores de una cola de tramas RX -> parser
+typedef struct {
+    uint32_t depth;
+    uint32_t enqueued;
+    uint32_t dropped;       // Tramas antiguas descartadas (sólo telemetría)
+    uint32_t high_water;    // Ocupación máxima observada
+} uart_queue_stats_t;
+
+// Función para inicializar UART Utils (instala el driver con cola de eventos)
 bool uart_utils_init(void);
 
-// Función para registrar un handler
-bool uart_register_handler(uart_data_handler_t handler);
+// Registra el handler de las tramas cuyo prefijo (texto antes de ':') coincide,
+// p. ej. "DATA" o "SETTINGS". Un handler por prefijo; el despacho es O(1).
+bool uart_register_handler(const char *prefix, uart_data_handler_t handler);
 
-// Función para desregistrar un handler
-bool uart_unregister_handler(uart_data_handler_t handler);
+// Desregistra el handler de un prefijo
+bool uart_unregister_handler(const char *prefix);
 
-// Función para enviar comandos
-void send_command(const char *command);
+// Registra el handler de un tipo de mensaje binario (uno por tipo)
+bool uart_register_bin_handler(tp_msg_type_t type, uart_bin_handler_t handler);
 
-// Declaración de la tarea de recepción UART
+// true si el controlador aceptó el protocolo binario en la última negociación
+bool uart_utils_binary_mode(void);
+
+// Velocidad negociada del enlace y sus contadores
+uint32_t uart_link_get_baud(void);
+void uart_get_link_stats(uart_link_stats_t *out);
+
+// Copia los contadores de recepción
+void uart_get_rx_stats(uart_rx_stats_t *out);
+
+// Copia los contadores de las colas de telemetría y de control
+void uart_get_queue_stats(uart_queue_stats_t *telemetry, uart_queue_stats_t *control);
+
+// Declaración de la tarea de recepción UART: ensambla tramas y las encola, y lleva
+// la negociación del enlace (velocidad y protocolo) sin bloquearse.
+// arg: TaskHandle_t de uart_parser_task.
 void uart_receive_task(void *arg);
 
+// Tarea que decodifica las tramas encoladas y llama a los handlers
+void uart_parser_task(void *arg);
+
 #endif // UART_UTILS_H
@@ -0,0 +1,55 @@
+#include "ui_format.h"
+
+static size_t append(char *buf, size_t size, size_t len, const char *text) {
+    while (*text != '\0' && len + 1 < size) {
+        buf[len++] = *text++;
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+size_t ui_fmt_fixed(char *buf, size_t size, int32_t value, unsigned decimals) {
+    char digits[24];    // Hasta 9 decimales + punto + 10 dígitos enteros, al revés
+    size_t n = 0;
+    // Magnitud en uint32 para que INT32_MIN no desborde
+    uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+
+    if (size == 0) {
+        return 0;
+    }
+    if (decimals > 9) {
+        decimals = 9;
+    }
+    for (unsigned i = 0; i < decimals; i++) {
+        digits[n++] = (char)('0' + mag % 10);
+        mag /= 10;
+    }
+    if (decimals > 0) {
+        digits[n++] = '.';
+    }
+    do {
+        digits[n++] = (char)('0' + mag % 10);
+        mag /= 10;
+    } while (mag != 0);
+
+    size_t len = 0;
+    if (value < 0 && len + 1 < size) {
+        buf[len++] = '-';
+    }
+    while (n > 0 && len + 1 < size) {
+        buf[len++] = digits[--n];
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+size_t ui_fmt_label(char *buf, size_t size, const char *prefix, int32_t value,
+                    unsigned decimals, const char *suffix) {
+    if (size == 0) {
+        return 0;
+    }
+    buf[0] = '\0';
+    size_t len = prefix != NULL ? append(buf, size, 0, prefix) : 0;
+    len += ui_fmt_fixed(buf + len, size - len, value, decimals);
+    return suffix != NULL ? append(buf, size, len, suffix) : len;
+}
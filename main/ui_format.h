@@ -0,0 +1,23 @@
+// ui_format.h
+#ifndef UI_FORMAT_H
+#define UI_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Formateo de enteros y punto fijo para etiquetas, sin printf ni float.
+// Escriben como mucho size - 1 caracteres más el terminador y devuelven la
+// longitud escrita. Sin dependencias de ESP-IDF.
+
+// "-12.05" para value = -1205, decimals = 2
+size_t ui_fmt_fixed(char *buf, size_t size, int32_t value, unsigned decimals);
+
+static inline size_t ui_fmt_int(char *buf, size_t size, int32_t value) {
+    return ui_fmt_fixed(buf, size, value, 0);
+}
+
+// Concatena prefijo + número en punto fijo + sufijo: "T1: " "23.50" " °C"
+size_t ui_fmt_label(char *buf, size_t size, const char *prefix, int32_t value,
+                    unsigned decimals, const char *suffix);
+
+#endif // UI_FORMAT_H
@@ -0,0 +1,13 @@
+// Pantallas de la aplicación: SCREEN(id, nombre, función de creación, fija)
+//   fija     se crea al arrancar y nunca se descarta (la principal lleva los
+//            observadores de la telemetría)
+//   el resto se crea en la primera visita y screen_manager puede descartarla
+//            si las creadas superan SCREEN_MEM_BUDGET; su estado vive en los
+//            servicios (settings_store, alarm_log, telemetry_store), así que
+//            al recrearla se ve igual
+// El orden no importa salvo la primera, que es la de inicio.
+
+SCREEN(MAIN,     "principal", create_main_screen,      true)
+SCREEN(SETTINGS, "ajustes",   create_settings_screen,  false)
+SCREEN(ALARMS,   "alarmas",   create_alarm_log_screen, false)
+SCREEN(TRENDS,   "gráficas",  create_trend_screen,     false)
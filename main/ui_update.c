@@ -0,0 +1,103 @@
+#include "ui_update.h"
+#include <string.h>
+#include "trace.h"
+
+static ui_update_hook_t hooks[UI_UPDATE_MAX_HOOKS];
+static int hook_count;
+
+// Sólo se tocan desde el contexto de LVGL
+static ui_update_stats_t totals;
+static ui_update_stats_t window_start_totals;
+static ui_update_stats_t last_second;
+static uint32_t window_start_ms;
+
+static void update_rates(void) {
+    if (lv_tick_elaps(window_start_ms) < 1000) {
+        return;
+    }
+    last_second.commits = totals.commits - window_start_totals.commits;
+    last_second.widget_updates = totals.widget_updates - window_start_totals.widget_updates;
+    last_second.widget_skipped = totals.widget_skipped - window_start_totals.widget_skipped;
+    last_second.pixels_invalidated = totals.pixels_invalidated - window_start_totals.pixels_invalidated;
+    last_second.pixels_skipped = totals.pixels_skipped - window_start_totals.pixels_skipped;
+    window_start_totals = totals;
+    window_start_ms = lv_tick_get();
+    if (last_second.widget_updates != 0 || last_second.widget_skipped != 0) {
+        TRACE(UI_STATS, last_second.widget_updates, last_second.widget_skipped, last_second.pixels_skipped);
+    }
+}
+
+static void refr_start_cb(lv_event_t *e) {
+    bool applied = false;
+    for (int i = 0; i < hook_count; i++) {
+        applied |= hooks[i]();
+    }
+    if (applied) {
+        totals.commits++;
+    }
+    update_rates();
+}
+
+static void invalidate_cb(lv_event_t *e) {
+    const lv_area_t *area = lv_event_get_param(e);
+    if (area != NULL) {
+        totals.pixels_invalidated += lv_area_get_size(area);
+    }
+}
+
+void ui_update_init(lv_display_t *disp) {
+    window_start_ms = lv_tick_get();
+    lv_display_add_event_cb(disp, refr_start_cb, LV_EVENT_REFR_START, NULL);
+    lv_display_add_event_cb(disp, invalidate_cb, LV_EVENT_INVALIDATE_AREA, NULL);
+}
+
+bool ui_update_register(ui_update_hook_t hook) {
+    if (hook_count >= UI_UPDATE_MAX_HOOKS) {
+        return false;
+    }
+    hooks[hook_count++] = hook;
+    return true;
+}
+
+void ui_update_note_skipped(lv_obj_t *obj) {
+    lv_area_t coords;
+    totals.widget_skipped++;
+    if (obj != NULL) {
+        lv_obj_get_coords(obj, &coords);
+        totals.pixels_skipped += lv_area_get_size(&coords);
+    }
+}
+
+bool ui_label_set_text_if_changed(lv_obj_t *label, const char *text) {
+    const char *current = lv_label_get_text(label);
+    if (current != NULL && strcmp(current, text) == 0) {
+        ui_update_note_skipped(label);
+        return false;
+    }
+    lv_label_set_text(label, text);
+    totals.widget_updates++;
+    return true;
+}
+
+bool ui_obj_set_state_if_changed(lv_obj_t *obj, lv_state_t state, bool on) {
+    if (lv_obj_has_state(obj, state) == on) {
+        ui_update_note_skipped(obj);
+        return false;
+    }
+    if (on) {
+        lv_obj_add_state(obj, state);
+    } else {
+        lv_obj_remove_state(obj, state);
+    }
+    totals.widget_updates++;
+    return true;
+}
+
+void ui_update_get_stats(ui_update_stats_t *total, ui_update_stats_t *per_second) {
+    if (total != NULL) {
+        *total = totals;
+    }
+    if (per_second != NULL) {
+        *per_second = last_second;
+    }
+}
@@ -0,0 +1,46 @@
+// ui_update.h
+#ifndef UI_UPDATE_H
+#define UI_UPDATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lvgl.h"
+
+// Planificador de actualizaciones de la UI. Las tareas de datos sólo marcan
+// cambios; los hooks registrados aplican todo lo pendiente una vez por
+// refresco del display (LV_EVENT_REFR_START), justo antes de redibujar, de
+// modo que varias tramas entre dos refrescos cuestan una sola actualización.
+// Los widgets sólo se tocan si su texto o estado cambia de verdad.
+
+#define UI_UPDATE_MAX_HOOKS 8
+
+// Se ejecuta en el contexto de LVGL al comienzo de cada refresco; true si aplicó cambios
+typedef bool (*ui_update_hook_t)(void);
+
+typedef struct {
+    uint32_t commits;           // Refrescos en los que algún hook aplicó cambios
+    uint32_t widget_updates;    // Widgets modificados
+    uint32_t widget_skipped;    // Actualizaciones descartadas por no cambiar nada
+    uint32_t pixels_invalidated;// Píxeles invalidados en el display
+    uint32_t pixels_skipped;    // Píxeles que se habrían invalidado sin la comparación
+} ui_update_stats_t;
+
+// Engancha el planificador al display (contexto de LVGL o con su lock)
+void ui_update_init(lv_display_t *disp);
+
+// Añade un hook; false si no quedan huecos
+bool ui_update_register(ui_update_hook_t hook);
+
+// Cambia el texto sólo si es distinto del actual. true si se modificó.
+bool ui_label_set_text_if_changed(lv_obj_t *label, const char *text);
+
+// Marca o desmarca un estado sólo si hace falta. true si se modificó.
+bool ui_obj_set_state_if_changed(lv_obj_t *obj, lv_state_t state, bool on);
+
+// Cuenta una actualización descartada de un widget (p. ej. por valor de subject igual)
+void ui_update_note_skipped(lv_obj_t *obj);
+
+// Totales acumulados y tasas del último segundo completo
+void ui_update_get_stats(ui_update_stats_t *total, ui_update_stats_t *per_second);
+
+#endif // UI_UPDATE_H
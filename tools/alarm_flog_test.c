@@ -0,0 +1,260 @@
+// alarm_flog_test.c - Pruebas en el PC del log de alarmas en flash del firmware
+//
+// Compilar:  cc -O2 -Wall -I../main -o alarm_flog_test alarm_flog_test.c ../main/alarm_flog.c
+//               ../main/telemetry_proto.c
+//
+// Uso:  alarm_flog_test
+//
+// La flash es un array en memoria que se comporta como NOR: borrar pone el
+// sector a 0xFF y escribir sólo puede bajar bits (si se escribe dos veces en
+// el mismo sitio sin borrar, el registro sale mal). Varias vueltas a todos los
+// sectores con remontajes entre medias, recuperación de la cabecera y del
+// hueco libre, y un último registro escrito a medias.
+#include <stdio.h>
+#include <string.h>
+#include "alarm_flog.h"
+
+#define SECTOR_SIZE 256     // 15 registros por sector
+#define SECTOR_COUNT 4
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FALLO %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);            \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+// ---- Flash simulada ----
+
+static uint8_t flash[SECTOR_SIZE * SECTOR_COUNT];
+static uint32_t sector_erases[SECTOR_COUNT];
+static uint32_t overwrites;         // Escrituras sobre bytes no borrados
+static size_t torn_bytes;           // Si no es 0, la siguiente escritura se corta ahí
+
+static bool sim_read(void *ctx, uint32_t offset, void *buf, size_t len) {
+    (void)ctx;
+    if (offset + len > sizeof(flash)) {
+        return false;
+    }
+    memcpy(buf, flash + offset, len);
+    return true;
+}
+
+static bool sim_write(void *ctx, uint32_t offset, const void *buf, size_t len) {
+    (void)ctx;
+    if (offset + len > sizeof(flash)) {
+        return false;
+    }
+    if (torn_bytes != 0 && torn_bytes < len) {
+        len = torn_bytes;       // Corte de alimentación a mitad de escritura
+        torn_bytes = 0;
+    }
+    const uint8_t *src = buf;
+    for (size_t i = 0; i < len; i++) {
+        if (flash[offset + i] != 0xFF) {
+            overwrites++;
+        }
+        flash[offset + i] &= src[i];
+    }
+    return true;
+}
+
+static bool sim_erase(void *ctx, uint32_t offset, size_t len) {
+    (void)ctx;
+    if (offset % SECTOR_SIZE != 0 || len != SECTOR_SIZE || offset + len > sizeof(flash)) {
+        return false;
+    }
+    memset(flash + offset, 0xFF, len);
+    sector_erases[offset / SECTOR_SIZE]++;
+    return true;
+}
+
+static const flash_io_t io = {
+    .read = sim_read,
+    .write = sim_write,
+    .erase = sim_erase,
+    .ctx = NULL,
+    .sector_size = SECTOR_SIZE,
+    .sector_count = SECTOR_COUNT,
+};
+
+// ---- Lectura del log ----
+
+typedef struct {
+    uint32_t count;
+    uint32_t first;
+    uint32_t last;
+    uint32_t gaps;      // Registros fuera de orden o con saltos
+} walk_t;
+
+static void walk_cb(const alarm_event_t *event, void *ctx) {
+    walk_t *w = ctx;
+    if (w->count == 0) {
+        w->first = event->seq;
+    } else if (event->seq != w->last + 1) {
+        w->gaps++;
+    }
+    w->last = event->seq;
+    w->count++;
+}
+
+static walk_t walk(alarm_flog_t *log) {
+    walk_t w = {0};
+    uint32_t n = alarm_flog_for_each(log, walk_cb, &w);
+    CHECK(n == w.count, "for_each devolvió %u y entregó %u", (unsigned)n, (unsigned)w.count);
+    return w;
+}
+
+static uint32_t next_seq = 1;
+
+static bool append(alarm_flog_t *log, uint16_t boot) {
+    alarm_event_t event = {
+        .seq = next_seq,
+        .uptime_ms = next_seq * 10,
+        .boot = boot,
+        .bit = (uint16_t)(next_seq % 64),
+        .edge = (uint8_t)(next_seq & 1),
+    };
+    if (!alarm_flog_append(log, &event)) {
+        return false;
+    }
+    next_seq++;
+    return true;
+}
+
+// ---- Pruebas ----
+
+// Flash recién borrada: se prepara el primer sector y queda vacío
+static void test_blank(void) {
+    alarm_flog_t log;
+    memset(flash, 0xFF, sizeof(flash));
+    CHECK(alarm_flog_mount(&log, &io), "no monta la flash borrada");
+    CHECK(log.head_sector == 0 && log.head_slot == 1, "cabeza en %u/%u", (unsigned)log.head_sector,
+          (unsigned)log.head_slot);
+    CHECK(alarm_flog_capacity(&log) == (SECTOR_SIZE / 16 - 1) * SECTOR_COUNT, "capacidad %u",
+          (unsigned)alarm_flog_capacity(&log));
+    walk_t w = walk(&log);
+    CHECK(w.count == 0, "%u registros en la flash borrada", (unsigned)w.count);
+}
+
+// Varias vueltas a los sectores, remontando cada pocos registros como si el
+// equipo se reiniciara: la cabeza se recupera donde estaba y el log conserva
+// los registros más recientes, en orden y sin huecos
+static void test_wraparound_remount(void) {
+    alarm_flog_t log;
+    CHECK(alarm_flog_mount(&log, &io), "no monta");
+    uint32_t capacity = alarm_flog_capacity(&log);
+    uint32_t per_sector = SECTOR_SIZE / 16 - 1;
+
+    for (uint16_t boot = 1; next_seq <= 5 * capacity; boot++) {
+        // Un número de registros que no es múltiplo del sector: la cabeza queda en
+        // mitad de un sector y a veces justo al final
+        uint32_t batch = boot % 3 == 0 ? per_sector : 7u + boot % 5u;
+        for (uint32_t i = 0; i < batch; i++) {
+            CHECK(append(&log, boot), "falla el registro %u", (unsigned)next_seq);
+        }
+        uint32_t head_sector = log.head_sector, head_slot = log.head_slot, head_counter = log.head_counter;
+
+        CHECK(alarm_flog_mount(&log, &io), "no remonta en el arranque %u", (unsigned)boot);
+        CHECK(log.head_sector == head_sector && log.head_slot == head_slot && log.head_counter == head_counter,
+              "arranque %u: cabeza %u/%u (%u), se esperaba %u/%u (%u)", (unsigned)boot, (unsigned)log.head_sector,
+              (unsigned)log.head_slot, (unsigned)log.head_counter, (unsigned)head_sector, (unsigned)head_slot,
+              (unsigned)head_counter);
+
+        walk_t w = walk(&log);
+        uint32_t written = next_seq - 1;
+        // Al preparar un sector se pierde entero el más antiguo
+        uint32_t min_kept = written < capacity - per_sector ? written : capacity - per_sector;
+        CHECK(w.last == written && w.gaps == 0 && w.count >= min_kept && w.count <= capacity &&
+                  w.first == written - w.count + 1,
+              "arranque %u: %u registros %u..%u, %u saltos (escritos %u)", (unsigned)boot, (unsigned)w.count,
+              (unsigned)w.first, (unsigned)w.last, (unsigned)w.gaps, (unsigned)written);
+        CHECK(log.stats.corrupt == 0, "arranque %u: %u registros corruptos", (unsigned)boot,
+              (unsigned)log.stats.corrupt);
+    }
+
+    // Todos los sectores se han borrado, y por igual (±1)
+    uint32_t min = sector_erases[0], max = sector_erases[0];
+    for (int s = 1; s < SECTOR_COUNT; s++) {
+        min = sector_erases[s] < min ? sector_erases[s] : min;
+        max = sector_erases[s] > max ? sector_erases[s] : max;
+    }
+    CHECK(min >= 4 && max - min <= 1, "borrados por sector entre %u y %u", (unsigned)min, (unsigned)max);
+    CHECK(overwrites == 0, "%u bytes escritos sin borrar", (unsigned)overwrites);
+}
+
+// Corte a mitad del último registro: al remontar se salta (cuenta como
+// corrupto), su hueco no se reutiliza y el log sigue a continuación
+static void test_torn_record(void) {
+    alarm_flog_t log;
+    CHECK(alarm_flog_mount(&log, &io), "no monta");
+    // Que el registro cortado no sea el último del sector
+    while (log.head_slot + 2 >= SECTOR_SIZE / 16) {
+        CHECK(append(&log, 100), "falla el registro %u", (unsigned)next_seq);
+    }
+    uint32_t good = next_seq - 1;
+    uint32_t torn_slot = log.head_slot;
+
+    torn_bytes = 6;
+    CHECK(append(&log, 100), "falla el registro cortado");
+    uint32_t torn = next_seq - 1;
+
+    CHECK(alarm_flog_mount(&log, &io), "no remonta tras el corte");
+    CHECK(log.head_slot == torn_slot + 1, "cabeza en el hueco %u, se esperaba %u", (unsigned)log.head_slot,
+          (unsigned)(torn_slot + 1));
+    walk_t w = walk(&log);
+    CHECK(w.last == good && w.gaps == 0 && log.stats.corrupt == 1, "último %u, %u saltos, %u corruptos",
+          (unsigned)w.last, (unsigned)w.gaps, (unsigned)log.stats.corrupt);
+
+    // Lo siguiente se escribe detrás del registro cortado, sin pisarlo
+    next_seq = torn + 1;
+    CHECK(append(&log, 101) && append(&log, 101), "falla el registro %u", (unsigned)next_seq);
+    CHECK(alarm_flog_mount(&log, &io), "no remonta");
+    w = walk(&log);
+    CHECK(w.last == torn + 2 && w.gaps == 1 && log.stats.corrupt == 1, "último %u, %u saltos, %u corruptos",
+          (unsigned)w.last, (unsigned)w.gaps, (unsigned)log.stats.corrupt);
+    CHECK(overwrites == 0, "%u bytes escritos sin borrar", (unsigned)overwrites);
+}
+
+// Corte justo después de borrar un sector y antes de su cabecera: el sector
+// queda sin cabecera y se monta el anterior, que está lleno; el siguiente
+// registro vuelve a preparar el mismo sector
+static void test_torn_header(void) {
+    alarm_flog_t log;
+    CHECK(alarm_flog_mount(&log, &io), "no monta");
+    while (log.head_slot < SECTOR_SIZE / 16) {
+        CHECK(append(&log, 200), "falla el registro %u", (unsigned)next_seq);
+    }
+    uint32_t full_sector = log.head_sector;
+    uint32_t written = next_seq - 1;
+    uint32_t gaps = walk(&log).gaps;    // El registro cortado de la prueba anterior puede seguir ahí
+
+    // El borrado del siguiente sector terminó; la cabecera no llegó a escribirse
+    sim_erase(NULL, ((full_sector + 1) % SECTOR_COUNT) * SECTOR_SIZE, SECTOR_SIZE);
+
+    CHECK(alarm_flog_mount(&log, &io), "no remonta");
+    CHECK(log.head_sector == full_sector && log.head_slot == SECTOR_SIZE / 16, "cabeza en %u/%u",
+          (unsigned)log.head_sector, (unsigned)log.head_slot);
+    walk_t w = walk(&log);
+    CHECK(w.last == written && w.gaps == gaps, "último %u de %u, %u saltos", (unsigned)w.last, (unsigned)written,
+          (unsigned)w.gaps);
+
+    CHECK(append(&log, 201), "falla el registro %u", (unsigned)next_seq);
+    CHECK(log.head_sector == (full_sector + 1) % SECTOR_COUNT, "sector %u", (unsigned)log.head_sector);
+    w = walk(&log);
+    CHECK(w.last == written + 1 && w.gaps <= gaps, "último %u, %u saltos", (unsigned)w.last, (unsigned)w.gaps);
+}
+
+int main(void) {
+    test_blank();
+    test_wraparound_remount();
+    test_torn_record();
+    test_torn_header();
+    printf("%s\n", failures ? "FALLOS" : "OK");
+    return failures ? 1 : 0;
+}
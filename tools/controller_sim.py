@@ -0,0 +1,462 @@
+#!/usr/bin/env python3
+"""controller_sim.py - Simulador del controlador sobre un pseudo-terminal
+
+Abre un par PTY y se comporta como el controlador al otro lado de UART1:
+emite tramas DATA/SETTINGS a la cadencia pedida, con fragmentación y errores
+inyectados, y contesta a los comandos del firmware (<cmd>#<seq> -> ACK:<seq>,
+GET_SETTINGS*, GET_KEY*, CAPS?*, PROTO:BIN1*, BAUD?*, PING:*). Con --legacy se
+comporta como un controlador antiguo: no contesta a CAPS?*, no confirma nada y
+cualquier comando con '#<seq>' cuenta como fallo. Con --keyframe-every
+la telemetría sale como keyframes DATA...;SEQ=n; y deltas DLT:n;id=valor;...
+
+El campo VOL de cada DATA lleva un número de secuencia. Si el otro extremo
+contesta "ECHO:<VOL>" (tools/uart_host.c lo hace tras despachar la trama), se
+mide la latencia de ida y vuelta y se genera un informe de throughput/latencia.
+
+Uso:
+  # Capa UART compilada para Linux, lanzada por el simulador sobre el PTY:
+  python3 controller_sim.py --run ./uart_host --rate 500 --duration 10 --frag random
+  # Controlador antiguo (comandos sin secuencia):
+  python3 controller_sim.py --run ./uart_host --legacy
+  # Protocolo binario y errores inyectados:
+  python3 controller_sim.py --run ./uart_host --binary --corrupt 0.01
+  # Sólo el PTY (conectar otro programa a la ruta que se imprime):
+  python3 controller_sim.py --rate 10
+
+Salida con código 1 si se pasa --max-p99-us/--min-delivery y no se cumplen,
+para usarlo como comprobación de regresiones.
+"""
+import argparse
+import os
+import random
+import select
+import shlex
+import struct
+import subprocess
+import sys
+import time
+import tty
+
+NUM_PARAMS = 8
+TP_MSG_TEXT, TP_MSG_DATA, TP_MSG_SETTINGS, TP_MSG_DELTA = 0, 1, 2, 3
+BARE_COMMANDS = (b'CAPS?', b'PROTO:', b'BAUD?', b'BAUD=', b'PING:')
+
+
+# ---- Protocolo binario (mismo formato que main/telemetry_proto.c) ----
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_idx, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_idx] = code
+            code_idx, code = len(out), 1
+            out.append(0)
+            continue
+        out.append(b)
+        code += 1
+        if code == 0xFF:
+            out[code_idx] = code
+            code_idx, code = len(out), 1
+            out.append(0)
+    out[code_idx] = code
+    return bytes(out)
+
+
+def tp_frame(msg_type, payload):
+    raw = bytes([msg_type]) + payload
+    raw += struct.pack('<H', crc16(raw))
+    return cobs_encode(raw) + b'\x00'
+
+
+# ---- Estado del controlador simulado ----
+
+class Controller:
+    def __init__(self, opts):
+        self.opts = opts
+        self.binary = False
+        self.sequenced = False      # Contestó CAPS:SEQ: los comandos llegan como <cmd>#<seq>
+        self.legacy_violations = 0  # --legacy: comandos recibidos con '#<seq>'
+        self.params = [10 * (i + 1) for i in range(NUM_PARAMS)]
+        self.chk = 0
+        self.running = False
+        self.errors = 0
+        self.rx_line = bytearray()
+        self.commands = {}
+        self.echo_latency = []
+        self.sent_at = {}
+        self.stats_line = None
+        self.last_values = None
+        self.force_keyframe = False
+        self.keyframes_sent = 0
+        self.deltas_sent = 0
+
+    # Tramas salientes --------------------------------------------------
+
+    def text_frame(self, line):
+        if self.binary:
+            return tp_frame(TP_MSG_TEXT, line.encode())
+        return (line + self.opts.eol).encode()
+
+    def data_frame(self, seq, t_now):
+        # Temperaturas que cambian cada segundo: los deltas suelen llevar sólo VOL
+        t1 = 20.0 + (int(t_now) % 10) * 0.25
+        t2 = t1 + 0.7
+        values = (round(t1 * 100), round(t2 * 100), seq, self.errors)
+        every = self.opts.keyframe_every
+        if every <= 0:
+            # Controlador sin deltas: DATA sin SEQ
+            if self.binary:
+                return tp_frame(TP_MSG_DATA, struct.pack('<hhiB', *values))
+            return self.text_frame('DATA:T1=%.2f;T2=%.2f;VOL=%d;ERR=0x%02X;' % (t1, t2, seq, self.errors))
+
+        keyframe = self.force_keyframe or self.last_values is None or seq % every == 0
+        mask = 0x0F if keyframe else sum(1 << i for i in range(4) if values[i] != self.last_values[i])
+        self.last_values = values
+        self.force_keyframe = False
+        if keyframe:
+            self.keyframes_sent += 1
+        else:
+            self.deltas_sent += 1
+        if self.binary:
+            payload = struct.pack('<IB', seq, mask | (0x80 if keyframe else 0))
+            for i, fmt in enumerate(('<h', '<h', '<i', '<B')):
+                if mask & (1 << i):
+                    payload += struct.pack(fmt, values[i])
+            return tp_frame(TP_MSG_DELTA, payload)
+        if keyframe:
+            return self.text_frame('DATA:T1=%.2f;T2=%.2f;VOL=%d;ERR=0x%02X;SEQ=%d;' % (t1, t2, seq, self.errors, seq))
+        fields = ('%d.%02d' % divmod(values[0], 100), '%d.%02d' % divmod(values[1], 100), str(seq),
+                  '0x%02X' % self.errors)
+        return self.text_frame('DLT:%d;%s' % (seq, ''.join(
+            '%d=%s;' % (i + 1, fields[i]) for i in range(4) if mask & (1 << i))))
+
+    def settings_frame(self):
+        if self.binary:
+            payload = struct.pack('<8hB', *self.params, self.chk)
+            return tp_frame(TP_MSG_SETTINGS, payload)
+        body = ''.join('P%d=%d;' % (i + 1, v) for i, v in enumerate(self.params))
+        return self.text_frame('SETTINGS:%sCHK=%d;' % (body, self.chk))
+
+    # Comandos entrantes ------------------------------------------------
+
+    def handle_line(self, line, sim):
+        if line.startswith('ECHO:'):
+            seq = int(line[5:] or -1)
+            sent = self.sent_at.pop(seq, None)
+            if sent is not None:
+                self.echo_latency.append(time.perf_counter() - sent)
+            return
+        if line.startswith('STATS:'):
+            self.stats_line = line
+            return
+        if line.startswith('ATE0'):
+            return
+
+        # "<comando>#<seq>" del firmware (uart_tx_task); sin '#' no se confirma
+        cmd, _, seq = line.partition('#')
+        self.commands[cmd] = self.commands.get(cmd, 0) + 1
+        if self.opts.legacy and seq:
+            self.legacy_violations += 1
+            seq = ''
+        reply = []
+        ok = True
+        if cmd == 'CAPS?*':
+            if not self.opts.legacy:
+                sim.send(self.text_frame('CAPS:SEQ'))
+                self.sequenced = True
+            return
+        if cmd == 'PROTO:BIN1*':
+            if self.opts.binary:
+                sim.send(self.text_frame('PROTO:BIN1'))
+                self.binary = True
+            return
+        if cmd == 'BAUD?*':
+            # El PTY no tiene velocidad real: sólo se anuncia la velocidad base
+            sim.send(self.text_frame('BAUD:9600'))
+            return
+        if cmd.startswith('PING:'):
+            sim.send(self.text_frame('PONG:' + cmd[5:].rstrip('*')))
+            return
+        if cmd.startswith('GET_KEY'):
+            self.force_keyframe = True
+        elif cmd.startswith('GET_SETTINGS'):
+            reply.append(self.settings_frame())
+        elif cmd.startswith('SETTINGS:'):
+            ok = self.apply_settings(cmd[9:])
+        elif cmd.startswith('CMD:'):
+            op = cmd[4:7]
+            if op == 'STA':
+                self.running = True
+            elif op == 'STO':
+                self.running = False
+            elif op == 'RSC':
+                self.errors = 0
+        if seq:
+            if random.random() < self.opts.nak:
+                ok = False
+            if random.random() >= self.opts.drop_ack:
+                reply.insert(0, self.text_frame('%s:%s' % ('ACK' if ok else 'NAK', seq)))
+        for frame in reply:
+            sim.send(frame)
+
+    def apply_settings(self, body):
+        for field in body.split(';'):
+            key, _, value = field.partition('=')
+            try:
+                if key.startswith('P') and 1 <= int(key[1:]) <= NUM_PARAMS:
+                    self.params[int(key[1:]) - 1] = int(value)
+                elif key == 'CHK':
+                    self.chk = 1 if int(value) else 0
+            except ValueError:
+                return False
+        return True
+
+
+# ---- Transporte con fragmentación y errores ----
+
+class Simulator:
+    def __init__(self, opts, master):
+        self.opts = opts
+        self.master = master
+        self.ctrl = Controller(opts)
+        self.sent_frames = 0
+        self.sent_bytes = 0
+        self.injected = {'corrupt': 0, 'garbage': 0, 'truncate': 0, 'oversize': 0}
+        self.pending = bytearray()
+        self.start = time.perf_counter()
+
+    def inject(self, frame):
+        o = self.opts
+        r = random.random
+        if o.corrupt and r() < o.corrupt and len(frame) > 2:
+            b = bytearray(frame)
+            i = random.randrange(0, len(b) - 1)
+            b[i] ^= 1 << random.randrange(8)
+            if b[i] in (0, 0x0A) and i != len(b) - 1:
+                b[i] ^= 0x80
+            self.injected['corrupt'] += 1
+            frame = bytes(b)
+        if o.truncate and r() < o.truncate:
+            # Sin terminador: se funde con la trama siguiente
+            self.injected['truncate'] += 1
+            frame = frame[:random.randrange(1, len(frame))]
+        if o.garbage and r() < o.garbage:
+            self.injected['garbage'] += 1
+            junk = bytes(random.randrange(1, 256) for _ in range(random.randrange(1, 40)))
+            junk = junk.replace(b'\n', b'?').replace(b'\x00', b'?')
+            frame = junk + (b'\x00' if self.ctrl.binary else b'\n') + frame
+        if o.oversize and r() < o.oversize:
+            self.injected['oversize'] += 1
+            frame = b'X' * 1500 + (b'\x00' if self.ctrl.binary else b'\n') + frame
+        return frame
+
+    def send(self, frame):
+        self.pending += frame
+
+    def flush(self):
+        """Escribe lo pendiente con el patrón de fragmentación elegido"""
+        data = bytes(self.pending)
+        self.pending.clear()
+        o = self.opts
+        pos = 0
+        while pos < len(data):
+            if o.frag == 'whole':
+                n = len(data) - pos
+            elif o.frag == 'byte':
+                n = 1
+            else:
+                n = random.randint(1, o.chunk_max)
+            chunk = data[pos:pos + n]
+            while chunk:
+                try:
+                    w = os.write(self.master, chunk)
+                except BlockingIOError:
+                    select.select([], [self.master], [], 0.01)
+                    self.poll(0)
+                    continue
+                chunk = chunk[w:]
+                self.sent_bytes += w
+            pos += n
+            if o.gap_us and pos < len(data):
+                time.sleep(o.gap_us / 1e6)
+
+    def poll(self, timeout):
+        r, _, _ = select.select([self.master], [], [], timeout)
+        if not r:
+            return
+        try:
+            data = os.read(self.master, 4096)
+        except OSError:
+            return
+        buf = self.ctrl.rx_line
+        buf += data
+        while True:
+            nl = buf.find(b'\n')
+            star = buf.find(b'*')
+            if star >= 0 and (nl < 0 or star < nl) and buf[star + 1:star + 2] != b'#':
+                # Comando sin secuencia (negociación, o firmware sin CAPS:SEQ): termina
+                # en '*', sin '\n'. Al final del buffer puede faltar aún el '#<seq>'.
+                if star + 1 == len(buf) and self.ctrl.sequenced and not buf.startswith(BARE_COMMANDS):
+                    break
+                line, rest = bytes(buf[:star + 1]), bytes(buf[star + 1:])
+            elif nl >= 0:
+                line, rest = bytes(buf[:nl]), bytes(buf[nl + 1:])
+            else:
+                break
+            buf[:] = rest
+            text = line.decode(errors='replace').strip('\r')
+            if text:
+                self.ctrl.handle_line(text, self)
+
+    def run(self):
+        o = self.opts
+        start = self.start = time.perf_counter()
+        end = start + o.duration if o.duration > 0 else float('inf')
+        data_period = 1.0 / o.rate if o.rate > 0 else float('inf')
+        settings_period = 1.0 / o.settings_rate if o.settings_rate > 0 else float('inf')
+        next_data = start + 0.5  # Margen para la negociación inicial
+        next_settings = next_data
+        seq = 0
+
+        while True:
+            now = time.perf_counter()
+            if now >= end:
+                break
+            while now >= next_data and (o.burst or now - next_data < 1.0):
+                frame = self.ctrl.data_frame(seq, now)
+                self.ctrl.sent_at[seq] = time.perf_counter()
+                self.send(self.inject(frame))
+                self.sent_frames += 1
+                seq += 1
+                next_data += data_period
+            if now - next_data >= 1.0:
+                next_data = now  # Atraso irrecuperable: no acumular ráfagas
+            if now >= next_settings:
+                self.send(self.inject(self.ctrl.settings_frame()))
+                next_settings += settings_period
+            self.flush()
+            timeout = max(0.0, min(next_data, next_settings, end) - time.perf_counter())
+            self.poll(min(timeout, 0.05))
+
+        # Últimos ECHO en tránsito y estadísticas del otro extremo
+        self.send(self.ctrl.text_frame('BYE'))
+        self.flush()
+        drain_end = time.perf_counter() + 1.0
+        while time.perf_counter() < drain_end and self.ctrl.stats_line is None:
+            self.poll(0.05)
+        return time.perf_counter() - start
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def report(sim, elapsed, opts):
+    c = sim.ctrl
+    lat = sorted(x * 1e6 for x in c.echo_latency)
+    delivered = len(lat)
+    delivery = delivered / sim.sent_frames if sim.sent_frames else 0.0
+    lines = [
+        'controller_sim: %.1f s, modo %s, fragmentación %s' % (elapsed, 'binario' if c.binary else 'ASCII', opts.frag),
+        '  DATA enviadas      %8d  (%.0f tramas/s, %.1f kB/s en total)' % (
+            sim.sent_frames, sim.sent_frames / elapsed, sim.sent_bytes / elapsed / 1024),
+        '  DATA confirmadas   %8d  (%.2f %%)' % (delivered, 100.0 * delivery),
+        '  keyframes/deltas   %8d / %d' % (c.keyframes_sent, c.deltas_sent),
+        '  errores inyectados %s' % ', '.join('%s=%d' % kv for kv in sim.injected.items()),
+        '  comandos recibidos %s' % (', '.join('%s=%d' % kv for kv in sorted(c.commands.items())) or '-'),
+    ]
+    if lat:
+        lines.append('  latencia ECHO (us) p50=%.0f p95=%.0f p99=%.0f max=%.0f media=%.0f' % (
+            percentile(lat, 50), percentile(lat, 95), percentile(lat, 99), lat[-1], sum(lat) / len(lat)))
+    if c.stats_line:
+        lines.append('  extremo UART:')
+        for field in c.stats_line[6:].split(';'):
+            if field:
+                lines.append('    %s' % field.replace('=', ' = '))
+    print('\n'.join(lines))
+
+    failed = False
+    if opts.legacy and c.legacy_violations:
+        print('FALLO: %d comandos con #<seq> a un controlador sin CAPS:SEQ' % c.legacy_violations)
+        failed = True
+    if opts.max_p99_us and lat and percentile(lat, 99) > opts.max_p99_us:
+        print('FALLO: p99 %.0f us > %d us' % (percentile(lat, 99), opts.max_p99_us))
+        failed = True
+    if opts.min_delivery and delivery < opts.min_delivery:
+        print('FALLO: entrega %.4f < %.4f' % (delivery, opts.min_delivery))
+        failed = True
+    return 1 if failed else 0
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0],
+                                formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+    p.add_argument('--rate', type=float, default=10.0, help='tramas DATA por segundo')
+    p.add_argument('--settings-rate', type=float, default=0.0, help='tramas SETTINGS espontáneas por segundo')
+    p.add_argument('--duration', type=float, default=10.0, help='segundos (0 = hasta Ctrl-C)')
+    p.add_argument('--keyframe-every', type=int, default=0,
+                   help='telemetría delta con una keyframe cada N tramas (0 = DATA completas sin SEQ)')
+    p.add_argument('--burst', action='store_true', help='no limitar el atraso: recuperar enviando en ráfaga')
+    p.add_argument('--frag', choices=('whole', 'random', 'byte'), default='whole')
+    p.add_argument('--chunk-max', type=int, default=16, help='tamaño máximo de fragmento en --frag random')
+    p.add_argument('--gap-us', type=int, default=0, help='pausa entre fragmentos')
+    p.add_argument('--eol', default='\n', help='terminador ASCII (p. ej. "\\r\\n")')
+    p.add_argument('--binary', action='store_true', help='aceptar PROTO:BIN1* si el firmware lo propone')
+    p.add_argument('--legacy', action='store_true', help='controlador antiguo: sin CAPS:SEQ ni ACK')
+    p.add_argument('--corrupt', type=float, default=0.0, help='probabilidad de invertir un bit por trama')
+    p.add_argument('--truncate', type=float, default=0.0, help='probabilidad de cortar una trama sin terminador')
+    p.add_argument('--garbage', type=float, default=0.0, help='probabilidad de insertar una línea basura')
+    p.add_argument('--oversize', type=float, default=0.0, help='probabilidad de insertar una trama > 1024 bytes')
+    p.add_argument('--nak', type=float, default=0.0, help='probabilidad de contestar NAK a un comando')
+    p.add_argument('--drop-ack', type=float, default=0.0, help='probabilidad de no contestar a un comando')
+    p.add_argument('--seed', type=int, default=None)
+    p.add_argument('--run', help='programa a lanzar con la ruta del PTY como primer argumento')
+    p.add_argument('--max-p99-us', type=int, default=0, help='fallar si el p99 de latencia supera este valor')
+    p.add_argument('--min-delivery', type=float, default=0.0, help='fallar si se confirma menos de esta fracción')
+    opts = p.parse_args()
+    opts.eol = opts.eol.encode().decode('unicode_escape')
+    random.seed(opts.seed)
+
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    os.set_blocking(master, False)
+    path = os.ttyname(slave)
+    print('controller_sim: PTY en %s' % path, file=sys.stderr)
+
+    child = None
+    if opts.run:
+        argv = shlex.split(opts.run)
+        argv.insert(1, path)
+        child = subprocess.Popen(argv)
+
+    sim = Simulator(opts, master)
+    try:
+        elapsed = sim.run()
+    except KeyboardInterrupt:
+        elapsed = time.perf_counter() - sim.start
+    finally:
+        if child is not None:
+            try:
+                child.wait(timeout=2)
+            except subprocess.TimeoutExpired:
+                child.kill()
+        os.close(master)
+        os.close(slave)
+    sys.exit(report(sim, elapsed, opts))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,129 @@
+// data_parser_bench.c - Compara data_parse() con el sscanf anterior en el PC
+//
+// Compilar:  cc -O2 -I../main -o data_parser_bench data_parser_bench.c ../main/data_parser.c -lm
+//
+// Uso:  data_parser_bench [tramas]   (2000000 por defecto)
+//
+// Genera tramas DATA aleatorias, comprueba que ambos caminos dan los mismos
+// valores (sscanf redondeado a centésimas), comprueba que las tramas
+// malformadas se rechazan en el campo correcto e imprime el coste por trama.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "data_parser.h"
+
+#define FRAME_LEN 64
+#define POOL 4096   // Tramas distintas (potencia de 2): caben en caché, como la trama en curso en el firmware
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Camino anterior de screen_data_handler
+static int parse_sscanf(const char *frame, tp_data_t *out) {
+    float t1, t2;
+    int vol;
+    unsigned char errores = 0;
+    int parsed = sscanf(frame, "DATA:T1=%f;T2=%f;VOL=%d;ERR=0x%hhX;", &t1, &t2, &vol, &errores);
+    if (parsed < 3) {
+        return 0;
+    }
+    out->t1_centi = (int16_t)lroundf(t1 * 100.0f);
+    out->t2_centi = (int16_t)lroundf(t2 * 100.0f);
+    out->vol_ml = vol;
+    out->errors = errores;
+    return 1;
+}
+
+static const struct {
+    const char *frame;
+    data_parse_result_t expected;
+} malformed[] = {
+    { "DAT:T1=1;T2=2;VOL=3;", DATA_PARSE_PREFIX },
+    { "DATA:T1=;T2=2;VOL=3;", DATA_PARSE_T1 },
+    { "DATA:T1=1x;T2=2;VOL=3;", DATA_PARSE_T1 },
+    { "DATA:T1=400;T2=2;VOL=3;", DATA_PARSE_T1 },
+    { "DATA:T1=1;T2=.;VOL=3;", DATA_PARSE_T2 },
+    { "DATA:T1=1;T2=2;", DATA_PARSE_VOL },
+    { "DATA:T1=1;T2=2;VOL=3.5;", DATA_PARSE_VOL },
+    { "DATA:T1=1;T2=2;VOL=99999999999;", DATA_PARSE_VOL },
+    { "DATA:T1=1;T2=2;VOL=3;ERR=12;", DATA_PARSE_ERR },
+    { "DATA:T1=1;T2=2;VOL=3;ERR=0xZZ;", DATA_PARSE_ERR },
+    { "DATA:T1=1;T2=2;VOL=3;ERR=0x123;", DATA_PARSE_ERR },
+    { "DATA:T1=1;T2=2;VOL=3;ERR=0x12;X", DATA_PARSE_TRAILING },
+    { "DATA:T1=1;T2=2;VOL=3;SEQ=x;", DATA_PARSE_SEQ },
+    { "DATA:T1=1;T2=2;VOL=3;SEQ=7;ERR=0x1;", DATA_PARSE_TRAILING },
+    { "DATA:T1=1;T2=2;VOL=3;ERR=0x1;SEQ=7;", DATA_PARSE_OK },
+    { "DATA:T1=1;T2=2;VOL=3", DATA_PARSE_OK },
+    { "DATA:T1=-0.005;T2=+2.;VOL=-3;ERR=0xa;", DATA_PARSE_OK },
+};
+
+int main(int argc, char **argv) {
+    size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 2000000;
+    size_t pool = POOL;
+    char *frames = malloc(pool * FRAME_LEN);
+    if (frames == NULL) {
+        return 1;
+    }
+
+    srand(1);
+    for (size_t i = 0; i < pool; i++) {
+        int t1 = rand() % 20000 - 5000;
+        int t2 = rand() % 20000 - 5000;
+        snprintf(&frames[i * FRAME_LEN], FRAME_LEN, "DATA:T1=%s%d.%02d;T2=%s%d.%02d;VOL=%d;ERR=0x%02X;",
+                 t1 < 0 ? "-" : "", abs(t1) / 100, abs(t1) % 100,
+                 t2 < 0 ? "-" : "", abs(t2) / 100, abs(t2) % 100,
+                 rand() % 100000, rand() & 0xFF);
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+        tp_data_t d;
+        size_t offset = 0;
+        data_parse_result_t res = data_parse(malformed[i].frame, &d, &offset);
+        if (res != malformed[i].expected) {
+            printf("FALLO: \"%s\" -> %s (offset %zu), se esperaba %s\n", malformed[i].frame,
+                   data_parse_result_str(res), offset, data_parse_result_str(malformed[i].expected));
+            failures++;
+        }
+    }
+
+    for (size_t i = 0; i < pool; i++) {
+        const char *frame = &frames[i * FRAME_LEN];
+        tp_data_t a, b;
+        if (!parse_sscanf(frame, &a) || data_parse(frame, &b, NULL) != DATA_PARSE_OK ||
+            a.t1_centi != b.t1_centi || a.t2_centi != b.t2_centi || a.vol_ml != b.vol_ml || a.errors != b.errors) {
+            if (failures++ < 10) {
+                printf("FALLO: resultados distintos para \"%s\"\n", frame);
+            }
+        }
+    }
+
+    volatile int32_t sink = 0;
+    tp_data_t d;
+
+    double t0 = now_s();
+    for (size_t i = 0; i < count; i++) {
+        parse_sscanf(&frames[(i & (POOL - 1)) * FRAME_LEN], &d);
+        sink += d.vol_ml;
+    }
+    double t_sscanf = now_s() - t0;
+
+    t0 = now_s();
+    for (size_t i = 0; i < count; i++) {
+        data_parse(&frames[(i & (POOL - 1)) * FRAME_LEN], &d, NULL);
+        sink += d.vol_ml;
+    }
+    double t_parse = now_s() - t0;
+
+    printf("%zu tramas\n", count);
+    printf("  sscanf      %8.1f ns/trama\n", t_sscanf / count * 1e9);
+    printf("  data_parse  %8.1f ns/trama  (x%.1f)\n", t_parse / count * 1e9, t_sscanf / t_parse);
+    printf("%s\n", failures ? "FALLOS" : "OK");
+    free(frames);
+    return failures ? 1 : 0;
+}
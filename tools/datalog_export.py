@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""datalog_export.py - Decodifica en el PC un volcado DLOG:EXPORT del firmware
+
+Uso:
+  python3 datalog_export.py [--from TS] [--to TS] [--wall] [log]   (log o stdin)
+
+Escribe CSV: ts,t1,t2,vol,err (temperaturas en °C, vol en ml). El volcado
+trae bloques completos; --from/--to recortan las muestras. Con --wall el ts se
+convierte a hora del PC suponiendo que el volcado se capturó ahora (el firmware
+no tiene RTC; la línea "DL BEGIN" trae su ts actual).
+Las líneas que no empiezan por "DL " (logs normales de la consola) se ignoran.
+Formato de bloque: main/datalog.h.
+"""
+import argparse
+import datetime
+import struct
+import sys
+import time
+
+HEADER = struct.Struct('<IIIihhBBH')    # dlog_header_t
+SEAL = struct.Struct('<IIIHH')          # dlog_seal_t
+DATA_OFFSET = HEADER.size + SEAL.size
+MAGIC = 0x31474c44
+DT_EXT = 14
+FIELD_T1, FIELD_T2, FIELD_VOL, FIELD_ERR = 0x01, 0x02, 0x04, 0x08
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def varint(data, pos):
+    value, shift = 0, 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        if not byte & 0x80:
+            return value, pos
+        shift += 7
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def wrap(value, bits):
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if value & (1 << (bits - 1)) else value
+
+
+def decode_block(raw, length):
+    """Genera (ts, t1, t2, vol, err) del bloque; valida cabecera y, si está cerrado, el CRC de los datos."""
+    magic, seq, ts, vol, t1, t2, err, _, crc = HEADER.unpack_from(raw)
+    if magic != MAGIC or crc != crc16(raw[:HEADER.size - 2]):
+        raise ValueError('cabecera inválida')
+    count, _, data_len, data_crc, seal_crc = SEAL.unpack_from(raw, HEADER.size)
+    if seal_crc == crc16(raw[HEADER.size:DATA_OFFSET - 2]):
+        if crc16(raw[DATA_OFFSET:DATA_OFFSET + data_len]) != data_crc:
+            raise ValueError('CRC de datos incorrecto')
+    yield ts, t1, t2, vol, err
+    pos = DATA_OFFSET
+    while pos < length and raw[pos] >> 4 != 15:
+        ctrl = raw[pos]
+        pos += 1
+        dt = (ctrl >> 4) + 1
+        if ctrl >> 4 == DT_EXT:
+            dt, pos = varint(raw, pos)
+        ts += dt
+        if ctrl & FIELD_T1:
+            v, pos = varint(raw, pos)
+            t1 = wrap(t1 + unzigzag(v), 16)
+        if ctrl & FIELD_T2:
+            v, pos = varint(raw, pos)
+            t2 = wrap(t2 + unzigzag(v), 16)
+        if ctrl & FIELD_VOL:
+            v, pos = varint(raw, pos)
+            vol = wrap(vol + unzigzag(v), 32)
+        if ctrl & FIELD_ERR:
+            err = raw[pos]
+            pos += 1
+        yield ts, t1, t2, vol, err
+
+
+def read_blocks(src):
+    """Genera (seq, bytes) por cada bloque completo del volcado y el ts del firmware al empezar."""
+    block = None
+    for line in src:
+        idx = line.find('DL ')
+        if idx < 0:
+            continue
+        fields = line[idx + 3:].split()
+        if not fields:
+            continue
+        if fields[0] == 'BEGIN' and len(fields) >= 4:
+            yield 'now', int(fields[3], 16), None
+        elif fields[0] == 'B' and len(fields) >= 6:
+            block = {'seq': int(fields[1], 16), 'len': int(fields[5], 16), 'data': bytearray()}
+        elif fields[0] == 'D' and block is not None and len(fields) >= 3:
+            if int(fields[1], 16) != len(block['data']):
+                sys.stderr.write('bloque %d: línea perdida, se descarta\n' % block['seq'])
+                block = None
+                continue
+            block['data'] += bytes.fromhex(fields[2])
+            if len(block['data']) >= block['len']:
+                yield 'block', block['seq'], bytes(block['data'])
+                block = None
+        elif fields[0] == 'X' and len(fields) >= 2:
+            sys.stderr.write('bloque %d: reciclado durante el volcado\n' % int(fields[1], 16))
+            block = None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--from', dest='from_ts', type=int, default=0)
+    parser.add_argument('--to', dest='to_ts', type=int, default=0xFFFFFFFF)
+    parser.add_argument('--wall', action='store_true', help='ts como fecha y hora del PC')
+    parser.add_argument('log', nargs='?')
+    opts = parser.parse_args()
+
+    src = open(opts.log, encoding='utf-8', errors='replace') if opts.log else sys.stdin
+    offset = None
+    print('ts,t1,t2,vol,err')
+    for kind, value, raw in read_blocks(src):
+        if kind == 'now':
+            offset = time.time() - value
+            continue
+        try:
+            for ts, t1, t2, vol, err in decode_block(raw, len(raw)):
+                if not opts.from_ts <= ts <= opts.to_ts:
+                    continue
+                stamp = str(ts)
+                if opts.wall and offset is not None:
+                    stamp = datetime.datetime.fromtimestamp(ts + offset).isoformat(timespec='seconds')
+                print('%s,%.2f,%.2f,%d,0x%02x' % (stamp, t1 / 100.0, t2 / 100.0, vol, err))
+        except (ValueError, IndexError) as e:
+            sys.stderr.write('bloque %d: %s\n' % (value, e))
+
+
+if __name__ == '__main__':
+    main()
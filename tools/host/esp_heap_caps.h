@@ -0,0 +1,16 @@
+// esp_heap_caps.h - Todas las capacidades son el heap del PC
+#ifndef HOST_ESP_HEAP_CAPS_H
+#define HOST_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_DEFAULT (1 << 0)
+#define MALLOC_CAP_INTERNAL (1 << 1)
+#define MALLOC_CAP_SPIRAM (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+
+#define heap_caps_malloc(size, caps) malloc(size)
+#define heap_caps_calloc(n, size, caps) calloc(n, size)
+#define heap_caps_free(ptr) free(ptr)
+
+#endif // HOST_ESP_HEAP_CAPS_H
@@ -0,0 +1,558 @@
+// host_shim.c - FreeRTOS, driver UART, esp_timer, log y subjects de LVGL sobre POSIX
+//
+// Lo justo para enlazar en el PC los módulos del firmware que no tocan el
+// hardware (uart_utils.c, uart_tx.c, telemetry_store.c...). Las tareas son
+// hilos, las secciones críticas mutex y el UART un descriptor: el mismo código
+// corre con concurrencia real, sin simular prioridades ni núcleos.
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lvgl.h"
+#include "host_shim.h"
+
+#define HOST_UART_PORTS 3
+#define HOST_UART_READ_CHUNK 128    // Como el FIFO RX del ESP32-S3
+#define HOST_PATTERN_QUEUE 64
+
+// ---- Reloj ----
+
+static struct timespec clock_base;
+
+__attribute__((constructor)) static void clock_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &clock_base);
+}
+
+int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)(ts.tv_sec - clock_base.tv_sec) * 1000000 + (ts.tv_nsec - clock_base.tv_nsec) / 1000;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+// Condición sobre CLOCK_MONOTONIC, para que los plazos no dependan de la hora
+static void cond_init(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static struct timespec deadline_after(TickType_t ticks) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += ticks / 1000;
+    ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return ts;
+}
+
+// Espera con el mutex tomado; false si venció el plazo (ticks = 0: no espera)
+static bool cond_wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, TickType_t ticks,
+                            const struct timespec *deadline) {
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+// ---- Tareas y notificaciones ----
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify;
+    char name[16];
+};
+
+static __thread struct host_task *current_task;
+
+static struct host_task *task_new(const char *name) {
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        abort();
+    }
+    pthread_mutex_init(&task->lock, NULL);
+    cond_init(&task->cond);
+    snprintf(task->name, sizeof(task->name), "%s", name);
+    return task;
+}
+
+static void *task_entry(void *arg) {
+    current_task = arg;
+    current_task->fn(current_task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio,
+                       TaskHandle_t *out) {
+    (void)stack;
+    (void)prio;
+    struct host_task *task = task_new(name);
+    task->fn = fn;
+    task->arg = arg;
+    // El handle existe antes de que arranque el hilo, como en FreeRTOS
+    if (out != NULL) {
+        *out = task;
+    }
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        return pdFALSE;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    // El hilo principal del programa también es una tarea
+    if (current_task == NULL) {
+        current_task = task_new("main");
+    }
+    return current_task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    struct timespec ts = { ticks / 1000, (long)(ticks % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    if (task == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && cond_wait_until(&task->cond, &task->lock, ticks, &deadline)) {
+    }
+    uint32_t value = task->notify;
+    if (value != 0) {
+        task->notify = clear ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+// ---- Semáforos y mutex (sin herencia de prioridad) ----
+
+struct host_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned count;
+};
+
+static SemaphoreHandle_t sem_new(unsigned count) {
+    struct host_sem *sem = calloc(1, sizeof(*sem));
+    if (sem != NULL) {
+        pthread_mutex_init(&sem->lock, NULL);
+        cond_init(&sem->cond);
+        sem->count = count;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return sem_new(1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return sem_new(0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && cond_wait_until(&sem->cond, &sem->lock, ticks, &deadline)) {
+    }
+    bool taken = sem->count > 0;
+    if (taken) {
+        sem->count--;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return taken ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    pthread_mutex_lock(&sem->lock);
+    bool given = sem->count == 0;
+    if (given) {
+        sem->count = 1;
+        pthread_cond_signal(&sem->cond);
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return given ? pdTRUE : pdFALSE;
+}
+
+// ---- Colas ----
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *items;
+    size_t item_size;
+    size_t length;
+    size_t head;
+    size_t count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct host_queue *queue = calloc(1, sizeof(*queue));
+    if (queue == NULL || (queue->items = calloc(length, item_size)) == NULL) {
+        free(queue);
+        return NULL;
+    }
+    pthread_mutex_init(&queue->lock, NULL);
+    cond_init(&queue->not_empty);
+    cond_init(&queue->not_full);
+    queue->item_size = item_size;
+    queue->length = length;
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && cond_wait_until(&queue->not_full, &queue->lock, ticks, &deadline)) {
+    }
+    bool sent = queue->count < queue->length;
+    if (sent) {
+        size_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(&queue->items[tail * queue->item_size], item, queue->item_size);
+        queue->count++;
+        pthread_cond_signal(&queue->not_empty);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return sent ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    struct timespec deadline = deadline_after(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && cond_wait_until(&queue->not_empty, &queue->lock, ticks, &deadline)) {
+    }
+    bool received = queue->count > 0;
+    if (received) {
+        memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return received ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+// ---- Driver UART ----
+
+typedef struct {
+    int fd;
+    bool alive;
+    pthread_t reader;
+    pthread_mutex_t lock;           // Ring RX y cola de patrones
+    pthread_cond_t data_cond;
+    pthread_mutex_t write_lock;     // Una escritura entera cada vez, como el tx_mux del driver
+    uint8_t *ring;
+    size_t size;
+    size_t head;                    // Siguiente byte a leer
+    size_t count;
+    int patterns[HOST_PATTERN_QUEUE];
+    size_t pattern_count;
+    char pattern;
+    bool pattern_on;
+    QueueHandle_t events;
+    uint32_t dropped;
+    uint32_t baud;
+} host_uart_t;
+
+static host_uart_t uarts[HOST_UART_PORTS] = {
+    [0 ... HOST_UART_PORTS - 1] = {
+        .fd = -1,
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .write_lock = PTHREAD_MUTEX_INITIALIZER,
+    },
+};
+
+void host_uart_attach(uart_port_t port, int fd) {
+    uarts[port].fd = fd;
+    uarts[port].alive = fd >= 0;
+}
+
+uint32_t host_uart_dropped(uart_port_t port) {
+    return uarts[port].dropped;
+}
+
+bool host_uart_alive(uart_port_t port) {
+    return uarts[port].alive;
+}
+
+static void post_event(host_uart_t *u, uart_event_type_t type, size_t size) {
+    uart_event_t event = { .type = type, .size = size };
+    // El driver descarta el evento si la cola está llena
+    xQueueSend(u->events, &event, 0);
+}
+
+// Hilo que hace de ISR: copia lo recibido al ring y publica los eventos
+static void *uart_reader(void *arg) {
+    host_uart_t *u = arg;
+    uint8_t chunk[HOST_UART_READ_CHUNK];
+
+    for (;;) {
+        ssize_t n = read(u->fd, chunk, sizeof(chunk));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        if (n <= 0) {
+            u->alive = false;
+            post_event(u, UART_BREAK, 0);
+            return NULL;
+        }
+
+        pthread_mutex_lock(&u->lock);
+        size_t room = u->size - u->count;
+        size_t accepted = (size_t)n < room ? (size_t)n : room;
+        size_t patterns = 0;
+        for (size_t i = 0; i < accepted; i++) {
+            size_t pos = (u->head + u->count) % u->size;
+            u->ring[pos] = chunk[i];
+            if (u->pattern_on && chunk[i] == (uint8_t)u->pattern && u->pattern_count < HOST_PATTERN_QUEUE) {
+                u->patterns[u->pattern_count++] = (int)u->count;
+                patterns++;
+            }
+            u->count++;
+        }
+        u->dropped += (uint32_t)((size_t)n - accepted);
+        pthread_cond_broadcast(&u->data_cond);
+        pthread_mutex_unlock(&u->lock);
+
+        if (accepted < (size_t)n) {
+            post_event(u, UART_BUFFER_FULL, (size_t)n - accepted);
+        }
+        if (patterns == 0) {
+            post_event(u, UART_DATA, accepted);
+        }
+        for (size_t i = 0; i < patterns; i++) {
+            post_event(u, UART_PATTERN_DET, accepted);
+        }
+    }
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *queue, int intr_flags) {
+    (void)tx_buffer_size;
+    (void)intr_flags;
+    host_uart_t *u = &uarts[port];
+    u->size = (size_t)rx_buffer_size;
+    u->ring = calloc(1, u->size);
+    u->events = xQueueCreate(queue_size, sizeof(uart_event_t));
+    if (u->ring == NULL || u->events == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    cond_init(&u->data_cond);
+    if (queue != NULL) {
+        *queue = u->events;
+    }
+    if (u->fd >= 0 && pthread_create(&u->reader, NULL, uart_reader, u) != 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t port, char pattern, uint8_t count, int chr_tout,
+                                            int post_idle, int pre_idle) {
+    (void)count;
+    (void)chr_tout;
+    (void)post_idle;
+    (void)pre_idle;
+    pthread_mutex_lock(&uarts[port].lock);
+    uarts[port].pattern = pattern;
+    uarts[port].pattern_on = true;
+    pthread_mutex_unlock(&uarts[port].lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_pattern_queue_reset(uart_port_t port, int queue_length) {
+    (void)queue_length;
+    pthread_mutex_lock(&uarts[port].lock);
+    uarts[port].pattern_count = 0;
+    pthread_mutex_unlock(&uarts[port].lock);
+    return ESP_OK;
+}
+
+int uart_pattern_pop_pos(uart_port_t port) {
+    host_uart_t *u = &uarts[port];
+    int pos = -1;
+    pthread_mutex_lock(&u->lock);
+    if (u->pattern_count > 0) {
+        pos = u->patterns[0];
+        memmove(&u->patterns[0], &u->patterns[1], --u->pattern_count * sizeof(u->patterns[0]));
+    }
+    pthread_mutex_unlock(&u->lock);
+    return pos;
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t symbols) {
+    (void)port;
+    (void)symbols;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud) {
+    // Un PTY no tiene velocidad: sólo se recuerda
+    uarts[port].baud = baud;
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size) {
+    pthread_mutex_lock(&uarts[port].lock);
+    *size = uarts[port].count;
+    pthread_mutex_unlock(&uarts[port].lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t port) {
+    host_uart_t *u = &uarts[port];
+    pthread_mutex_lock(&u->lock);
+    u->head = 0;
+    u->count = 0;
+    u->pattern_count = 0;
+    pthread_mutex_unlock(&u->lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks) {
+    (void)ticks;
+    // write() no vuelve hasta entregar todo al PTY
+    pthread_mutex_lock(&uarts[port].write_lock);
+    pthread_mutex_unlock(&uarts[port].write_lock);
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks) {
+    host_uart_t *u = &uarts[port];
+    struct timespec deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&u->lock);
+    while (u->count == 0 && cond_wait_until(&u->data_cond, &u->lock, ticks, &deadline)) {
+    }
+    size_t n = length < u->count ? length : u->count;
+    for (size_t i = 0; i < n; i++) {
+        ((uint8_t *)buf)[i] = u->ring[(u->head + i) % u->size];
+    }
+    u->head = (u->head + n) % u->size;
+    u->count -= n;
+    // Las posiciones de patrón son relativas al principio del ring
+    for (size_t i = 0; i < u->pattern_count; i++) {
+        u->patterns[i] -= (int)n;
+    }
+    pthread_mutex_unlock(&u->lock);
+    return (int)n;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size) {
+    host_uart_t *u = &uarts[port];
+    const uint8_t *p = src;
+    size_t left = size;
+
+    if (u->fd < 0) {
+        return (int)size;
+    }
+    pthread_mutex_lock(&u->write_lock);
+    while (left > 0) {
+        ssize_t n = write(u->fd, p, left);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            break;
+        }
+        p += n;
+        left -= (size_t)n;
+    }
+    pthread_mutex_unlock(&u->write_lock);
+    return (int)(size - left);
+}
+
+// ---- Log ----
+
+esp_log_level_t host_log_level = ESP_LOG_WARN;
+
+void host_log(esp_log_level_t level, const char *tag, const char *fmt, ...) {
+    static const char letters[] = "NEWIDV";
+    if (level > host_log_level) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    flockfile(stderr);
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(esp_timer_get_time() / 1000), tag);
+    vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    funlockfile(stderr);
+    va_end(args);
+}
+
+// ---- Subjects de LVGL ----
+
+void lv_subject_init_int(lv_subject_t *subject, int32_t value) {
+    subject->value = value;
+    subject->notifications = 0;
+}
+
+int32_t lv_subject_get_int(lv_subject_t *subject) {
+    return subject->value;
+}
+
+void lv_subject_notify(lv_subject_t *subject) {
+    subject->notifications++;
+}
+
+// Como en LVGL: notifica siempre, aunque el valor no cambie
+void lv_subject_set_int(lv_subject_t *subject, int32_t value) {
+    subject->value = value;
+    lv_subject_notify(subject);
+}
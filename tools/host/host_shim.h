@@ -0,0 +1,17 @@
+// host_shim.h - Lo que el PC necesita además de las APIs de ESP-IDF/FreeRTOS simuladas
+#ifndef HOST_SHIM_H
+#define HOST_SHIM_H
+
+#include "driver/uart.h"
+
+// Asocia el puerto a un descriptor abierto (p. ej. el esclavo de un PTY) antes
+// de uart_driver_install; sin él, lo escrito se descarta y nunca llega nada
+void host_uart_attach(uart_port_t port, int fd);
+
+// Bytes que el hilo lector tuvo que descartar por falta de sitio en el ring
+uint32_t host_uart_dropped(uart_port_t port);
+
+// false si el otro extremo cerró el descriptor
+bool host_uart_alive(uart_port_t port);
+
+#endif // HOST_SHIM_H
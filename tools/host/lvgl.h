@@ -0,0 +1,25 @@
+// lvgl.h - Sólo los subjects enteros de LVGL, para los módulos que publican en la UI
+//
+// Sin observadores: cada subject cuenta las notificaciones, que es lo que
+// comprueban las pruebas (un observador de LVGL se ejecuta una vez por notificación).
+#ifndef HOST_LVGL_H
+#define HOST_LVGL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct _lv_obj_t lv_obj_t;
+typedef struct _lv_display_t lv_display_t;
+typedef uint16_t lv_state_t;
+
+typedef struct {
+    int32_t value;
+    uint32_t notifications;     // Veces que se habrían llamado los observadores
+} lv_subject_t;
+
+void lv_subject_init_int(lv_subject_t *subject, int32_t value);
+int32_t lv_subject_get_int(lv_subject_t *subject);
+void lv_subject_set_int(lv_subject_t *subject, int32_t value);
+void lv_subject_notify(lv_subject_t *subject);
+
+#endif // HOST_LVGL_H
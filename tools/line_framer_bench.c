@@ -0,0 +1,207 @@
+// line_framer_bench.c - Fragmentación aleatoria sobre el framer de líneas en el PC
+//
+// Compilar:  cc -O2 -I../main -o line_framer_bench line_framer_bench.c ../main/line_framer.c
+//
+// Uso:  line_framer_bench [MB] [semilla]   (64 MB y semilla 1 por defecto)
+//
+// Genera un flujo de tramas DATA/SETTINGS/OK con alguna línea demasiado larga
+// intercalada y lo entrega en trozos de tamaño aleatorio (1..UART_READ_MAX,
+// como las lecturas del driver), leyendo directamente al ring igual que
+// uart_receive_task. Comprueba que salen exactamente las tramas esperadas en
+// orden y que las largas se descartan sin perder las vecinas, e imprime el
+// caudal del framer y el del ensamblador strchr/memmove anterior con los
+// mismos trozos. Objetivo del firmware: >= 1 Mbit/s con CPU acotada.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "line_framer.h"
+
+#define UART_READ_MAX 256           // Trozo máximo por lectura
+#define POOL_BYTES (1 << 20)        // Flujo que se repite hasta sumar los MB pedidos
+#define LONG_EVERY 97               // Una línea demasiado larga cada tantas tramas
+#define LEGACY_BUF 4096             // temp_buffer del ensamblador anterior
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng;
+
+static uint32_t next_rand(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static char *pool;
+static size_t pool_len;
+static size_t *frame_ends;      // Fin (posición del '\n') de cada trama válida del flujo
+static size_t frame_count;
+static size_t long_count;
+
+static void build_pool(void) {
+    pool = malloc(POOL_BYTES + 2 * LINE_FRAMER_MAX_FRAME);
+    frame_ends = malloc(POOL_BYTES / 4 * sizeof(size_t));
+    while (pool_len < POOL_BYTES) {
+        char *p = &pool[pool_len];
+        size_t n;
+        uint32_t kind = next_rand() % LONG_EVERY;
+        if (kind == 0) {
+            // Más larga que LINE_FRAMER_MAX_FRAME: el framer la descarta
+            n = LINE_FRAMER_MAX_FRAME + 1 + next_rand() % LINE_FRAMER_MAX_FRAME;
+            memset(p, 'z', n);
+            p[n++] = '\n';
+            pool_len += n;
+            long_count++;
+            continue;
+        }
+        if (kind < 80) {
+            n = (size_t)sprintf(p, "DATA:T1=%u.%02u;T2=%u.%02u;VOL=%u;ERR=0x%02X;SEQ=%u;\r\n", next_rand() % 300,
+                                next_rand() % 100, next_rand() % 300, next_rand() % 100, next_rand() % 100000,
+                                next_rand() & 0xFF, next_rand() & 0xFFFF);
+        } else if (kind < 90) {
+            n = (size_t)sprintf(p, "SETTINGS:P1=%u;P2=%u;P3=%u;P4=%u;P5=%u;P6=%u;P7=%u;P8=%u;CHK=%u;\n",
+                                next_rand() % 101, next_rand() % 101, next_rand() % 101, next_rand() % 101,
+                                next_rand() % 101, next_rand() % 101, next_rand() % 101, next_rand() % 101,
+                                next_rand() & 1);
+        } else {
+            n = (size_t)sprintf(p, "OK:%u\n", next_rand() % 1000);
+        }
+        pool_len += n;
+        frame_ends[frame_count++] = pool_len - 1;
+    }
+}
+
+// Compara la trama entregada con la esperada (sin '\r' final)
+static int check_frame(const line_frame_t *fr, size_t index) {
+    size_t end = frame_ends[index];
+    size_t start = index == 0 ? 0 : frame_ends[index - 1] + 1;
+    // Saltar líneas largas entre la trama anterior y ésta
+    while (pool[start] == 'z') {
+        start = (size_t)((char *)memchr(&pool[start], '\n', end - start) - pool) + 1;
+    }
+    size_t len = end - start;
+    if (len > 0 && pool[end - 1] == '\r') {
+        len--;
+    }
+    return fr->len == len && memcmp(fr->data, &pool[start], len) == 0;
+}
+
+static line_framer_t framer;
+
+// Framer: lectura directa al ring, como uart_receive_task
+static double run_framer(size_t total, int *failures) {
+    line_framer_init(&framer, '\n');
+    size_t expected = 0;
+    size_t pos = 0;
+    volatile size_t sink = 0;
+    double t0 = now_s();
+    for (size_t done = 0; done < total;) {
+        char *dst;
+        size_t room = line_framer_write_ptr(&framer, &dst);
+        size_t n = 1 + next_rand() % UART_READ_MAX;
+        n = n < room ? n : room;
+        n = n < pool_len - pos ? n : pool_len - pos;
+        memcpy(dst, &pool[pos], n);
+        line_framer_commit(&framer, n);
+        pos += n;
+        done += n;
+
+        line_frame_t fr;
+        while (line_framer_next(&framer, &fr)) {
+            if (failures != NULL && !check_frame(&fr, expected) && (*failures)++ < 10) {
+                printf("FALLO: trama %zu distinta: \"%.40s\"\n", expected, fr.data);
+            }
+            sink += fr.len;
+            expected = expected + 1 == frame_count ? 0 : expected + 1;
+        }
+        if (pos == pool_len) {
+            pos = 0;
+        }
+    }
+    double t = now_s() - t0;
+    if (failures != NULL && (expected != 0 || pos != 0)) {
+        // Sólo se comprueba el recuento si se recorrió el flujo un número entero de veces
+        printf("FALLO: quedan %zu tramas por llegar\n", frame_count - expected);
+        (*failures)++;
+    }
+    return t;
+}
+
+// Ensamblador anterior: copia del trozo, strchr desde el principio y memmove del resto
+static double run_legacy(size_t total) {
+    static char temp_buffer[LEGACY_BUF];
+    size_t temp_index = 0;
+    size_t pos = 0;
+    volatile size_t sink = 0;
+    double t0 = now_s();
+    for (size_t done = 0; done < total;) {
+        size_t n = 1 + next_rand() % UART_READ_MAX;
+        n = n < pool_len - pos ? n : pool_len - pos;
+        if (temp_index + n < sizeof(temp_buffer) - 1) {
+            memcpy(&temp_buffer[temp_index], &pool[pos], n);
+            temp_index += n;
+            temp_buffer[temp_index] = '\0';
+            char *start = temp_buffer;
+            char *newline;
+            while ((newline = strchr(start, '\n')) != NULL) {
+                *newline = '\0';
+                sink += (size_t)(newline - start);
+                start = newline + 1;
+            }
+            if (*start != '\0') {
+                size_t remaining = strlen(start);
+                memmove(temp_buffer, start, remaining);
+                temp_index = remaining;
+                temp_buffer[temp_index] = '\0';
+            } else {
+                temp_index = 0;
+            }
+        } else {
+            temp_index = 0;     // Se perdía todo lo acumulado
+        }
+        pos += n;
+        done += n;
+        if (pos == pool_len) {
+            pos = 0;
+        }
+    }
+    return now_s() - t0;
+}
+
+int main(int argc, char **argv) {
+    size_t mb = argc > 1 ? strtoul(argv[1], NULL, 10) : 64;
+    rng = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 1;
+    if (rng == 0) {
+        rng = 1;
+    }
+    build_pool();
+
+    // Comprobación: varias pasadas completas por el flujo con trozos aleatorios
+    int failures = 0;
+    run_framer(4 * pool_len, &failures);
+    if (framer.overflows != 4 * long_count) {
+        printf("FALLO: %u desbordes, se esperaban %zu\n", (unsigned)framer.overflows, 4 * long_count);
+        failures++;
+    }
+
+    size_t total = mb << 20;
+    uint32_t seed = rng;
+    double t_framer = run_framer(total, NULL);
+    rng = seed;     // Mismos trozos para los dos
+    double t_legacy = run_legacy(total);
+
+    printf("%zu MB en trozos de 1..%d bytes, %zu tramas y %zu líneas largas por MB\n", mb, UART_READ_MAX,
+           frame_count, long_count);
+    printf("  strchr/memmove %8.1f Mbit/s  %6.2f ns/byte\n", total * 8 / t_legacy / 1e6, t_legacy / total * 1e9);
+    printf("  line_framer    %8.1f Mbit/s  %6.2f ns/byte  (x%.1f)\n", total * 8 / t_framer / 1e6,
+           t_framer / total * 1e9, t_legacy / t_framer);
+    printf("%s\n", failures ? "FALLOS" : "OK");
+    free(pool);
+    free(frame_ends);
+    return failures ? 1 : 0;
+}
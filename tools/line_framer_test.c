@@ -0,0 +1,185 @@
+// line_framer_test.c - Pruebas en el PC del framer de líneas del firmware
+//
+// Compilar:  cc -O2 -Wall -I../main -o line_framer_test line_framer_test.c ../main/line_framer.c
+//
+// Uso:  line_framer_test
+//
+// Tramas partidas byte a byte y en trozos, varias tramas en un mismo trozo,
+// CR/LF, tramas que dan la vuelta al ring, trama de longitud máxima, desborde
+// con y sin terminador pendiente y resincronización, ring lleno.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "line_framer.h"
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FALLO %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);            \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+static line_framer_t f;     // Grande para la pila
+
+// Comprueba que la siguiente trama es exactamente text
+static void expect_frame(const char *text) {
+    line_frame_t fr;
+    if (!line_framer_next(&f, &fr)) {
+        CHECK(0, "se esperaba \"%.40s\" y no hay trama", text);
+        return;
+    }
+    CHECK(fr.len == strlen(text) && memcmp(fr.data, text, fr.len) == 0 && fr.data[fr.len] == '\0',
+          "se esperaba \"%.40s\", llegó \"%.40s\" (%zu)", text, fr.data, fr.len);
+}
+
+static void expect_none(void) {
+    line_frame_t fr;
+    CHECK(!line_framer_next(&f, &fr), "trama inesperada \"%.40s\"", fr.data);
+}
+
+static void push_str(const char *s) {
+    size_t n = strlen(s);
+    CHECK(line_framer_push(&f, s, n) == n, "push de %zu bytes incompleto", n);
+}
+
+static void test_split(void) {
+    line_framer_init(&f, '\n');
+    const char *line = "DATA:T1=23.50;T2=24.10;VOL=150;ERR=0x00;\n";
+    for (const char *p = line; *p != '\0'; p++) {
+        expect_none();
+        CHECK(line_framer_push(&f, p, 1) == 1, "push de un byte");
+    }
+    expect_frame("DATA:T1=23.50;T2=24.10;VOL=150;ERR=0x00;");
+    expect_none();
+
+    // Terminador al principio del siguiente trozo
+    push_str("OK:1");
+    expect_none();
+    push_str("\nOK:");
+    expect_frame("OK:1");
+    push_str("2\n");
+    expect_frame("OK:2");
+    CHECK(f.frames == 3, "frames=%u", (unsigned)f.frames);
+}
+
+static void test_merged(void) {
+    line_framer_init(&f, '\n');
+    push_str("A:1\nB:2\r\n\nC:3\nD:");
+    expect_frame("A:1");
+    expect_frame("B:2");     // Sin el '\r'
+    expect_frame("");        // Línea vacía
+    expect_frame("C:3");
+    expect_none();
+    push_str("4\n");
+    expect_frame("D:4");
+    expect_none();
+
+    // Otro terminador: '\r' no se recorta
+    line_framer_init(&f, '*');
+    push_str("CMD:RES01*CMD:STO01\r*");
+    expect_frame("CMD:RES01");
+    expect_frame("CMD:STO01\r");
+}
+
+static void test_wrap(void) {
+    line_framer_init(&f, '\n');
+    char line[LINE_FRAMER_MAX_FRAME + 2];
+    // Tramas de longitudes variadas hasta dar varias vueltas al ring
+    for (int i = 0; i < 200; i++) {
+        size_t len = (size_t)(i * 37) % 300 + 1;
+        for (size_t j = 0; j < len; j++) {
+            line[j] = (char)('a' + (i + j) % 26);
+        }
+        line[len] = '\0';
+        push_str(line);
+        push_str("\n");
+        expect_frame(line);
+    }
+    CHECK(f.head > 4 * LINE_FRAMER_RING_SIZE, "no se dio la vuelta al ring");
+
+    // Trama de la longitud máxima, que además cruza el final del ring
+    f.head = f.tail = f.scan = 3 * LINE_FRAMER_RING_SIZE - 10;
+    memset(line, 'M', LINE_FRAMER_MAX_FRAME);
+    line[LINE_FRAMER_MAX_FRAME] = '\0';
+    push_str(line);
+    push_str("\n");
+    expect_frame(line);
+    CHECK(f.overflows == 0, "overflows=%u", (unsigned)f.overflows);
+}
+
+static void test_overflow(void) {
+    char big[3 * LINE_FRAMER_MAX_FRAME];
+    memset(big, 'x', sizeof(big));
+
+    // Trama demasiado larga que llega entera: se descarta sólo ella
+    line_framer_init(&f, '\n');
+    push_str("OK:1\n");
+    CHECK(line_framer_push(&f, big, LINE_FRAMER_MAX_FRAME + 1) == LINE_FRAMER_MAX_FRAME + 1, "push");
+    push_str("\nOK:2\n");
+    expect_frame("OK:1");
+    expect_frame("OK:2");
+    expect_none();
+    CHECK(f.overflows == 1, "overflows=%u", (unsigned)f.overflows);
+    CHECK(f.dropped_bytes == LINE_FRAMER_MAX_FRAME + 2, "dropped=%u", (unsigned)f.dropped_bytes);
+
+    // Sin terminador: se descarta en cuanto no cabe y se resincroniza en el siguiente
+    line_framer_init(&f, '\n');
+    for (int i = 0; i < 3; i++) {
+        CHECK(line_framer_push(&f, big, sizeof(big)) == sizeof(big), "push %d", i);
+        expect_none();
+    }
+    CHECK(f.overflows == 1, "una sola trama desbordada, overflows=%u", (unsigned)f.overflows);
+    push_str("cola de la trama larga\nOK:3\n");
+    expect_frame("OK:3");
+    expect_none();
+    CHECK(f.dropped_bytes == 3 * sizeof(big) + strlen("cola de la trama larga\n"), "dropped=%u",
+          (unsigned)f.dropped_bytes);
+
+    // Las tramas completas anteriores al desborde no se pierden
+    line_framer_init(&f, '\n');
+    push_str("A:1\nB:2\n");
+    CHECK(line_framer_push(&f, big, LINE_FRAMER_MAX_FRAME + 5) == LINE_FRAMER_MAX_FRAME + 5, "push");
+    expect_frame("A:1");
+    expect_frame("B:2");
+    expect_none();
+    push_str("\nC:3\n");
+    expect_frame("C:3");
+    CHECK(f.overflows == 1, "overflows=%u", (unsigned)f.overflows);
+}
+
+static void test_full(void) {
+    // Sin consumir, el ring acepta LINE_FRAMER_RING_SIZE bytes y ni uno más
+    line_framer_init(&f, '\n');
+    char chunk[512];
+    memset(chunk, 'y', sizeof(chunk));
+    chunk[sizeof(chunk) - 1] = '\n';
+    size_t total = 0;
+    for (int i = 0; i < 2 * LINE_FRAMER_RING_SIZE / (int)sizeof(chunk); i++) {
+        total += line_framer_push(&f, chunk, sizeof(chunk));
+    }
+    CHECK(total == LINE_FRAMER_RING_SIZE, "aceptados %zu", total);
+    char *ptr;
+    CHECK(line_framer_write_ptr(&f, &ptr) == 0, "hueco con el ring lleno");
+    line_frame_t fr;
+    int n = 0;
+    while (line_framer_next(&f, &fr)) {
+        n++;
+    }
+    CHECK(n == LINE_FRAMER_RING_SIZE / (int)sizeof(chunk), "tramas %d", n);
+    CHECK(line_framer_write_ptr(&f, &ptr) > 0, "sin hueco tras consumir");
+}
+
+int main(void) {
+    test_split();
+    test_merged();
+    test_wrap();
+    test_overflow();
+    test_full();
+    printf("%s\n", failures ? "FALLOS" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""render_bench_compare.py - Compara dos capturas de RENDER:BENCH (antes y después)
+
+Uso:
+  python3 render_bench_compare.py antes.log despues.log [--scene SUBCADENA ...]
+
+Toma las líneas "BENCH,..." de cada log (el resto de la consola se ignora) y
+escribe por escena fps, render_us y carga de cada núcleo de las dos capturas y
+la variación en %. Si una escena se midió varias veces se usa la media.
+--scene filtra escenas cuyo nombre contiene la subcadena (p. ej. full, scroll,
+nav). Formato de las líneas: main/render_bench.h.
+"""
+import argparse
+import sys
+
+FIELDS = ('frames', 'fps', 'render_us', 'flush_us', 'cpu0', 'cpu1')
+
+
+def read_bench(path):
+    """Devuelve (configuración, {(perfil, escena): {campo: media}})."""
+    config = []
+    sums = {}
+    with open(path, encoding='utf-8', errors='replace') as src:
+        for line in src:
+            idx = line.find('BENCH,')
+            if idx < 0:
+                continue
+            cols = line[idx:].strip().split(',')
+            if len(cols) == 4 and cols[2] == 'config':
+                config.append('%s %s' % (cols[1], cols[3]))
+                continue
+            if len(cols) != 9 or cols[1] == 'profile':
+                continue
+            try:
+                values = [float(v) for v in cols[3:]]
+            except ValueError:
+                continue
+            entry = sums.setdefault((cols[1], cols[2]), [0] * (len(FIELDS) + 1))
+            for i, v in enumerate(values):
+                entry[i] += v
+            entry[-1] += 1
+    means = {key: {f: e[i] / e[-1] for i, f in enumerate(FIELDS)} for key, e in sums.items()}
+    return config, means
+
+
+def change(before, after):
+    return '%+.1f%%' % ((after - before) * 100.0 / before) if before else '-'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('before')
+    parser.add_argument('after')
+    parser.add_argument('--scene', action='append', default=[])
+    opts = parser.parse_args()
+
+    before_cfg, before = read_bench(opts.before)
+    after_cfg, after = read_bench(opts.after)
+    print('antes:   %s' % (', '.join(sorted(set(before_cfg))) or '?'))
+    print('después: %s' % (', '.join(sorted(set(after_cfg))) or '?'))
+
+    # Se emparejan por escena; si el perfil cambió entre capturas, también se compara
+    by_scene = {scene: (profile, m) for (profile, scene), m in before.items()}
+    rows = []
+    for (profile, scene), a in sorted(after.items(), key=lambda kv: kv[0][1]):
+        if opts.scene and not any(s in scene for s in opts.scene):
+            continue
+        b = before.get((profile, scene)) or by_scene.get(scene, (None, None))[1]
+        if b is None:
+            continue
+        rows.append((scene,
+                     '%.1f' % b['fps'], '%.1f' % a['fps'], change(b['fps'], a['fps']),
+                     '%d' % b['render_us'], '%d' % a['render_us'], change(b['render_us'], a['render_us']),
+                     '%d/%d' % (b['cpu0'], b['cpu1']), '%d/%d' % (a['cpu0'], a['cpu1'])))
+    if not rows:
+        sys.exit('sin escenas en común')
+    header = ('escena', 'fps antes', 'fps desp.', 'Δfps', 'render antes', 'render desp.', 'Δrender',
+              'cpu antes', 'cpu desp.')
+    widths = [max(len(r[i]) for r in rows + [header]) for i in range(len(header))]
+    for row in [header] + rows:
+        print('  '.join(c.rjust(w) if i else c.ljust(w) for i, (c, w) in enumerate(zip(row, widths))))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,319 @@
+// rgb565_kernels_test.c - Pruebas en el PC de los núcleos RGB565 del firmware
+//
+// Compilar:  cc -O2 -Wall -DCONFIG_IDF_TARGET_ESP32S3=1 -I../main -o rgb565_kernels_test
+//               rgb565_kernels_test.c ../main/rgb565_kernels.c
+//
+// Uso:  rgb565_kernels_test
+//
+// Cada núcleo se compara bit a bit con el bucle C de LVGL 9.2 al que sustituye
+// (lv_draw_sw_blend_to_rgb565.c, con lv_color_16_16_mix copiada tal cual), con
+// los vectoriales activados y sin ellos: anchos pares e impares, filas
+// contiguas, strides que no son múltiplo de 16 bytes, punteros desplazados
+// 0..7 píxeles con origen y destino de la misma alineación y de distinta, y
+// opacidades 0, 255, las del borde de LV_OPA_MAX e intermedias. Alrededor de
+// cada zona hay píxeles aleatorios que no deben cambiar. rgb565_memcpy, que
+// sustituye a lv_memcpy, se compara con memcpy.
+//
+// Con -DCONFIG_IDF_TARGET_ESP32S3=1 se compila el camino PIE de
+// rgb565_kernels.c; las dos rutinas de rgb565_kernels_esp32s3.S se sustituyen
+// por un modelo en C que además comprueba su contrato (punteros alineados a 16
+// bytes, al menos un bloque). Las instrucciones PIE en sí sólo se prueban en
+// el equipo (rgb565_kernels_self_test al arrancar).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rgb565_kernels.h"
+
+#define AREA_PIXELS 4096            // Zona de cada prueba, con margen para guardas
+#define GUARD 16                    // Píxeles aleatorios antes de la primera fila
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FALLO %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);            \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+// ---- Modelo de rgb565_kernels_esp32s3.S ----
+
+#if CONFIG_IDF_TARGET_ESP32S3
+static unsigned pie_calls;
+static unsigned pie_contract_errors;
+
+static void pie_check(const void *dest, const void *src, uint32_t blocks) {
+    pie_calls++;
+    if (((uintptr_t)dest & 15) != 0 || ((uintptr_t)src & 15) != 0 || blocks == 0) {
+        pie_contract_errors++;
+    }
+}
+
+void rgb565_pie_fill16(uint16_t *dest, uint32_t blocks, uint32_t pattern) {
+    pie_check(dest, NULL, blocks);
+    for (uint32_t i = 0; i < blocks * 4; i++) {
+        memcpy(dest + 2 * i, &pattern, sizeof(pattern));
+    }
+}
+
+void rgb565_pie_copy16(uint16_t *dest, const uint16_t *src, uint32_t blocks) {
+    pie_check(dest, src, blocks);
+    memcpy(dest, src, blocks * 16);
+}
+#endif
+
+// ---- Referencia: LVGL 9.2 ----
+
+// lv_color_16_16_mix (lv_color.h)
+static uint16_t lv_color_16_16_mix(uint16_t c1, uint16_t c2, uint8_t mix) {
+    if (mix == 255) return c1;
+    if (mix == 0) return c2;
+    if (c1 == c2) return c1;
+
+    uint16_t ret;
+
+    /* Source: https://stackoverflow.com/a/50012418/1999969*/
+    mix = (uint32_t)((uint32_t)mix + 4) >> 3;
+
+    /*0x7E0F81F = 0b00000111111000001111100000011111*/
+    uint32_t bg = (uint32_t)(c2 | ((uint32_t)c2 << 16)) & 0x7E0F81F;
+    uint32_t fg = (uint32_t)(c1 | ((uint32_t)c1 << 16)) & 0x7E0F81F;
+    uint32_t result = ((((fg - bg) * mix) >> 5) + bg) & 0x7E0F81F;
+    ret = (uint16_t)(result >> 16) | result;
+
+    return ret;
+}
+
+#define ROW(p, stride, y) ((uint16_t *)((uint8_t *)(p) + (stride) * (y)))
+
+// lv_draw_sw_blend_color_to_rgb565, sin máscara
+static void lv_fill(uint16_t *dest, int32_t w, int32_t h, int32_t stride, uint16_t color) {
+    for (int32_t y = 0; y < h; y++) {
+        uint16_t *d = ROW(dest, stride, y);
+        for (int32_t x = 0; x < w; x++) {
+            d[x] = color;
+        }
+    }
+}
+
+static void lv_fill_opa(uint16_t *dest, int32_t w, int32_t h, int32_t stride, uint16_t color, uint8_t opa) {
+    uint16_t last_dest_color = color;
+    uint16_t last_res_color = color;
+    for (int32_t y = 0; y < h; y++) {
+        uint16_t *d = ROW(dest, stride, y);
+        for (int32_t x = 0; x < w; x++) {
+            if (d[x] != last_dest_color) {
+                last_dest_color = d[x];
+                last_res_color = lv_color_16_16_mix(color, d[x], opa);
+            }
+            d[x] = last_res_color;
+        }
+    }
+}
+
+// rgb565_image_blend, sin máscara y con LV_BLEND_MODE_NORMAL
+static void lv_copy(uint16_t *dest, int32_t dest_stride, const uint16_t *src, int32_t src_stride, int32_t w,
+                    int32_t h) {
+    for (int32_t y = 0; y < h; y++) {
+        memcpy(ROW(dest, dest_stride, y), ROW(src, src_stride, y), (size_t)w * 2);
+    }
+}
+
+static void lv_blend(uint16_t *dest, int32_t dest_stride, const uint16_t *src, int32_t src_stride, int32_t w,
+                     int32_t h, uint8_t opa) {
+    for (int32_t y = 0; y < h; y++) {
+        uint16_t *d = ROW(dest, dest_stride, y);
+        const uint16_t *s = ROW(src, src_stride, y);
+        for (int32_t x = 0; x < w; x++) {
+            d[x] = lv_color_16_16_mix(s[x], d[x], opa);
+        }
+    }
+}
+
+// ---- Pruebas ----
+
+static uint16_t src_buf[AREA_PIXELS] __attribute__((aligned(16)));
+static uint16_t ref_buf[AREA_PIXELS] __attribute__((aligned(16)));
+static uint16_t out_buf[AREA_PIXELS] __attribute__((aligned(16)));
+
+static uint32_t rng = 0x9E3779B9;
+
+static uint16_t random_pixel(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (uint16_t)rng;
+}
+
+// few_colors: fondo casi uniforme, como el de una pantalla real
+static void randomize(uint16_t *p, bool few_colors) {
+    for (size_t i = 0; i < AREA_PIXELS; i++) {
+        p[i] = few_colors ? (uint16_t)(0x3A6C * (random_pixel() % 3)) : random_pixel();
+    }
+}
+
+static const char *const kernel_names[] = { "fill", "fill_opa", "copy", "blend" };
+
+// Un caso: destino y origen desplazados d_off y s_off píxeles, strides en bytes
+static void check_case(unsigned kernel, int32_t w, int32_t h, int32_t d_stride, int32_t s_stride, int32_t d_off,
+                       int32_t s_off, uint8_t opa) {
+    uint16_t color = random_pixel();
+    randomize(src_buf, false);
+    randomize(ref_buf, (w & 1) != 0);
+    // A veces el origen coincide con el fondo: la mezcla no toca esos píxeles
+    if ((w % 3) == 0) {
+        memcpy(src_buf, ref_buf, sizeof(src_buf));
+        for (size_t i = 0; i < AREA_PIXELS; i += 5) {
+            src_buf[i] = random_pixel();
+        }
+    }
+    memcpy(out_buf, ref_buf, sizeof(out_buf));
+
+    uint16_t *ref = ref_buf + GUARD + d_off, *out = out_buf + GUARD + d_off;
+    const uint16_t *src = src_buf + GUARD + s_off;
+    switch (kernel) {
+    case 0:
+        lv_fill(ref, w, h, d_stride, color);
+        rgb565_fill(out, w, h, d_stride, color);
+        break;
+    case 1:
+        lv_fill_opa(ref, w, h, d_stride, color, opa);
+        rgb565_fill_opa(out, w, h, d_stride, color, opa);
+        break;
+    case 2:
+        lv_copy(ref, d_stride, src, s_stride, w, h);
+        rgb565_copy(out, d_stride, src, s_stride, w, h);
+        break;
+    default:
+        lv_blend(ref, d_stride, src, s_stride, w, h, opa);
+        rgb565_blend(out, d_stride, src, s_stride, w, h, opa);
+        break;
+    }
+
+    for (size_t i = 0; i < AREA_PIXELS; i++) {
+        if (ref_buf[i] != out_buf[i]) {
+            long at = (long)i - GUARD - d_off;
+            CHECK(0, "%s simd=%d w=%ld h=%ld strides=%ld/%ld offs=%ld/%ld opa=%u: píxel %ld (fila %ld) 0x%04X, LVGL 0x%04X",
+                  kernel_names[kernel], rgb565_kernels_simd(), (long)w, (long)h, (long)d_stride, (long)s_stride,
+                  (long)d_off, (long)s_off, opa, at, at / (d_stride / 2), out_buf[i], ref_buf[i]);
+            return;
+        }
+    }
+}
+
+static const uint8_t opas[] = { 0, 1, 7, 8, 127, 128, 200, 252, 253, 254, 255 };
+
+// Anchos cortos uno a uno y algunos largos (pares e impares), con varias
+// alturas; filas contiguas y con relleno de 1..9 píxeles
+static void test_kernels(void) {
+    static const int32_t long_widths[] = { 63, 64, 65, 127, 128, 255, 479, 480, 799, 800 };
+    int32_t widths[40 + sizeof(long_widths) / sizeof(long_widths[0])];
+    int n = 0;
+    for (int32_t w = 1; w <= 40; w++) {
+        widths[n++] = w;
+    }
+    for (size_t i = 0; i < sizeof(long_widths) / sizeof(long_widths[0]); i++) {
+        widths[n++] = long_widths[i];
+    }
+
+    for (int i = 0; i < n; i++) {
+        int32_t w = widths[i];
+        for (int32_t h = 1; h <= 3; h++) {
+            for (int32_t pad = 0; pad <= 9; pad += pad < 2 ? 1 : 7) {
+                int32_t d_stride = (w + pad) * 2;
+                int32_t s_stride = (w + (pad + 3) % 10) * 2;
+                if ((size_t)(GUARD + 8 + (w + 9) * (h + 1)) > AREA_PIXELS) {
+                    continue;
+                }
+                for (int32_t off = 0; off < 8; off++) {
+                    int32_t s_offs[2] = { off, (off + 1 + w) % 8 };
+                    for (int k = 0; k < 4; k++) {
+                        for (int a = 0; a < 2; a++) {
+                            // La copia y el relleno sólido no dependen de la opacidad
+                            uint8_t opa = (k == 0 || k == 2) ? 255
+                                                             : opas[(size_t)(i + h + off + a) % sizeof(opas)];
+                            check_case((unsigned)k, w, h, d_stride, s_stride, off, s_offs[a], opa);
+                            // Filas contiguas (un solo tramo)
+                            if (pad == 0 && h > 1) {
+                                check_case((unsigned)k, w, h, w * 2, w * 2, off, s_offs[a], opa);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Todas las opacidades sobre un ancho impar y desalineado
+static void test_all_opas(void) {
+    for (int opa = 0; opa <= 255; opa++) {
+        check_case(1, 37, 3, 45 * 2, 41 * 2, 3, 3, (uint8_t)opa);
+        check_case(3, 37, 3, 45 * 2, 41 * 2, 3, 3, (uint8_t)opa);
+        check_case(3, 37, 3, 45 * 2, 41 * 2, 3, 6, (uint8_t)opa);
+    }
+}
+
+// rgb565_mix frente a lv_color_16_16_mix en un barrido de colores
+static void test_mix(void) {
+    unsigned bad = 0;
+    for (uint32_t fg = 0; fg < 65536; fg += 7) {
+        for (uint32_t bg = 0; bg < 65536; bg += 251) {
+            for (int opa = 0; opa <= 255; opa += 3) {
+                bad += rgb565_mix((uint16_t)fg, (uint16_t)bg, (uint8_t)opa) !=
+                       lv_color_16_16_mix((uint16_t)fg, (uint16_t)bg, (uint8_t)opa);
+            }
+        }
+    }
+    CHECK(bad == 0, "rgb565_mix distinta de LVGL en %u casos", bad);
+}
+
+// rgb565_memcpy (el lv_memcpy de LVGL) frente a memcpy: longitudes y punteros
+// pares e impares, con y sin la misma alineación módulo 16
+static void test_memcpy(void) {
+    uint8_t *src = (uint8_t *)src_buf, *ref = (uint8_t *)ref_buf, *out = (uint8_t *)out_buf;
+    for (size_t len = 0; len <= 1700; len += len < 80 ? 1 : 37) {
+        for (size_t d_off = 0; d_off < 16; d_off++) {
+            for (size_t s_off = d_off % 3; s_off < 16; s_off += 5) {
+                randomize(src_buf, false);
+                randomize(ref_buf, false);
+                memcpy(out, ref, sizeof(out_buf));
+                memcpy(ref + 32 + d_off, src + 32 + s_off, len);
+                void *ret = rgb565_memcpy(out + 32 + d_off, src + 32 + s_off, len);
+                CHECK(ret == out + 32 + d_off && memcmp(ref, out, sizeof(out_buf)) == 0,
+                      "memcpy simd=%d len=%zu offs=%zu/%zu", rgb565_kernels_simd(), len, d_off, s_off);
+            }
+        }
+    }
+}
+
+// El autotest del arranque también pasa (y con los núcleos rotos fallaría)
+static void test_self_test(void) {
+    static uint16_t scratch[RGB565_SELF_TEST_PIXELS + 1] __attribute__((aligned(16)));
+    CHECK(rgb565_kernels_self_test(scratch, RGB565_SELF_TEST_PIXELS) == 0, "autotest alineado");
+    CHECK(rgb565_kernels_self_test(scratch + 1, RGB565_SELF_TEST_PIXELS) == 0, "autotest desalineado");
+}
+
+int main(void) {
+    test_mix();
+    for (int simd = 0; simd < 2; simd++) {
+        rgb565_kernels_set_simd(simd != 0);
+        if (simd && !rgb565_kernels_simd()) {
+            printf("Sin camino PIE (compilar con -DCONFIG_IDF_TARGET_ESP32S3=1)\n");
+            break;
+        }
+        test_kernels();
+        test_all_opas();
+        test_memcpy();
+        test_self_test();
+    }
+#if CONFIG_IDF_TARGET_ESP32S3
+    CHECK(pie_calls > 0, "no se usó el camino PIE");
+    CHECK(pie_contract_errors == 0, "%u llamadas PIE con punteros desalineados o sin bloques", pie_contract_errors);
+#endif
+    printf("%s\n", failures ? "FALLOS" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+// telemetry_store_test.c - Pruebas en el PC del telemetry_store del firmware
+//
+// Compilar:
+//   cc -O2 -Wall -pthread -Ihost -I../main -o telemetry_store_test telemetry_store_test.c
+//      host/host_shim.c ../main/telemetry_store.c ../main/data_parser.c ../main/data_stream.c
+//      ../main/telemetry_proto.c ../main/trend_buffer.c ../main/alarms.c ../main/ui_format.c
+//
+// Uso:  telemetry_store_test
+//
+// Las tramas entran por los handlers reales (los que telemetry_store_init
+// registra en uart_register_handler) y el refresco del display es el hook que
+// registra en ui_update; los flancos que llegarían al registro de alarmas en
+// flash se anotan aquí. Un único proceso: las pruebas van en orden y cada una
+// parte del estado que deja la anterior.
+#include <stdio.h>
+#include <string.h>
+#include "telemetry_store.h"
+#include "uart_utils.h"
+#include "uart_tx.h"
+#include "ui_update.h"
+#include "alarm_log.h"
+#include "trace.h"
+
+static int failures;
+
+#define CHECK(cond, ...)                    \
+    do {                                    \
+        if (!(cond)) {                      \
+            printf("FALLO %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);            \
+            printf("\n");                   \
+            failures++;                     \
+        }                                   \
+    } while (0)
+
+// ---- Lo que aportan uart_utils.c, uart_tx.c, ui_update.c y alarm_log.c ----
+
+#define MAX_HANDLERS 8
+
+static struct {
+    const char *prefix;
+    uart_data_handler_t handler;
+} handlers[MAX_HANDLERS];
+static int handler_count;
+static ui_update_hook_t refresh_hook;
+static uint32_t raised, cleared;     // Flancos entregados al registro de alarmas
+
+bool uart_register_handler(const char *prefix, uart_data_handler_t handler) {
+    handlers[handler_count].prefix = prefix;
+    handlers[handler_count++].handler = handler;
+    return true;
+}
+
+bool uart_register_bin_handler(tp_msg_type_t type, uart_bin_handler_t handler) {
+    (void)type;
+    (void)handler;
+    return true;
+}
+
+bool uart_tx_send(const char *command, uint32_t flags) {
+    (void)command;
+    (void)flags;
+    return true;
+}
+
+bool ui_update_register(ui_update_hook_t hook) {
+    refresh_hook = hook;
+    return true;
+}
+
+void alarm_log_record_changes(const alarm_set_t *before, const alarm_set_t *after) {
+    for (int i = 0; i < ALARM_WORDS; i++) {
+        raised += (uint32_t)__builtin_popcount(~before->words[i] & after->words[i]);
+        cleared += (uint32_t)__builtin_popcount(before->words[i] & ~after->words[i]);
+    }
+}
+
+void trace_record(trace_event_t id, int32_t a0, int32_t a1, int32_t a2) {
+    (void)id;
+    (void)a0;
+    (void)a1;
+    (void)a2;
+}
+
+// Entrega la trama al handler de su prefijo, como dispatch_frame
+static void feed(const char *frame) {
+    size_t len = strcspn(frame, ":");
+    for (int i = 0; i < handler_count; i++) {
+        if (strlen(handlers[i].prefix) == len && strncmp(frame, handlers[i].prefix, len) == 0) {
+            handlers[i].handler(frame);
+            return;
+        }
+    }
+    CHECK(0, "sin handler para \"%s\"", frame);
+}
+
+static uint32_t notifications(telemetry_subject_t subject) {
+    return telemetry_store_subject(subject)->notifications;
+}
+
+// ---- Pruebas ----
+
+// Primera trama con T1, T2 y VOL a 0: los subjects ya valen 0, pero los
+// observadores tienen que enterarse para quitar el "--"
+static void test_first_refresh(void) {
+    CHECK(!telemetry_store_has_data(), "datos antes de la primera trama");
+    feed("DATA:T1=0.00;T2=0.00;VOL=0;ERR=0x00;");
+    CHECK(refresh_hook(), "el primer refresco no hizo nada");
+    for (int i = 0; i < TELEMETRY_SUBJECT_COUNT; i++) {
+        CHECK(notifications(i) == 1, "subject %d notificado %u veces", i, (unsigned)notifications(i));
+    }
+
+    // Después, sólo lo que cambia
+    feed("DATA:T1=0.00;T2=0.00;VOL=0;ERR=0x00;");
+    refresh_hook();
+    feed("DATA:T1=21.50;T2=0.00;VOL=0;ERR=0x00;");
+    refresh_hook();
+    CHECK(notifications(TELEMETRY_SUBJECT_T1) == 2, "T1 notificado %u veces",
+          (unsigned)notifications(TELEMETRY_SUBJECT_T1));
+    CHECK(notifications(TELEMETRY_SUBJECT_VOL) == 1, "VOL notificado %u veces",
+          (unsigned)notifications(TELEMETRY_SUBJECT_VOL));
+    CHECK(lv_subject_get_int(telemetry_store_subject(TELEMETRY_SUBJECT_T1)) == 2150, "T1=%ld",
+          (long)lv_subject_get_int(telemetry_store_subject(TELEMETRY_SUBJECT_T1)));
+}
+
+static bool alarm_bit(int bit) {
+    alarm_set_t alarms;
+    telemetry_store_read_alarms(&alarms);
+    return (alarms.words[bit / 32] >> (bit % 32)) & 1;
+}
+
+// Una ALM que levanta una alarma 0..7 no se deshace con la siguiente trama de
+// telemetría, aunque ésta no traiga ERR o traiga el ERR de antes de la ALM
+static void test_alarms_then_delta(void) {
+    feed("DATA:T1=20.00;T2=20.00;VOL=10;ERR=0x00;SEQ=100;");
+    refresh_hook();
+    uint32_t raised0 = raised, cleared0 = cleared;
+
+    feed("ALM:0x8;");
+    CHECK(alarm_bit(3), "ALM no levantó la alarma 3");
+    feed("DLT:101;1=20.50;");
+    refresh_hook();
+    CHECK(alarm_bit(3), "el DLT de T1 borró la alarma 3");
+    tp_data_t data;
+    telemetry_store_read(&data);
+    CHECK(data.errors == 0x08 && data.t1_centi == 2050, "ERR=0x%02X T1=%ld", data.errors, (long)data.t1_centi);
+    CHECK(raised == raised0 + 1 && cleared == cleared0, "flancos: +%u levantados, +%u borrados",
+          (unsigned)(raised - raised0), (unsigned)(cleared - cleared0));
+
+    // Un cambio real de ERR en la telemetría sí manda
+    feed("DLT:102;4=0x00;");
+    CHECK(!alarm_bit(3), "ERR=0x00 no borró la alarma 3");
+    CHECK(cleared == cleared0 + 1, "flancos borrados +%u", (unsigned)(cleared - cleared0));
+}
+
+// La última muestra del datalog sólo se muestra: su ERR no entra en el mapa de
+// alarmas, así que la primera trama real no registra flancos contra ella
+static void test_restore(void) {
+    CHECK(!alarm_bit(2), "alarma 2 activa antes de restaurar");
+    uint32_t raised0 = raised, cleared0 = cleared;
+
+    const tp_data_t last = { .t1_centi = 1800, .t2_centi = 1900, .vol_ml = 5, .errors = 0x04 };
+    telemetry_store_restore(&last);
+    tp_data_t data;
+    telemetry_store_read(&data);
+    CHECK(data.errors == 0x04 && data.t1_centi == 1800, "restaurado ERR=0x%02X T1=%ld", data.errors,
+          (long)data.t1_centi);
+    CHECK(!alarm_bit(2), "la muestra restaurada levantó la alarma 2");
+
+    // La alarma se borró justo antes de apagar: no hay un segundo CLEAR
+    feed("DATA:T1=18.00;T2=19.00;VOL=5;ERR=0x00;SEQ=200;");
+    CHECK(raised == raised0 && cleared == cleared0, "flancos: +%u levantados, +%u borrados",
+          (unsigned)(raised - raised0), (unsigned)(cleared - cleared0));
+    feed("DLT:201;4=0x04;");
+    CHECK(alarm_bit(2) && raised == raised0 + 1, "alarma 2 %d, +%u levantados", alarm_bit(2),
+          (unsigned)(raised - raised0));
+}
+
+int main(void) {
+    telemetry_store_init();
+    CHECK(refresh_hook != NULL, "telemetry_store_init no registró el hook de refresco");
+    if (refresh_hook == NULL) {
+        printf("FALLOS\n");
+        return 1;
+    }
+
+    test_first_refresh();
+    test_alarms_then_delta();
+    test_restore();
+    printf("%s\n", failures ? "FALLOS" : "OK");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,102 @@
+// tp_encode.c - Codificador/decodificador de PC para el protocolo binario de telemetría
+//
+// Compilar:  cc -O2 -I../main -o tp_encode tp_encode.c ../main/telemetry_proto.c -lm
+//
+// Uso:
+//   tp_encode data <t1> <t2> <vol> <err>        > trama   (t1/t2 en °C, err en hex)
+//   tp_encode settings <p1> ... <p8> <chk>      > trama
+//   tp_encode text "<línea ASCII>"              > trama
+//   tp_encode decode                            < tramas  (imprime una línea por trama)
+//
+// Con un puerto serie:  ./tp_encode data 23.5 24.1 150 0x00 > /dev/ttyUSB0
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "telemetry_proto.h"
+
+static int16_t to_centi(const char *s) {
+    return (int16_t)lround(strtod(s, NULL) * 100.0);
+}
+
+static int decode_stream(void) {
+    uint8_t frame[TP_MAX_ENCODED];
+    uint8_t work[TP_MAX_RAW + 1];
+    size_t len = 0;
+    int c;
+
+    while ((c = getchar()) != EOF) {
+        if (c != TP_FRAME_DELIMITER) {
+            if (len < sizeof(frame)) {
+                frame[len] = (uint8_t)c;
+            }
+            len++;
+            continue;
+        }
+        if (len == 0) {
+            continue;
+        }
+        tp_msg_t msg;
+        tp_result_t res = len <= sizeof(frame) ? tp_decode(frame, len, work, &msg) : TP_ERR_LENGTH;
+        len = 0;
+        if (res != TP_OK) {
+            printf("ERROR:%s\n", tp_result_str(res));
+            continue;
+        }
+        switch (msg.type) {
+        case TP_MSG_TEXT:
+            printf("TEXT:%s\n", msg.text.str);
+            break;
+        case TP_MSG_DATA:
+            printf("DATA:T1=%.2f;T2=%.2f;VOL=%ld;ERR=0x%02X;\n", msg.data.t1_centi / 100.0,
+                   msg.data.t2_centi / 100.0, (long)msg.data.vol_ml, msg.data.errors);
+            break;
+        case TP_MSG_SETTINGS:
+            printf("SETTINGS:");
+            for (int i = 0; i < TP_SETTINGS_PARAMS; i++) {
+                printf("P%d=%d;", i + 1, msg.settings.params[i]);
+            }
+            printf("CHK=%d;\n", msg.settings.chk ? 1 : 0);
+            break;
+        default:
+            break;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint8_t out[TP_MAX_ENCODED];
+    size_t n = 0;
+
+    if (argc >= 2 && strcmp(argv[1], "decode") == 0) {
+        return decode_stream();
+    } else if (argc == 6 && strcmp(argv[1], "data") == 0) {
+        tp_data_t data = {
+            .t1_centi = to_centi(argv[2]),
+            .t2_centi = to_centi(argv[3]),
+            .vol_ml = (int32_t)strtol(argv[4], NULL, 10),
+            .errors = (uint8_t)strtoul(argv[5], NULL, 16),
+        };
+        n = tp_encode_data(&data, out, sizeof(out));
+    } else if (argc == 3 + TP_SETTINGS_PARAMS && strcmp(argv[1], "settings") == 0) {
+        tp_settings_t settings;
+        for (int i = 0; i < TP_SETTINGS_PARAMS; i++) {
+            settings.params[i] = (int16_t)strtol(argv[2 + i], NULL, 10);
+        }
+        settings.chk = strtol(argv[2 + TP_SETTINGS_PARAMS], NULL, 10) != 0;
+        n = tp_encode_settings(&settings, out, sizeof(out));
+    } else if (argc == 3 && strcmp(argv[1], "text") == 0) {
+        n = tp_encode_text(argv[2], out, sizeof(out));
+    } else {
+        fprintf(stderr, "uso: %s data|settings|text|decode ...\n", argv[0]);
+        return 2;
+    }
+
+    if (n == 0) {
+        fprintf(stderr, "no se pudo codificar el mensaje\n");
+        return 1;
+    }
+    fwrite(out, 1, n, stdout);
+    return 0;
+}
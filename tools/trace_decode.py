@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""trace_decode.py - Formatea en el PC un volcado TRACE:RAW del firmware
+
+Uso:
+  python3 trace_decode.py [--events ../main/trace_events.h] [log]   (log o stdin)
+
+Se lee la tabla de eventos del propio firmware (trace_events.h), así que el
+decodificador no se desincroniza mientras se añadan eventos sólo al final.
+Las líneas que no empiezan por "TR " (logs normales de la consola) se ignoran.
+"""
+import argparse
+import os
+import re
+import sys
+
+EVENT_RE = re.compile(r'^\s*TRACE_EVENT\(\s*(\w+)\s*,\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+
+
+def load_events(path):
+    events = []
+    with open(path, encoding='utf-8') as f:
+        for line in f:
+            m = EVENT_RE.match(line)
+            if m:
+                # %ld -> %d: los argumentos ya son enteros de Python
+                events.append((m.group(1), m.group(3).replace('%l', '%')))
+    return events
+
+
+def to_int32(word):
+    value = int(word, 16)
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def format_record(fields, events):
+    seq, ts, ev, core = int(fields[0], 16), int(fields[1], 16), int(fields[2], 16), int(fields[3], 16)
+    args = tuple(to_int32(w) for w in fields[4:7])
+    if ev >= len(events):
+        return '%10d c%d <evento %d> %d %d %d' % ((ts, core, ev) + args)
+    name, fmt = events[ev]
+    # El formato puede usar menos de tres argumentos
+    used = len(re.findall(r'%[-+ #0-9.]*[diuxXs]', fmt))
+    return '%10d c%d %-14s %s' % (ts, core, name, fmt % args[:used])
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('--events', default=os.path.join(here, '..', 'main', 'trace_events.h'))
+    parser.add_argument('log', nargs='?')
+    opts = parser.parse_args()
+
+    events = load_events(opts.events)
+    src = open(opts.log, encoding='utf-8', errors='replace') if opts.log else sys.stdin
+    prev_ts = None
+    for line in src:
+        idx = line.find('TR ')
+        if idx < 0:
+            continue
+        fields = line[idx + 3:].split()
+        if len(fields) < 7:
+            continue
+        ts = int(fields[1], 16)
+        delta = '' if prev_ts is None else ' (+%d us)' % ((ts - prev_ts) & 0xffffffff)
+        prev_ts = ts
+        print(format_record(fields, events) + delta)
+
+
+if __name__ == '__main__':
+    main()
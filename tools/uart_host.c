@@ -0,0 +1,212 @@
+// uart_host.c - Capa UART del firmware compilada para Linux sobre un PTY
+//
+// Enlaza los fuentes reales del camino RX/TX (uart_utils.c con su negociación,
+// framer, colas y despacho; uart_tx.c; los handlers DATA/DLT/ALM de
+// telemetry_store.c y los SETTINGS de settings_rx.c) contra tools/host/, que
+// simula FreeRTOS y el driver UART con hilos y el descriptor del PTY. Aquí sólo
+// queda lo que en el firmware pone el resto del sistema: el refresco del display
+// que recoge los cambios y el registro de alarmas.
+//
+// Cada trama de telemetría despachada con VOL se contesta con "ECHO:<VOL>"
+// (leído del telemetry_store) para que controller_sim.py mida la latencia de
+// extremo a extremo; al recibir "BYE" se devuelven las estadísticas en "STATS:".
+//
+// Compilar:
+//   cc -O2 -pthread -Ihost -I../main -o uart_host uart_host.c host/host_shim.c
+//      ../main/uart_utils.c ../main/uart_tx.c ../main/line_framer.c ../main/frame_queue.c
+//      ../main/telemetry_proto.c ../main/data_parser.c ../main/data_stream.c
+//      ../main/telemetry_store.c ../main/trend_buffer.c ../main/alarms.c ../main/ui_format.c
+//      ../main/kv_parser.c ../main/settings_rx.c
+//
+// Uso:  uart_host <pty> [-v]   (normalmente lo lanza controller_sim.py --run;
+//       -v muestra el log INFO del firmware)
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "host_shim.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "uart_config.h"
+#include "uart_utils.h"
+#include "uart_tx.h"
+#include "telemetry_store.h"
+#include "settings_rx.h"
+#include "ui_update.h"
+#include "alarm_log.h"
+#include "trace.h"
+
+#define COMMAND_PERIOD_MS 1000    // Cadencia de GET_SETTINGS*/CMD:STA01* hacia el simulador
+#define REFRESH_PERIOD_MS 16      // "Display" que ejecuta los hooks de ui_update
+#define MAX_UI_HOOKS 4
+
+static atomic_bool bye;
+
+static struct {
+    uint32_t data_applied;
+    uint32_t data_bad;
+    uint32_t settings_updates;
+    uint32_t alarm_edges;
+    uint32_t echoes;
+} stats;
+
+// ---- Lo que en el firmware aportan otros módulos ----
+
+// Trazas del firmware: aquí sólo se observan para contestar el ECHO cuando el
+// despacho de una trama con VOL termina (DATA_APPLIED y luego DISPATCH, en la
+// tarea parser)
+static bool echo_pending;
+
+void trace_record(trace_event_t id, int32_t a0, int32_t a1, int32_t a2) {
+    (void)a0;
+    (void)a2;
+    switch (id) {
+    case TRACE_EV_DATA_APPLIED:
+        stats.data_applied++;
+        echo_pending = (a1 & TP_FIELD_VOL) != 0;
+        break;
+    case TRACE_EV_DATA_BAD:
+        stats.data_bad++;
+        break;
+    case TRACE_EV_DISPATCH:
+    case TRACE_EV_DISPATCH_BIN:
+        if (echo_pending) {
+            tp_data_t data;
+            char line[32];
+            echo_pending = false;
+            telemetry_store_read(&data);
+            int len = snprintf(line, sizeof(line), "ECHO:%ld\n", (long)data.vol_ml);
+            uart_write_bytes(UART_PORT_NUM, line, len);
+            stats.echoes++;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// ui_update.c necesita LVGL: los hooks se ejecutan desde el bucle principal
+static ui_update_hook_t ui_hooks[MAX_UI_HOOKS];
+static int ui_hook_count;
+
+bool ui_update_register(ui_update_hook_t hook) {
+    if (ui_hook_count == MAX_UI_HOOKS) {
+        return false;
+    }
+    ui_hooks[ui_hook_count++] = hook;
+    return true;
+}
+
+// alarm_log.c escribe en flash: aquí sólo se cuentan los flancos
+void alarm_log_record_changes(const alarm_set_t *before, const alarm_set_t *after) {
+    for (int i = 0; i < ALARM_WORDS; i++) {
+        stats.alarm_edges += (uint32_t)__builtin_popcount(before->words[i] ^ after->words[i]);
+    }
+}
+
+// El simulador pide las estadísticas antes de cerrar
+static void bye_handler(const char *data) {
+    (void)data;
+    atomic_store(&bye, true);
+}
+
+// Lo que hace el refresco del display: hooks de la UI y ajustes recibidos
+static void refresh_display(void) {
+    for (int i = 0; i < ui_hook_count; i++) {
+        ui_hooks[i]();
+    }
+    settings_data_t settings;
+    if (settings_rx_take(&settings)) {
+        stats.settings_updates++;
+    }
+}
+
+static void print_stats(FILE *out) {
+    uart_rx_stats_t rx;
+    uart_tx_stats_t tx;
+    uart_queue_stats_t telemetry, control;
+    uart_link_stats_t link;
+    data_stream_stats_t stream;
+    uart_get_rx_stats(&rx);
+    uart_tx_get_stats(&tx);
+    uart_get_queue_stats(&telemetry, &control);
+    uart_get_link_stats(&link);
+    telemetry_store_get_stream_stats(&stream);
+
+    uint32_t avg = rx.frames ? (uint32_t)(rx.latency_total_us / rx.frames) : 0;
+    fprintf(out,
+            "STATS:bytes=%u;frames=%u;data=%u;data_bad=%u;settings=%u;echoes=%u;alarm_edges=%u;"
+            "decode_errors=%u;framer_overflows=%u;dropped_bytes=%u;telemetry_dropped=%u;"
+            "telemetry_high_water=%u;control_high_water=%u;queue_stalls=%u;"
+            "dispatch_avg_us=%u;dispatch_max_us=%u;binary=%d;sequenced=%d;baud=%u;negotiations=%u;"
+            "tx_sent=%u;tx_acked=%u;tx_naked=%u;tx_failed=%u;tx_retries=%u;"
+            "keyframes=%u;deltas=%u;gaps=%u;stale=%u;keyframe_requests=%u;bytes_saved=%u\n",
+            rx.bytes, rx.frames, stats.data_applied, stats.data_bad, stats.settings_updates, stats.echoes,
+            stats.alarm_edges, rx.decode_errors, rx.framer_overflows, host_uart_dropped(UART_PORT_NUM),
+            telemetry.dropped, telemetry.high_water, control.high_water, rx.queue_stalls, avg,
+            rx.latency_max_us, uart_utils_binary_mode(), link.sequenced, link.baud, link.negotiations, tx.sent, tx.acked,
+            tx.naked, tx.failed, tx.retries, stream.keyframes, stream.deltas, stream.gaps, stream.stale,
+            stream.keyframe_requests, stream.bytes_saved);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "uso: %s <pty> [-v]\n", argv[0]);
+        return 2;
+    }
+    if (argc > 2 && strcmp(argv[2], "-v") == 0) {
+        host_log_level = ESP_LOG_INFO;
+    }
+
+    int fd = open(argv[1], O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    host_uart_attach(UART_PORT_NUM, fd);
+
+    // Mismo orden que app_main
+    if (!uart_utils_init() || !uart_tx_init()) {
+        return 1;
+    }
+    telemetry_store_init();
+    settings_rx_init();
+    uart_register_handler("BYE", bye_handler);
+
+    TaskHandle_t parser;
+    xTaskCreate(uart_parser_task, "uart_parser", 4096, NULL, 5, &parser);
+    xTaskCreate(uart_receive_task, "uart_rx", 4096, parser, 6, NULL);
+    xTaskCreate(uart_tx_task, "uart_tx", 4096, NULL, 4, NULL);
+
+    int64_t next_command = esp_timer_get_time();
+    bool toggle = false;
+    while (!atomic_load(&bye) && host_uart_alive(UART_PORT_NUM)) {
+        vTaskDelay(pdMS_TO_TICKS(REFRESH_PERIOD_MS));
+        refresh_display();
+        int64_t now = esp_timer_get_time();
+        if (now >= next_command) {
+            // Igual que la pantalla principal y la de ajustes
+            uart_tx_send(toggle ? "CMD:STA01*" : "GET_SETTINGS*", UART_TX_FLAG_IDEMPOTENT);
+            toggle = !toggle;
+            next_command = now + COMMAND_PERIOD_MS * 1000LL;
+        }
+    }
+
+    char line[1024];
+    FILE *mem = fmemopen(line, sizeof(line), "w");
+    print_stats(mem);
+    fclose(mem);
+    uart_write_bytes(UART_PORT_NUM, line, strlen(line));
+    print_stats(stderr);
+    close(fd);
+    return 0;
+}